@@ -1,37 +1,44 @@
 // PhantomComp.cpp
 // A simple real-time compressor using JACK
 //
+// The channel count is given on the command line (default 1, up to 8), so one
+// instance can compress a whole stereo, 5.1 or 7.1 bus. Per-channel detector
+// state is kept in contiguous arrays and the inner loop runs across channels.
+// With the detector linked, all channels share one envelope driven by the
+// loudest channel, so the stereo/surround image does not shift under gain reduction.
+//
 // Compile with:
 // g++ -std=c++11 PhantomComp.cpp -ljack -lpthread -o PhantomComp
 //
+// Usage:
+// ./PhantomComp [channels]
+//
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <vector>
 #include <atomic>
-#include <thread>
 #include <mutex>
-#include <chrono>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
 
 // Utility: Convert decibels to a linear scale.
 float dBToLinear(float dB) {
     return pow(10.0f, dB / 20.0f);
 }
 
-class PhantomComp {
-private:
-    jack_client_t* client;
-    jack_port_t* input_port;
-    jack_port_t* output_port;
-    int sample_rate;
+class PhantomComp : public phantom::Plugin {
+public:
+    static const int MAX_CHANNELS = 8;
 
-    // Real-time running flag and control thread.
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
+private:
+    int num_channels;
+    std::vector<jack_port_t*> input_ports;
+    std::vector<jack_port_t*> output_ports;
 
     // Compressor parameters (with default values)
     // threshold is in dB (e.g., -20 dB means signals above 0.1 in linear domain)
@@ -40,157 +47,144 @@ private:
     std::atomic<float> attack;       // Attack time in milliseconds (default: 10 ms)
     std::atomic<float> release;      // Release time in milliseconds (default: 100 ms)
     std::atomic<float> makeup_gain;  // Linear gain applied after compression (default: 1.0)
-
-    // The envelope detector state.
-    float envelope;
-
-    // JACK process callback: applies compression sample-by-sample.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomComp* comp = static_cast<PhantomComp*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(comp->input_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(comp->output_port, nframes));
+    std::atomic<bool> linked;        // Share one detector across all channels (default: on)
+
+    // Per-channel envelope detector state, one contiguous slot per channel.
+    std::vector<float> envelope;
+    // Port buffers for the current block, fetched once per callback.
+    std::vector<float*> in_bufs;
+    std::vector<float*> out_bufs;
+
+    // JACK process callback: applies compression sample-by-sample across all channels.
+    int process(jack_nframes_t nframes) override {
+        const int nch = num_channels;
+        float** in = in_bufs.data();
+        float** out = out_bufs.data();
+        for (int c = 0; c < nch; c++) {
+            in[c] = audioBuffer(input_ports[c], nframes);
+            out[c] = audioBuffer(output_ports[c], nframes);
+        }
 
         // Compute smoothing coefficients from attack/release times.
         // Using the formula: coeff = exp(-1/(time_constant * sample_rate))
         // Multiply time_constant in seconds by sample_rate.
-        float attack_coeff = expf(-1000.0f / (comp->sample_rate * comp->attack.load()));
-        float release_coeff = expf(-1000.0f / (comp->sample_rate * comp->release.load()));
+        float attack_coeff = expf(-1000.0f / (sample_rate * attack.load()));
+        float release_coeff = expf(-1000.0f / (sample_rate * release.load()));
         // Convert threshold from dB to linear.
-        float thresh_linear = dBToLinear(comp->threshold.load());
+        float thresh_linear = dBToLinear(threshold.load());
+        // The desired gain reduction is such that the output level is compressed by the ratio.
+        // One common formulation is: gain = (over)^(1/ratio - 1)
+        float exponent = (1.0f / ratio.load()) - 1.0f;
+        float makeup = makeup_gain.load();
+        bool link = linked.load();
+        float* env = envelope.data();
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
-            float input = in[i];
-            float abs_input = fabs(input);
-
-            // Update the envelope detector:
-            if (abs_input > comp->envelope)
-                comp->envelope = attack_coeff * comp->envelope + (1 - attack_coeff) * abs_input;
-            else
-                comp->envelope = release_coeff * comp->envelope + (1 - release_coeff) * abs_input;
-
-            // Compute gain reduction.
-            float gain = 1.0f;
-            if (comp->envelope > thresh_linear) {
-                // For a signal above the threshold, the compressor reduces gain.
-                // A simplified approach: compute how much over threshold (in linear ratio)
-                float over = comp->envelope / thresh_linear;
-                // The desired gain reduction is such that the output level is compressed by the ratio.
-                // One common formulation is: gain = (over)^(1/ratio - 1)
-                gain = pow(over, (1.0f / comp->ratio.load()) - 1.0f);
+            if (link) {
+                // Linked detector: follow the loudest channel, apply one gain to all.
+                float peak = 0.0f;
+                for (int c = 0; c < nch; c++)
+                    peak = std::max(peak, std::fabs(in[c][i]));
+                float coeff = (peak > env[0]) ? attack_coeff : release_coeff;
+                env[0] = coeff * env[0] + (1 - coeff) * peak;
+
+                float gain = 1.0f;
+                if (env[0] > thresh_linear)
+                    gain = std::pow(env[0] / thresh_linear, exponent);
+                gain *= makeup;
+                for (int c = 0; c < nch; c++)
+                    out[c][i] = in[c][i] * gain;
+            }
+            else {
+                // Independent detectors: each lane updates its own envelope.
+                for (int c = 0; c < nch; c++) {
+                    float input = in[c][i];
+                    float abs_input = std::fabs(input);
+                    float coeff = (abs_input > env[c]) ? attack_coeff : release_coeff;
+                    env[c] = coeff * env[c] + (1 - coeff) * abs_input;
+
+                    float gain = 1.0f;
+                    if (env[c] > thresh_linear)
+                        gain = std::pow(env[c] / thresh_linear, exponent);
+                    out[c][i] = input * gain * makeup;
+                }
             }
-            // Apply makeup gain.
-            gain *= comp->makeup_gain.load();
-
-            // Process the sample.
-            out[i] = input * gain;
         }
         return 0;
     }
 
     // Control thread to allow real-time parameter adjustments.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomComp] Enter new parameters: threshold (dB), ratio, attack (ms), release (ms), makeup gain (linear) (or type 'q' to quit): ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float new_threshold, new_ratio, new_attack, new_release, new_makeup;
-            if (!(iss >> new_threshold >> new_ratio >> new_attack >> new_release >> new_makeup)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomComp] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            threshold.store(new_threshold);
-            ratio.store(new_ratio);
-            attack.store(new_attack);
-            release.store(new_release);
-            makeup_gain.store(new_makeup);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomComp] Updated parameters: threshold = " << new_threshold
-                    << " dB, ratio = " << new_ratio << ":1, attack = " << new_attack
-                    << " ms, release = " << new_release << " ms, makeup gain = " << new_makeup << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomComp] Enter new parameters: threshold (dB), ratio, attack (ms), release (ms), makeup gain (linear), [link 0/1] (or type 'q' to quit): ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float new_threshold, new_ratio, new_attack, new_release, new_makeup;
+        if (!(iss >> new_threshold >> new_ratio >> new_attack >> new_release >> new_makeup))
+            return false;
+        int new_link;
+        if (iss >> new_link)
+            linked.store(new_link != 0);
+        threshold.store(new_threshold);
+        ratio.store(new_ratio);
+        attack.store(new_attack);
+        release.store(new_release);
+        makeup_gain.store(new_makeup);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomComp] Updated parameters: threshold = " << new_threshold
+                << " dB, ratio = " << new_ratio << ":1, attack = " << new_attack
+                << " ms, release = " << new_release << " ms, makeup gain = " << new_makeup
+                << ", detector " << (linked.load() ? "linked" : "per-channel") << std::endl;
         }
+        return true;
     }
 
 public:
-    PhantomComp(const char* client_name = "PhantomComp")
-        : client(nullptr), input_port(nullptr), output_port(nullptr),
-        running(true), envelope(0.0f) {
+    PhantomComp(int channels = 1, const char* client_name = "PhantomComp")
+        : phantom::Plugin(client_name), num_channels(channels) {
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            throw std::runtime_error("PhantomComp: Channel count must be between 1 and 8");
+        }
+        envelope.assign(num_channels, 0.0f);
+        in_bufs.assign(num_channels, nullptr);
+        out_bufs.assign(num_channels, nullptr);
+
         // Set default compressor parameters.
         threshold.store(-20.0f);
         ratio.store(4.0f);
         attack.store(10.0f);
         release.store(100.0f);
         makeup_gain.store(1.0f);
+        linked.store(true);
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomComp: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        input_port = jack_port_register(client, "input", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        output_port = jack_port_register(client, "output", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!input_port || !output_port) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomComp: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomComp: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomComp: Failed to activate JACK client");
+        for (int c = 0; c < num_channels; c++) {
+            jack_port_t* in = registerInput(phantom::channelPortName("input", c, num_channels));
+            jack_port_t* out = registerOutput(phantom::channelPortName("output", c, num_channels));
+            input_ports.push_back(in);
+            output_ports.push_back(out);
         }
 
-        // Start the control thread.
-        control_thread = std::thread(&PhantomComp::control_loop, this);
+        // Activate JACK processing and start the control thread.
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
-            std::cout << "[PhantomComp] Initialized. Sample rate: " << sample_rate << " Hz" << std::endl;
+            std::cout << "[PhantomComp] Initialized. Sample rate: " << sample_rate << " Hz, channels: "
+                << num_channels << std::endl;
             std::cout << "[PhantomComp] Default parameters: threshold = " << threshold.load() << " dB, ratio = "
                 << ratio.load() << ":1, attack = " << attack.load() << " ms, release = "
-                << release.load() << " ms, makeup gain = " << makeup_gain.load() << std::endl;
-        }
-    }
-
-    ~PhantomComp() {
-        running.store(false);
-        if (control_thread.joinable()) {
-            control_thread.join();
-        }
-        if (client) {
-            jack_client_close(client);
-        }
-    }
-
-    void run() {
-        std::cout << "[PhantomComp] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                << release.load() << " ms, makeup gain = " << makeup_gain.load()
+                << ", detector " << (linked.load() ? "linked" : "per-channel") << std::endl;
         }
-        std::cout << "[PhantomComp] Shutting down." << std::endl;
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomComp comp;
+        int channels = (argc > 1) ? std::atoi(argv[1]) : 1;
+        PhantomComp comp(channels);
         comp.run();
     }
     catch (const std::exception& e) {
@@ -13,29 +13,21 @@
 // Compile with:
 //   g++ -std=c++11 PhantomDeNoiser.cpp -ljack -lpthread -o PhantomDeNoiser
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <string>
 
 using namespace std;
 
-class PhantomDeNoiser {
+class PhantomDeNoiser : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
 
     // Parameters:
     atomic<float> threshold_dB;  // Noise threshold in dB (e.g., -60 dB).
@@ -47,19 +39,18 @@ private:
     float noiseEstimate;  // Running noise floor estimate (in linear amplitude).
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomDeNoiser* nd = static_cast<PhantomDeNoiser*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(nd->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(nd->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
 
         // Convert threshold from dB to linear.
-        float currentThreshold_lin = powf(10.0f, nd->threshold_dB.load() / 20.0f);
-        float currentReduction = nd->reduction.load();
-        float currentLearningTime = nd->learningTime_ms.load();
-        float currentMix = nd->mix.load();
+        float currentThreshold_lin = powf(10.0f, threshold_dB.load() / 20.0f);
+        float currentReduction = reduction.load();
+        float currentLearningTime = learningTime_ms.load();
+        float currentMix = mix.load();
 
         // Calculate dt in ms per sample.
-        float dt_ms = 1000.0f / nd->sample_rate;
+        float dt_ms = 1000.0f / sample_rate;
         // Compute exponential smoothing coefficient for noise estimation.
         // We use: alpha = exp(-dt / T)
         float alpha = expf(-dt_ms / currentLearningTime);
@@ -70,15 +61,15 @@ private:
 
             // Update noise estimate only if the current absolute value is below the noise threshold.
             if (absX < currentThreshold_lin) {
-                nd->noiseEstimate = alpha * nd->noiseEstimate + (1.0f - alpha) * absX;
+                noiseEstimate = alpha * noiseEstimate + (1.0f - alpha) * absX;
             }
             // Compute processed sample: subtract a scaled noise estimate.
             // Preserve the sign of x.
             float processed = x;
             if (x > 0)
-                processed = x - currentReduction * nd->noiseEstimate;
+                processed = x - currentReduction * noiseEstimate;
             else if (x < 0)
-                processed = x + currentReduction * nd->noiseEstimate;
+                processed = x + currentReduction * noiseEstimate;
             // Optionally, you might want to clamp the result to avoid inversion.
             // For this simple implementation, we leave it as is.
             // Blend processed with dry signal.
@@ -88,48 +79,37 @@ private:
     }
 
     // Control thread: allows updating parameters in real time.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomDeNoiser] Enter parameters: threshold (dB), reduction (0.0-1.0), learning time (ms), mix (0.0-1.0)" << endl;
-                cout << "e.g., \"-60 1.0 100 1.0\" or type 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newThreshold_dB, newReduction, newLearningTime, newMix;
-            if (!(iss >> newThreshold_dB >> newReduction >> newLearningTime >> newMix)) {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomDeNoiser] Invalid input. Please try again." << endl;
-                continue;
-            }
-            // Optionally clamp mix between 0 and 1.
-            if (newMix < 0.0f) newMix = 0.0f;
-            if (newMix > 1.0f) newMix = 1.0f;
-            threshold_dB.store(newThreshold_dB);
-            reduction.store(newReduction);
-            learningTime_ms.store(newLearningTime);
-            mix.store(newMix);
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomDeNoiser] Updated parameters:" << endl;
-                cout << "  Threshold = " << newThreshold_dB << " dB" << endl;
-                cout << "  Reduction = " << newReduction << endl;
-                cout << "  Learning Time = " << newLearningTime << " ms" << endl;
-                cout << "  Mix = " << newMix << endl;
-            }
+    void printPrompt() override {
+        cout << "\n[PhantomDeNoiser] Enter parameters: threshold (dB), reduction (0.0-1.0), learning time (ms), mix (0.0-1.0)" << endl;
+        cout << "e.g., \"-60 1.0 100 1.0\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        float newThreshold_dB, newReduction, newLearningTime, newMix;
+        if (!(iss >> newThreshold_dB >> newReduction >> newLearningTime >> newMix))
+            return false;
+        // Optionally clamp mix between 0 and 1.
+        if (newMix < 0.0f) newMix = 0.0f;
+        if (newMix > 1.0f) newMix = 1.0f;
+        threshold_dB.store(newThreshold_dB);
+        reduction.store(newReduction);
+        learningTime_ms.store(newLearningTime);
+        mix.store(newMix);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomDeNoiser] Updated parameters:" << endl;
+            cout << "  Threshold = " << newThreshold_dB << " dB" << endl;
+            cout << "  Reduction = " << newReduction << endl;
+            cout << "  Learning Time = " << newLearningTime << " ms" << endl;
+            cout << "  Mix = " << newMix << endl;
         }
+        return true;
     }
 
 public:
     PhantomDeNoiser(const char* client_name = "PhantomDeNoiser")
-        : client(nullptr), running(true), noiseEstimate(0.0f)
+        : phantom::Plugin(client_name), noiseEstimate(0.0f)
     {
         // Set default parameters.
         threshold_dB.store(-60.0f);    // Default threshold: -60 dB.
@@ -137,34 +117,13 @@ public:
         learningTime_ms.store(100.0f); // Default learning time: 100 ms.
         mix.store(1.0f);               // Fully processed by default (100% noise-reduced).
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomDeNoiser: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDeNoiser: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDeNoiser: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDeNoiser: Failed to activate JACK client");
-        }
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
 
         // Initialize the noise estimate.
         noiseEstimate = 0.0f;
 
-        control_thread = thread(&PhantomDeNoiser::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
         cout << "[PhantomDeNoiser] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
@@ -174,22 +133,6 @@ public:
         cout << "  Learning Time = " << learningTime_ms.load() << " ms" << endl;
         cout << "  Mix = " << mix.load() << endl;
     }
-
-    ~PhantomDeNoiser() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomDeNoiser] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomDeNoiser] Shutting down." << endl;
-    }
 };
 
 int main() {
@@ -10,36 +10,47 @@
 //   - Attack Time (ms) [e.g., 10 ms]
 //   - Release Time (ms) [e.g., 50 ms]
 //   - Mix (0.0 = dry, 1.0 = fully ducked)
+//   - Key filter: "hpf <Hz>" / "lpf <Hz>" band-limit the detector path (0 = off)
+//   - Key combine: "mode max" or "mode sum" when several sidechains are connected
+//
+// Several voice-over sources can duck the same bed from one client: the number of
+// sidechain inputs (up to 8) and bed channels (up to 8) are given on the command line.
+// Each sidechain is key-filtered, the keys are combined by max or sum, and one
+// envelope drives the gain applied to every bed channel, all in a single callback.
 //
 // Compile with:
 //   g++ -std=c++11 PhantomDuck.cpp -ljack -lpthread -o PhantomDuck
+// Usage:
+//   ./PhantomDuck [sidechains] [bed channels]
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 
-class PhantomDuck {
+class PhantomDuck : public phantom::Plugin {
+public:
+    static const int MAX_SIDECHAINS = 8;
+    static const int MAX_CHANNELS = 8;
+
 private:
-    jack_client_t* client;
-    // Two input ports: one for the main signal, one for the sidechain.
-    jack_port_t* main_in_port;
-    jack_port_t* side_in_port;
-    // One output port.
-    jack_port_t* out_port;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
+    int num_sidechains;
+    int num_channels;
+    // Bed inputs to be ducked and their outputs.
+    vector<jack_port_t*> main_in_ports;
+    vector<jack_port_t*> out_ports;
+    // Sidechain (key) inputs.
+    vector<jack_port_t*> side_in_ports;
+    vector<float*> main_bufs, out_bufs, side_bufs;
 
     // Compressor parameters.
     // Threshold (dB) at which to start ducking.
@@ -49,36 +60,45 @@ private:
     atomic<float> releaseTime;   // in ms, e.g., 50.
     atomic<float> mix;           // 0.0 = dry main, 1.0 = fully ducked main.
 
-    // Envelope for the sidechain signal.
+    // Per-sidechain key filters and the max/sum combine mode.
+    phantom::KeyFilter keyFilter;
+
+    // Envelope for the combined sidechain signal.
     float envelope;
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomDuck* duck = static_cast<PhantomDuck*>(arg);
-        float* mainIn = static_cast<float*>(jack_port_get_buffer(duck->main_in_port, nframes));
-        float* sideIn = static_cast<float*>(jack_port_get_buffer(duck->side_in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(duck->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        const int nsc = num_sidechains;
+        const int nch = num_channels;
+        float** sideIn = side_bufs.data();
+        float** mainIn = main_bufs.data();
+        float** out = out_bufs.data();
+        for (int k = 0; k < nsc; k++)
+            sideIn[k] = audioBuffer(side_in_ports[k], nframes);
+        for (int c = 0; c < nch; c++) {
+            mainIn[c] = audioBuffer(main_in_ports[c], nframes);
+            out[c] = audioBuffer(out_ports[c], nframes);
+        }
 
-        float dt = 1.0f / duck->sample_rate;
+        float dt = 1.0f / sample_rate;
         float dt_ms = dt * 1000.0f;
-        float att = duck->attackTime.load();
-        float rel = duck->releaseTime.load();
-        float currentThreshold_dB = duck->threshold_dB.load();
-        float currentThreshold = powf(10.0f, currentThreshold_dB / 20.0f); // convert threshold dB to linear.
-        float currentRatio = duck->ratio.load();
-        float currentMix = duck->mix.load();
+        float attCoeff = expf(-dt_ms / attackTime.load());
+        float relCoeff = expf(-dt_ms / releaseTime.load());
+        float currentThreshold_dB = threshold_dB.load();
+        float currentRatio = ratio.load();
+        float currentMix = mix.load();
+        keyFilter.refresh();
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
-            float mainSample = mainIn[i];
-            float sideSample = sideIn[i];
-            float absSide = fabs(sideSample);
+            // Combine all key-filtered sidechains into one detector input.
+            float key = 0.0f;
+            for (int k = 0; k < nsc; k++)
+                key = keyFilter.combine(key, keyFilter.detect(k, sideIn[k][i]));
             // Update envelope using attack/release exponential smoothing.
-            if (absSide > duck->envelope)
-                duck->envelope = expf(-dt_ms / att) * duck->envelope + (1.0f - expf(-dt_ms / att)) * absSide;
-            else
-                duck->envelope = expf(-dt_ms / rel) * duck->envelope + (1.0f - expf(-dt_ms / rel)) * absSide;
+            float coeff = (key > envelope) ? attCoeff : relCoeff;
+            envelope = coeff * envelope + (1.0f - coeff) * key;
             // Avoid log of zero by ensuring envelope is at least a tiny value.
-            float effectiveEnv = (duck->envelope > 1e-6f) ? duck->envelope : 1e-6f;
+            float effectiveEnv = (envelope > 1e-6f) ? envelope : 1e-6f;
             // Convert envelope to dB.
             float env_dB = 20.0f * log10f(effectiveEnv);
             float gain;
@@ -91,61 +111,60 @@ private:
             else {
                 gain = 1.0f;
             }
-            // Apply gain reduction to the main signal.
-            float duckedSample = mainSample * gain;
-            // Blend the dry main signal with the ducked version.
-            out[i] = (1.0f - currentMix) * mainSample + currentMix * duckedSample;
+            // Blend the dry bed with the ducked version: (1 - mix) * x + mix * gain * x.
+            float outGain = (1.0f - currentMix) + currentMix * gain;
+            for (int c = 0; c < nch; c++)
+                out[c][i] = mainIn[c][i] * outGain;
         }
         return 0;
     }
 
     // Control thread: allows updating parameters in real time.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomDuck] Enter parameters:" << endl;
-                cout << "Threshold (dB), Ratio, Attack (ms), Release (ms), Mix (0.0-1.0)" << endl;
-                cout << "e.g., \"-30 4.0 10 50 1.0\" or type 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newThreshold, newRatio, newAttack, newRelease, newMix;
-            if (!(iss >> newThreshold >> newRatio >> newAttack >> newRelease >> newMix)) {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomDuck] Invalid input. Please try again." << endl;
-                continue;
-            }
-            // Clamp mix to [0, 1].
-            if (newMix < 0.0f) newMix = 0.0f;
-            if (newMix > 1.0f) newMix = 1.0f;
-            threshold_dB.store(newThreshold);
-            ratio.store(newRatio);
-            attackTime.store(newAttack);
-            releaseTime.store(newRelease);
-            mix.store(newMix);
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomDuck] Updated parameters:" << endl;
-                cout << "  Threshold = " << newThreshold << " dB" << endl;
-                cout << "  Ratio = " << newRatio << endl;
-                cout << "  Attack = " << newAttack << " ms" << endl;
-                cout << "  Release = " << newRelease << " ms" << endl;
-                cout << "  Mix = " << newMix << endl;
-            }
+    void printPrompt() override {
+        cout << "\n[PhantomDuck] Enter parameters:" << endl;
+        cout << "Threshold (dB), Ratio, Attack (ms), Release (ms), Mix (0.0-1.0)" << endl;
+        cout << "e.g., \"-30 4.0 10 50 1.0\", \"hpf 150\", \"lpf 4000\", \"mode max|sum\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const string& line) override {
+        bool valid;
+        if (keyFilter.handleCommand(line, "PhantomDuck", print_mutex, valid))
+            return valid;
+        istringstream iss(line);
+        float newThreshold, newRatio, newAttack, newRelease, newMix;
+        if (!(iss >> newThreshold >> newRatio >> newAttack >> newRelease >> newMix))
+            return false;
+        // Clamp mix to [0, 1].
+        if (newMix < 0.0f) newMix = 0.0f;
+        if (newMix > 1.0f) newMix = 1.0f;
+        threshold_dB.store(newThreshold);
+        ratio.store(newRatio);
+        attackTime.store(newAttack);
+        releaseTime.store(newRelease);
+        mix.store(newMix);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomDuck] Updated parameters:" << endl;
+            cout << "  Threshold = " << newThreshold << " dB" << endl;
+            cout << "  Ratio = " << newRatio << endl;
+            cout << "  Attack = " << newAttack << " ms" << endl;
+            cout << "  Release = " << newRelease << " ms" << endl;
+            cout << "  Mix = " << newMix << endl;
         }
+        return true;
     }
 
 public:
-    PhantomDuck(const char* client_name = "PhantomDuck")
-        : client(nullptr), running(true), envelope(0.0f)
+    PhantomDuck(int sidechains = 1, int channels = 1, const char* client_name = "PhantomDuck")
+        : phantom::Plugin(client_name), num_sidechains(sidechains), num_channels(channels), envelope(0.0f)
     {
+        if (sidechains < 1 || sidechains > MAX_SIDECHAINS) {
+            throw runtime_error("PhantomDuck: Sidechain count must be between 1 and 8");
+        }
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            throw runtime_error("PhantomDuck: Channel count must be between 1 and 8");
+        }
+
         // Set default parameters.
         threshold_dB.store(-30.0f);
         ratio.store(4.0f);
@@ -153,37 +172,29 @@ public:
         releaseTime.store(50.0f);
         mix.store(1.0f); // Fully ducked by default.
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomDuck: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        // Register input ports.
-        main_in_port = jack_port_register(client, "main", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        side_in_port = jack_port_register(client, "side", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        // Register mono output port.
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!main_in_port || !side_in_port || !out_port) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDuck: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDuck: Failed to set process callback");
+        keyFilter.allocate(num_sidechains, sample_rate);
+        side_bufs.assign(num_sidechains, nullptr);
+        main_bufs.assign(num_channels, nullptr);
+        out_bufs.assign(num_channels, nullptr);
+
+        // Register bed input/output ports.
+        for (int c = 0; c < num_channels; c++) {
+            jack_port_t* in = registerInput(phantom::channelPortName("main", c, num_channels));
+            jack_port_t* out = registerOutput(phantom::channelPortName("out", c, num_channels));
+            main_in_ports.push_back(in);
+            out_ports.push_back(out);
         }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomDuck: Failed to activate JACK client");
+        // Register sidechain input ports.
+        for (int k = 0; k < num_sidechains; k++) {
+            jack_port_t* side = registerInput(phantom::numberedPortName("side", k, num_sidechains));
+            side_in_ports.push_back(side);
         }
 
-        control_thread = thread(&PhantomDuck::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
-        cout << "[PhantomDuck] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
+        cout << "[PhantomDuck] Initialized. Sample rate: " << sample_rate << " Hz, sidechains: "
+            << num_sidechains << ", bed channels: " << num_channels << endl;
         cout << "[PhantomDuck] Default parameters:" << endl;
         cout << "  Threshold = " << threshold_dB.load() << " dB" << endl;
         cout << "  Ratio = " << ratio.load() << endl;
@@ -191,27 +202,13 @@ public:
         cout << "  Release = " << releaseTime.load() << " ms" << endl;
         cout << "  Mix = " << mix.load() << endl;
     }
-
-    ~PhantomDuck() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomDuck] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomDuck] Shutting down." << endl;
-    }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomDuck duck;
+        int sidechains = (argc > 1) ? atoi(argv[1]) : 1;
+        int channels = (argc > 2) ? atoi(argv[2]) : 1;
+        PhantomDuck duck(sidechains, channels);
         duck.run();
     }
     catch (const exception& e) {
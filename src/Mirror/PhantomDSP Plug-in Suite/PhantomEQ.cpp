@@ -5,122 +5,19 @@
 // Compile with:
 //   g++ -std=c++11 OliveEQ.cpp -ljack -lpthread -o OliveEQ
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <cmath>
 #include <iostream>
 #include <sstream>
 #include <atomic>
-#include <thread>
 #include <mutex>
-#include <chrono>
 #include <stdexcept>
 
-// ------------------ Biquad Filter Class ------------------
-struct Biquad {
-    // Coefficients (a0 normalized to 1)
-    float b0, b1, b2, a1, a2;
-    // State variables
-    float x1, x2, y1, y2;
-    Biquad() : b0(1), b1(0), b2(0), a1(0), a2(0),
-        x1(0), x2(0), y1(0), y2(0) {
-    }
-    inline float process(float x) {
-        float y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-        x2 = x1;
-        x1 = x;
-        y2 = y1;
-        y1 = y;
-        return y;
-    }
-    inline void reset() { x1 = x2 = y1 = y2 = 0; }
-};
-
-// ------------------ Filter Coefficient Calculations ------------------
-// Based on Robert Bristow-Johnson's Audio EQ Cookbook formulas
-
-// Low-Shelf Filter Update
-static void updateLowShelf(Biquad& bq, float fs, float f0, float dBgain, float Q) {
-    float A = powf(10.0f, dBgain / 40.0f);
-    float w0 = 2.0f * M_PI * f0 / fs;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float S = 1.0f; // Shelf slope (fixed)
-    float alpha = sinw0 / 2.0f * sqrtf((A + 1.0f / A) * (1.0f / S - 1.0f) + 2.0f);
-
-    float b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha);
-    float b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
-    float b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha);
-    float a0 = (A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha;
-    float a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
-    float a2 = (A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha;
-
-    bq.b0 = b0 / a0;
-    bq.b1 = b1 / a0;
-    bq.b2 = b2 / a0;
-    bq.a1 = a1 / a0;
-    bq.a2 = a2 / a0;
-}
-
-// Peaking EQ Filter Update
-static void updatePeaking(Biquad& bq, float fs, float f0, float dBgain, float Q) {
-    float A = powf(10.0f, dBgain / 40.0f);
-    float w0 = 2.0f * M_PI * f0 / fs;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float alpha = sinw0 / (2.0f * Q);
-
-    float b0 = 1.0f + alpha * A;
-    float b1 = -2.0f * cosw0;
-    float b2 = 1.0f - alpha * A;
-    float a0 = 1.0f + alpha / A;
-    float a1 = -2.0f * cosw0;
-    float a2 = 1.0f - alpha / A;
-
-    bq.b0 = b0 / a0;
-    bq.b1 = b1 / a0;
-    bq.b2 = b2 / a0;
-    bq.a1 = a1 / a0;
-    bq.a2 = a2 / a0;
-}
-
-// High-Shelf Filter Update
-static void updateHighShelf(Biquad& bq, float fs, float f0, float dBgain, float Q) {
-    float A = powf(10.0f, dBgain / 40.0f);
-    float w0 = 2.0f * M_PI * f0 / fs;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float S = 1.0f;
-    float alpha = sinw0 / 2.0f * sqrtf((A + 1.0f / A) * (1.0f / S - 1.0f) + 2.0f);
-
-    float b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha);
-    float b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0);
-    float b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha);
-    float a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha;
-    float a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0);
-    float a2 = (A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha;
-
-    bq.b0 = b0 / a0;
-    bq.b1 = b1 / a0;
-    bq.b2 = b2 / a0;
-    bq.a1 = a1 / a0;
-    bq.a2 = a2 / a0;
-}
-
 // ------------------ OliveEQ Class (Mastering EQ) ------------------
-class OliveEQ {
+class OliveEQ : public phantom::Plugin {
 private:
-    jack_client_t* client;
     // Stereo ports
     jack_port_t* in_left, * in_right, * out_left, * out_right;
-    int sample_rate;
-
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
 
     // EQ parameters (in dB) for each band
     std::atomic<float> lowGain;  // Low-shelf gain (default 0 dB)
@@ -135,132 +32,105 @@ private:
     const float midQ = 1.0f;
     const float highQ = 0.707f;
 
-    // For each channel, we have three Biquad filters in series.
+    // For each channel, we have three RBJ biquads in series.
     // Left channel filters:
-    Biquad leftLow, leftMid, leftHigh;
+    phantom::Biquad leftLow, leftMid, leftHigh;
     // Right channel filters:
-    Biquad rightLow, rightMid, rightHigh;
+    phantom::Biquad rightLow, rightMid, rightHigh;
+    // Gains the coefficients were last computed for.
+    float appliedLow, appliedMid, appliedHigh;
 
-    // Update filter coefficients for a block (for both channels)
+    // Recompute the coefficients of any band whose gain changed (both channels).
     void updateFilters() {
-        float fs = static_cast<float>(sample_rate);
         // Load current gain settings from atomics
         float low_dB = lowGain.load();
         float mid_dB = midGain.load();
         float high_dB = highGain.load();
-        // Update left channel filters
-        updateLowShelf(leftLow, fs, lowFreq, low_dB, lowQ);
-        updatePeaking(leftMid, fs, midFreq, mid_dB, midQ);
-        updateHighShelf(leftHigh, fs, highFreq, high_dB, highQ);
-        // Update right channel filters
-        updateLowShelf(rightLow, fs, lowFreq, low_dB, lowQ);
-        updatePeaking(rightMid, fs, midFreq, mid_dB, midQ);
-        updateHighShelf(rightHigh, fs, highFreq, high_dB, highQ);
+        if (low_dB != appliedLow) {
+            leftLow.set(phantom::Biquad::LOWSHELF, lowFreq, lowQ, low_dB, sample_rate);
+            rightLow.set(phantom::Biquad::LOWSHELF, lowFreq, lowQ, low_dB, sample_rate);
+            appliedLow = low_dB;
+        }
+        if (mid_dB != appliedMid) {
+            leftMid.set(phantom::Biquad::PEAK, midFreq, midQ, mid_dB, sample_rate);
+            rightMid.set(phantom::Biquad::PEAK, midFreq, midQ, mid_dB, sample_rate);
+            appliedMid = mid_dB;
+        }
+        if (high_dB != appliedHigh) {
+            leftHigh.set(phantom::Biquad::HIGHSHELF, highFreq, highQ, high_dB, sample_rate);
+            rightHigh.set(phantom::Biquad::HIGHSHELF, highFreq, highQ, high_dB, sample_rate);
+            appliedHigh = high_dB;
+        }
     }
 
     // JACK process callback: applies the EQ to stereo audio.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        OliveEQ* eq = static_cast<OliveEQ*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(eq->in_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(eq->in_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(eq->out_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(eq->out_right, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* inL = audioBuffer(in_left, nframes);
+        float* inR = audioBuffer(in_right, nframes);
+        float* outL = audioBuffer(out_left, nframes);
+        float* outR = audioBuffer(out_right, nframes);
 
-        // Update the filter coefficients at the beginning of the block
-        eq->updateFilters();
+        // Pick up gain changes at the beginning of the block
+        updateFilters();
 
         // Process each sample for left and right channels separately
         for (jack_nframes_t i = 0; i < nframes; i++) {
             // Left channel processing through low, mid, high filters in series
             float sampleL = inL[i];
-            sampleL = eq->leftLow.process(sampleL);
-            sampleL = eq->leftMid.process(sampleL);
-            sampleL = eq->leftHigh.process(sampleL);
+            sampleL = leftLow.process(sampleL);
+            sampleL = leftMid.process(sampleL);
+            sampleL = leftHigh.process(sampleL);
             outL[i] = sampleL;
 
             // Right channel processing
             float sampleR = inR[i];
-            sampleR = eq->rightLow.process(sampleR);
-            sampleR = eq->rightMid.process(sampleR);
-            sampleR = eq->rightHigh.process(sampleR);
+            sampleR = rightLow.process(sampleR);
+            sampleR = rightMid.process(sampleR);
+            sampleR = rightHigh.process(sampleR);
             outR[i] = sampleR;
         }
         return 0;
     }
 
     // Control thread: allows real-time adjustment of low, mid, and high gains.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[OliveEQ] Enter new gains for low, mid, and high bands (in dB), e.g., \"3.0 -2.0 4.0\", or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float newLow, newMid, newHigh;
-            if (!(iss >> newLow >> newMid >> newHigh)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[OliveEQ] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            lowGain.store(newLow);
-            midGain.store(newMid);
-            highGain.store(newHigh);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[OliveEQ] Updated gains: low = " << newLow << " dB, mid = " << newMid << " dB, high = " << newHigh << " dB" << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[OliveEQ] Enter new gains for low, mid, and high bands (in dB), e.g., \"3.0 -2.0 4.0\", or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float newLow, newMid, newHigh;
+        if (!(iss >> newLow >> newMid >> newHigh))
+            return false;
+        lowGain.store(newLow);
+        midGain.store(newMid);
+        highGain.store(newHigh);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[OliveEQ] Updated gains: low = " << newLow << " dB, mid = " << newMid << " dB, high = " << newHigh << " dB" << std::endl;
         }
+        return true;
     }
 
 public:
     OliveEQ(const char* client_name = "OliveEQ")
-        : client(nullptr), running(true)
+        : phantom::Plugin(client_name)
     {
         // Initialize EQ gains to 0 dB (unity gain)
         lowGain.store(0.0f);
         midGain.store(0.0f);
         highGain.store(0.0f);
-
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("OliveEQ: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
+        appliedLow = appliedMid = appliedHigh = NAN;
+        updateFilters();
 
         // Register stereo ports
-        in_left = jack_port_register(client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        in_right = jack_port_register(client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_left || !in_right || !out_left || !out_right) {
-            jack_client_close(client);
-            throw std::runtime_error("OliveEQ: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("OliveEQ: Failed to set process callback");
-        }
+        in_left = registerInput("in_left");
+        in_right = registerInput("in_right");
+        out_left = registerOutput("out_left");
+        out_right = registerOutput("out_right");
 
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("OliveEQ: Failed to activate JACK client");
-        }
-
-        // Start the control thread.
-        control_thread = std::thread(&OliveEQ::control_loop, this);
-
-        // (Optional) Reset filter states.
-        leftLow.reset(); leftMid.reset(); leftHigh.reset();
-        rightLow.reset(); rightMid.reset(); rightHigh.reset();
+        // Activate JACK processing and start the control thread.
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
@@ -268,24 +138,6 @@ public:
             std::cout << "[OliveEQ] Default gains: low = " << lowGain.load() << " dB, mid = " << midGain.load() << " dB, high = " << highGain.load() << " dB" << std::endl;
         }
     }
-
-    ~OliveEQ() {
-        running.store(false);
-        if (control_thread.joinable()) {
-            control_thread.join();
-        }
-        if (client) {
-            jack_client_close(client);
-        }
-    }
-
-    void run() {
-        std::cout << "[OliveEQ] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[OliveEQ] Shutting down." << std::endl;
-    }
 };
 
 int main() {
@@ -2,56 +2,54 @@
 // A real-time delay/echo effect processor using JACK
 
 #include <iostream>
-#include <jack/jack.h>
-#include <vector>
+#include "PhantomRuntime.h"
 #include <atomic>
-#include <thread>
 #include <mutex>
-#include <chrono>
 #include <stdexcept>
 #include <cmath>
 #include <sstream>
+#include <algorithm>
 
 // PhantomEcho applies a delay (echo) effect with real-time control over delay time and feedback.
 // It uses a circular buffer to store incoming samples and mixes delayed samples back into the output.
+// The delay can follow the JACK transport tempo as a note division ("sync 1/8d"); tempo
+// changes crossfade to the new length inside the preallocated buffer.
 
-class PhantomEcho {
+class PhantomEcho : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* input_port;
     jack_port_t* output_port;
 
-    // Circular buffer for delay (2 seconds max)
-    std::vector<float> delay_buffer;
-    std::atomic<size_t> write_index;
-    size_t buffer_size; // in samples
+    static const int MAX_DELAY_SECONDS = 4;
+
+    // Circular buffer for delay, allocated once for the longest delay.
+    phantom::DelayLine delay_line;
+    phantom::CrossfadeTap tap;
+    phantom::TempoClock tempo;
 
     // Real-time adjustable parameters
     std::atomic<int> delay_time_ms;  // delay time in milliseconds
     std::atomic<float> feedback;     // feedback factor (0.0 - 1.0)
-
-    int sample_rate; // obtained from JACK
-
-    // Control thread for user parameter input
-    std::atomic<bool> running;
-    std::thread control_thread;
-
-    // Mutex for printing (to avoid jumbled console output)
-    std::mutex print_mutex;
+    std::atomic<float> syncBeats;    // synced note length in beats (0 = use delay_time_ms)
 
     // JACK process callback: applies the delay effect sample-by-sample.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomEcho* echo = static_cast<PhantomEcho*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(echo->input_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(echo->output_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(input_port, nframes);
+        float* out = audioBuffer(output_port, nframes);
+
+        // Resolve the delay length once per block, from the tempo or from delay_time_ms.
+        tempo.update(client);
+        float beats = syncBeats.load();
+        float delay_samples = beats > 0.0f ? tempo.samplesFor(beats, sample_rate)
+                                           : delay_time_ms.load() * sample_rate / 1000.0f;
+        delay_samples = std::min(std::max(delay_samples, 1.0f), static_cast<float>(delay_line.capacity()));
+        // The tap is read before this sample is written, hence the one-sample offset.
+        tap.setDelay(delay_samples - 1.0f);
+        float fb = feedback.load();
 
         // For each sample in the current JACK frame:
         for (jack_nframes_t i = 0; i < nframes; i++) {
-            // Compute delay in samples from current delay_time_ms
-            size_t delay_samples = static_cast<size_t>((echo->delay_time_ms.load() * echo->sample_rate) / 1000);
-            // Calculate read index for the delayed sample
-            size_t read_index = (echo->write_index.load() + echo->buffer_size - delay_samples) % echo->buffer_size;
-            float delayed_sample = echo->delay_buffer[read_index];
+            float delayed_sample = tap.read(delay_line);
 
             // Mix input and delayed signal
             float input_sample = in[i];
@@ -61,128 +59,67 @@ private:
             out[i] = output_sample;
 
             // Store new sample into the delay buffer with feedback applied
-            echo->delay_buffer[echo->write_index.load()] = input_sample + delayed_sample * echo->feedback.load();
-
-            // Increment write index circularly
-            echo->write_index = (echo->write_index.load() + 1) % echo->buffer_size;
+            delay_line.write(input_sample + delayed_sample * fb);
         }
         return 0;
     }
 
     // Control loop: runs on a separate thread to allow real-time parameter adjustments.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomEcho] Enter new delay time (ms) and feedback (0.0-1.0), separated by space (or type 'q' to quit): ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-
-            std::istringstream iss(line);
-            int new_delay;
-            float new_feedback;
-            if (!(iss >> new_delay >> new_feedback)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomEcho] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-
-            // Clamp feedback between 0.0 and 1.0
-            if (new_feedback < 0.0f) new_feedback = 0.0f;
-            if (new_feedback > 1.0f) new_feedback = 1.0f;
-
-            delay_time_ms.store(new_delay);
-            feedback.store(new_feedback);
-
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomEcho] Updated parameters: delay_time = " << new_delay
-                          << " ms, feedback = " << new_feedback << std::endl;
-            }
-        }
+    void printPrompt() override {
+        std::cout << "\n[PhantomEcho] Tempo: 'sync <1/4|1/8d|1/16t|...>', 'sync off', 'bpm <value>' (fallback when no transport)" << std::endl;
+        std::cout << "[PhantomEcho] Enter new delay time (ms) and feedback (0.0-1.0), separated by space (or type 'q' to quit): ";
     }
 
-public:
-    PhantomEcho(const char* client_name = "PhantomEcho")
-        : client(nullptr), input_port(nullptr), output_port(nullptr),
-          write_index(0), delay_time_ms(500), feedback(0.5f), running(true) {
-
-        // Open JACK client
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomEcho: Failed to open JACK client");
-        }
+    bool handleCommand(const std::string& line) override {
+        bool valid;
+        if (phantom::handleTempoCommand(line, tempo, syncBeats, "PhantomEcho", print_mutex, valid))
+            return valid;
 
-        // Get the sample rate
-        sample_rate = jack_get_sample_rate(client);
+        std::istringstream iss(line);
+        int new_delay;
+        float new_feedback;
+        if (!(iss >> new_delay >> new_feedback))
+            return false;
 
-        // Allocate a 2-second delay buffer
-        buffer_size = sample_rate * 2;
-        delay_buffer.resize(buffer_size, 0.0f);
+        // Clamp feedback between 0.0 and 1.0
+        if (new_feedback < 0.0f) new_feedback = 0.0f;
+        if (new_feedback > 1.0f) new_feedback = 1.0f;
 
-        // Register input and output ports
-        input_port = jack_port_register(client, "input", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        output_port = jack_port_register(client, "output", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!input_port || !output_port) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomEcho: Failed to register JACK ports");
-        }
+        delay_time_ms.store(new_delay);
+        feedback.store(new_feedback);
 
-        // Set the process callback
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomEcho: Failed to set process callback");
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomEcho] Updated parameters: delay_time = " << new_delay
+                      << " ms, feedback = " << new_feedback << std::endl;
         }
+        return true;
+    }
 
-        // Activate the JACK client
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomEcho: Failed to activate JACK client");
-        }
+public:
+    PhantomEcho(const char* client_name = "PhantomEcho")
+        : phantom::Plugin(client_name), input_port(nullptr), output_port(nullptr),
+          delay_time_ms(500), feedback(0.5f), syncBeats(0.0f) {
+        // Allocate the delay buffer for the longest delay; tempo changes never reallocate.
+        delay_line.allocate(static_cast<size_t>(sample_rate) * MAX_DELAY_SECONDS);
+        tap.setFadeLength(static_cast<size_t>(sample_rate / 50)); // 20 ms crossfade
+        tap.snap(delay_time_ms.load() * sample_rate / 1000.0f - 1.0f);
+
+        // Register input and output ports
+        input_port = registerInput("input");
+        output_port = registerOutput("output");
 
-        // Launch the control thread for real-time parameter tuning
-        control_thread = std::thread(&PhantomEcho::control_loop, this);
+        // Activate JACK processing and start the control thread.
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
             std::cout << "[PhantomEcho] Initialized. Sample rate: " << sample_rate << " Hz, "
-                      << "Buffer size: " << buffer_size << " samples." << std::endl;
+                      << "Buffer size: " << delay_line.capacity() << " samples." << std::endl;
             std::cout << "[PhantomEcho] Default parameters: delay_time = " << delay_time_ms.load()
                       << " ms, feedback = " << feedback.load() << std::endl;
         }
     }
-
-    ~PhantomEcho() {
-        running.store(false);
-        if (control_thread.joinable()) {
-            control_thread.join();
-        }
-        if (client) {
-            jack_client_close(client);
-        }
-    }
-
-    // Runs until the user indicates to quit.
-    void run() {
-        {
-            std::lock_guard<std::mutex> lock(print_mutex);
-            std::cout << "[PhantomEcho] Running. Press Enter (with 'q' input in control) to exit." << std::endl;
-        }
-        // Wait until the control thread signals termination.
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::lock_guard<std::mutex> lock(print_mutex);
-        std::cout << "[PhantomEcho] Shutting down." << std::endl;
-    }
 };
 
 int main() {
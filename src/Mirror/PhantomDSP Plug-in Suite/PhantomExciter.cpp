@@ -11,70 +11,19 @@
 //
 // Compile with:
 //   g++ -std=c++11 PhantomExciter.cpp -ljack -lpthread -o PhantomExciter
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 
-class Biquad {
-public:
-    float b0, b1, b2, a1, a2;
-    float x1, x2, y1, y2;
-    Biquad() : b0(1), b1(0), b2(0), a1(0), a2(0),
-        x1(0), x2(0), y1(0), y2(0) {
-    }
-    inline float process(float x) {
-        float y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-        x2 = x1;
-        x1 = x;
-        y2 = y1;
-        y1 = y;
-        return y;
-    }
-    inline void reset() { x1 = x2 = y1 = y2 = 0; }
-};
-
-// High-shelf filter coefficient update using RBJ’s formulas.
-void updateHighShelf(Biquad& bq, float f0, float gain_dB, int fs) {
-    float A = powf(10.0f, gain_dB / 40.0f);
-    float w0 = 2.0f * M_PI * f0 / fs;
-    float cosw0 = cosf(w0);
-    float sinw0 = sinf(w0);
-    float S = 1.0f;  // Shelf slope
-    float alpha = sinw0 / 2.0f * sqrtf((A + 1.0f / A) * (1.0f / S - 1.0f) + 2.0f);
-
-    float b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha);
-    float b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
-    float b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha);
-    float a0 = (A + 1.0f) + (A - 1.0f) * cosw0 + 2.0f * sqrtf(A) * alpha;
-    float a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
-    float a2 = (A + 1.0f) + (A - 1.0f) * cosw0 - 2.0f * sqrtf(A) * alpha;
-
-    bq.b0 = b0 / a0;
-    bq.b1 = b1 / a0;
-    bq.b2 = b2 / a0;
-    bq.a1 = a1 / a0;
-    bq.a2 = a2 / a0;
-}
-
-class PhantomExciter {
+class PhantomExciter : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
 
     // Parameters (atomic for real-time updates)
     std::atomic<float> drive;         // Drive factor for saturation (≥ 1.0), e.g., 2.0.
@@ -84,26 +33,28 @@ private:
     std::atomic<float> outGain_dB;    // Output gain in dB (e.g., -10 to +10).
 
     // High-shelf filter for extracting high frequencies.
-    Biquad hsFilter;
+    const float shelfHz = 3000.0f;
+    phantom::Biquad hsFilter;
+    float appliedHsGain_dB;  // gain hsFilter's coefficients were computed for
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomExciter* exciter = static_cast<PhantomExciter*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(exciter->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(exciter->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
 
         // Retrieve parameters.
-        float currentDrive = exciter->drive.load();
-        float currentHsGain_dB = exciter->hsGain_dB.load();
-        float currentMix = exciter->mix.load();
-        float currentOutGain_dB = exciter->outGain_dB.load();
+        float currentDrive = drive.load();
+        float currentHsGain_dB = hsGain_dB.load();
+        float currentMix = mix.load();
+        float currentOutGain_dB = outGain_dB.load();
         // Convert output gain from dB to linear.
         float currentOutGain = powf(10.0f, currentOutGain_dB / 20.0f);
 
-        // Update high-shelf filter coefficients.
-        // We'll set a cutoff frequency for the high-shelf filter, e.g., 3000 Hz.
-        float cutoff = 3000.0f;
-        updateHighShelf(exciter->hsFilter, cutoff, currentHsGain_dB, exciter->sample_rate);
+        // Recompute the high-shelf coefficients only when the gain changes.
+        if (currentHsGain_dB != appliedHsGain_dB) {
+            hsFilter.set(phantom::Biquad::HIGHSHELF, shelfHz, 0.70710678f, currentHsGain_dB, sample_rate);
+            appliedHsGain_dB = currentHsGain_dB;
+        }
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             float dry = in[i];
@@ -111,7 +62,7 @@ private:
             float driven = currentDrive * dry;
             float saturated = tanhf(driven);
             // Process through high-shelf filter to emphasize high frequencies.
-            float excited = exciter->hsFilter.process(saturated);
+            float excited = hsFilter.process(saturated);
             // Apply output gain (converted from dB).
             excited *= currentOutGain;
             // Mix with dry signal.
@@ -121,48 +72,37 @@ private:
     }
 
     // Control thread: allows real-time adjustment of parameters.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomExciter] Enter parameters: drive, high-shelf gain (dB), mix (0-1), output gain (dB)\n"
-                    << "e.g., \"2.0 6.0 0.7 0.0\" (0.0 dB is unity) or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float newDrive, newHsGain, newMix, newOutGain_dB;
-            if (!(iss >> newDrive >> newHsGain >> newMix >> newOutGain_dB)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomExciter] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            if (newDrive < 1.0f) newDrive = 1.0f;
-            if (newMix < 0.0f) newMix = 0.0f;
-            if (newMix > 1.0f) newMix = 1.0f;
-            drive.store(newDrive);
-            hsGain_dB.store(newHsGain);
-            mix.store(newMix);
-            outGain_dB.store(newOutGain_dB);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomExciter] Updated parameters:" << std::endl;
-                std::cout << "  Drive = " << newDrive << std::endl;
-                std::cout << "  High-Shelf Gain = " << newHsGain << " dB" << std::endl;
-                std::cout << "  Mix = " << newMix << std::endl;
-                std::cout << "  Output Gain = " << newOutGain_dB << " dB" << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomExciter] Enter parameters: drive, high-shelf gain (dB), mix (0-1), output gain (dB)\n"
+            << "e.g., \"2.0 6.0 0.7 0.0\" (0.0 dB is unity) or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float newDrive, newHsGain, newMix, newOutGain_dB;
+        if (!(iss >> newDrive >> newHsGain >> newMix >> newOutGain_dB))
+            return false;
+        if (newDrive < 1.0f) newDrive = 1.0f;
+        if (newMix < 0.0f) newMix = 0.0f;
+        if (newMix > 1.0f) newMix = 1.0f;
+        drive.store(newDrive);
+        hsGain_dB.store(newHsGain);
+        mix.store(newMix);
+        outGain_dB.store(newOutGain_dB);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomExciter] Updated parameters:" << std::endl;
+            std::cout << "  Drive = " << newDrive << std::endl;
+            std::cout << "  High-Shelf Gain = " << newHsGain << " dB" << std::endl;
+            std::cout << "  Mix = " << newMix << std::endl;
+            std::cout << "  Output Gain = " << newOutGain_dB << " dB" << std::endl;
         }
+        return true;
     }
 
 public:
     PhantomExciter(const char* client_name = "PhantomExciter")
-        : client(nullptr), running(true)
+        : phantom::Plugin(client_name)
     {
         // Set default parameters.
         drive.store(2.0f);         // Default drive: 2.0
@@ -170,33 +110,13 @@ public:
         mix.store(0.7f);           // 70% processed signal
         outGain_dB.store(0.0f);    // 0.0 dB = unity gain (can be set from, say, -10 dB to +10 dB)
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomExciter: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomExciter: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomExciter: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomExciter: Failed to activate JACK client");
-        }
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
 
-        hsFilter.reset();
+        hsFilter.set(phantom::Biquad::HIGHSHELF, shelfHz, 0.70710678f, hsGain_dB.load(), sample_rate);
+        appliedHsGain_dB = hsGain_dB.load();
 
-        control_thread = std::thread(&PhantomExciter::control_loop, this);
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
@@ -208,22 +128,6 @@ public:
             std::cout << "  Output Gain = " << outGain_dB.load() << " dB" << std::endl;
         }
     }
-
-    ~PhantomExciter() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        std::cout << "[PhantomExciter] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomExciter] Shutting down." << std::endl;
-    }
 };
 
 int main() {
@@ -10,34 +10,22 @@
 // Compile with:
 //   g++ -std=c++11 PhantomFreqShifter.cpp -ljack -lpthread -o PhantomFreqShifter
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <vector>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <cstdlib>
 
 using namespace std;
 
-class PhantomFreqShifter {
+class PhantomFreqShifter : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
 
     // Parameters:
     atomic<float> shiftHz;  // Frequency shift in Hz (can be negative)
@@ -91,28 +79,27 @@ private:
     }
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomFreqShifter* shifter = static_cast<PhantomFreqShifter*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(shifter->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(shifter->out_port, nframes));
-
-        float currentShiftHz = shifter->shiftHz.load();
-        float currentMix = shifter->mix.load();
-        float dt = 1.0f / shifter->sample_rate;
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
+
+        float currentShiftHz = shiftHz.load();
+        float currentMix = mix.load();
+        float dt = 1.0f / sample_rate;
         float phaseInc = 2.0f * M_PI * currentShiftHz * dt;
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             float dry = in[i];
             // Get the imaginary part via Hilbert transform.
-            float imag = shifter->processHilbert(dry);
+            float imag = processHilbert(dry);
             // Form the analytic signal: (dry + j*imag)
             // Multiply by the complex exponential: exp(j*phase) = cos(phase) + j*sin(phase)
             // The shifted signal is: dry*cos(phase) - imag*sin(phase)
-            float shifted = dry * cosf(shifter->phase) - imag * sinf(shifter->phase);
+            float shifted = dry * cosf(phase) - imag * sinf(phase);
             // Advance phase.
-            shifter->phase += phaseInc;
-            if (shifter->phase >= 2.0f * M_PI)
-                shifter->phase -= 2.0f * M_PI;
+            phase += phaseInc;
+            if (phase >= 2.0f * M_PI)
+                phase -= 2.0f * M_PI;
             // Mix dry and shifted signals.
             out[i] = (1.0f - currentMix) * dry + currentMix * shifted;
         }
@@ -120,44 +107,33 @@ private:
     }
 
     // Control thread: allows real-time parameter updates.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomFreqShifter] Enter parameters: frequency shift (Hz) and mix (0.0-1.0)" << endl;
-                cout << "e.g., \"100 0.7\" (100 Hz shift, 70% shifted signal) or type 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newShiftHz, newMix;
-            if (!(iss >> newShiftHz >> newMix)) {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomFreqShifter] Invalid input. Please try again." << endl;
-                continue;
-            }
-            // No clamping needed for frequency shift; mix is clamped between 0 and 1.
-            if (newMix < 0.0f) newMix = 0.0f;
-            if (newMix > 1.0f) newMix = 1.0f;
-            shiftHz.store(newShiftHz);
-            mix.store(newMix);
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomFreqShifter] Updated parameters:" << endl;
-                cout << "  Frequency Shift = " << newShiftHz << " Hz" << endl;
-                cout << "  Mix = " << newMix << endl;
-            }
+    void printPrompt() override {
+        cout << "\n[PhantomFreqShifter] Enter parameters: frequency shift (Hz) and mix (0.0-1.0)" << endl;
+        cout << "e.g., \"100 0.7\" (100 Hz shift, 70% shifted signal) or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        float newShiftHz, newMix;
+        if (!(iss >> newShiftHz >> newMix))
+            return false;
+        // No clamping needed for frequency shift; mix is clamped between 0 and 1.
+        if (newMix < 0.0f) newMix = 0.0f;
+        if (newMix > 1.0f) newMix = 1.0f;
+        shiftHz.store(newShiftHz);
+        mix.store(newMix);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomFreqShifter] Updated parameters:" << endl;
+            cout << "  Frequency Shift = " << newShiftHz << " Hz" << endl;
+            cout << "  Mix = " << newMix << endl;
         }
+        return true;
     }
 
 public:
     PhantomFreqShifter(const char* client_name = "PhantomFreqShifter")
-        : client(nullptr), running(true), phase(0.0f)
+        : phantom::Plugin(client_name), phase(0.0f)
     {
         // Set default parameters.
         shiftHz.store(100.0f);  // Default frequency shift: 100 Hz.
@@ -166,33 +142,11 @@ public:
         // Initialize Hilbert transformer.
         initHilbertCoeffs();
 
-        // Open JACK client.
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomFreqShifter: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
         // Register mono input and output ports.
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw runtime_error("PhantomFreqShifter: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomFreqShifter: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomFreqShifter: Failed to activate JACK client");
-        }
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
 
-        control_thread = thread(&PhantomFreqShifter::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
         cout << "[PhantomFreqShifter] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
@@ -200,22 +154,6 @@ public:
         cout << "  Frequency Shift = " << shiftHz.load() << " Hz" << endl;
         cout << "  Mix = " << mix.load() << endl;
     }
-
-    ~PhantomFreqShifter() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomFreqShifter] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomFreqShifter] Shutting down." << endl;
-    }
 };
 
 int main() {
@@ -3,41 +3,58 @@
 // When the computed envelope of the input signal falls below a specified threshold,
 // the gate closes (outputting zero); otherwise, the original signal passes through.
 // Real-time adjustable parameters: threshold (in dB), attack (ms), and release (ms).
-
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+//
+// The channel count is given on the command line (default 2, up to 8). Envelope state
+// lives in one contiguous array with a slot per channel. When the detector is linked
+// every channel opens and closes together, keyed from the loudest channel.
+//
+// Optional sidechain inputs (up to 8) replace the gate's own input as the key: the
+// sidechains are combined by max or sum and all channels open together. A key filter
+// ("hpf <Hz>", "lpf <Hz>", 0 = off) band-limits whichever detector path is in use.
+//
+// Usage:
+//   ./PhantomGate [channels] [sidechains]
+
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
 
 // PhantomGate class encapsulates the JACK client and processing.
-class PhantomGate {
-private:
-    jack_client_t* client;
-    jack_port_t* in_left, * in_right, * out_left, * out_right;
-    int sample_rate;
+class PhantomGate : public phantom::Plugin {
+public:
+    static const int MAX_CHANNELS = 8;
+    static const int MAX_SIDECHAINS = 8;
 
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
+private:
+    int num_channels;
+    int num_sidechains;
+    std::vector<jack_port_t*> in_ports;
+    std::vector<jack_port_t*> out_ports;
+    std::vector<jack_port_t*> side_ports;
 
     // Gate parameters (atomic variables)
     // Threshold is specified in dB (e.g., -40 dB) and converted to a linear value.
     std::atomic<float> threshold_dB;
     std::atomic<float> attackTime;   // in milliseconds
     std::atomic<float> releaseTime;  // in milliseconds
+    std::atomic<bool> linked;        // all channels gate together
 
-    // Envelope detectors for left and right channels.
-    float leftEnvelope;
-    float rightEnvelope;
+    // Envelope detectors, one slot per channel.
+    std::vector<float> envelope;
+    // Key filters, one per detector lane (sidechains if present, else channels).
+    phantom::KeyFilter keyFilter;
+    // Port buffers for the current block.
+    std::vector<float*> in_bufs;
+    std::vector<float*> out_bufs;
+    std::vector<float*> side_bufs;
 
     // Helper: Convert dB value to a linear amplitude.
     inline float dBToLinear(float dB) {
@@ -45,143 +62,142 @@ private:
     }
 
     // JACK process callback: updates the envelope for each sample and gates the signal.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomGate* gate = static_cast<PhantomGate*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(gate->in_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(gate->in_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(gate->out_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(gate->out_right, nframes));
-
-        float dt = 1.0f / gate->sample_rate; // seconds per sample
+    int process(jack_nframes_t nframes) override {
+        const int nch = num_channels;
+        float** in = in_bufs.data();
+        float** out = out_bufs.data();
+        for (int c = 0; c < nch; c++) {
+            in[c] = audioBuffer(in_ports[c], nframes);
+            out[c] = audioBuffer(out_ports[c], nframes);
+        }
+
+        const int nsc = num_sidechains;
+        float** side = side_bufs.data();
+        for (int k = 0; k < nsc; k++)
+            side[k] = audioBuffer(side_ports[k], nframes);
+
+        float dt = 1.0f / sample_rate; // seconds per sample
         float dt_ms = dt * 1000.0f;
 
         // Compute smoothing coefficients based on attack/release times.
-        float att_coeff = expf(-dt_ms / gate->attackTime.load());
-        float rel_coeff = expf(-dt_ms / gate->releaseTime.load());
+        float att_coeff = expf(-dt_ms / attackTime.load());
+        float rel_coeff = expf(-dt_ms / releaseTime.load());
 
         // Convert threshold from dB to linear amplitude.
-        float linThreshold = gate->dBToLinear(gate->threshold_dB.load());
+        float linThreshold = dBToLinear(threshold_dB.load());
+        bool link = linked.load();
+        float* env = envelope.data();
+        keyFilter.refresh();
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
-            // Process left channel:
-            float sampleL = inL[i];
-            float absL = fabs(sampleL);
-            if (absL > gate->leftEnvelope)
-                gate->leftEnvelope = att_coeff * gate->leftEnvelope + (1.0f - att_coeff) * absL;
-            else
-                gate->leftEnvelope = rel_coeff * gate->leftEnvelope + (1.0f - rel_coeff) * absL;
-
-            // Process right channel:
-            float sampleR = inR[i];
-            float absR = fabs(sampleR);
-            if (absR > gate->rightEnvelope)
-                gate->rightEnvelope = att_coeff * gate->rightEnvelope + (1.0f - att_coeff) * absR;
-            else
-                gate->rightEnvelope = rel_coeff * gate->rightEnvelope + (1.0f - rel_coeff) * absR;
-
-            // If the envelope is below threshold, output silence; otherwise, pass the input.
-            outL[i] = (gate->leftEnvelope < linThreshold) ? 0.0f : sampleL;
-            outR[i] = (gate->rightEnvelope < linThreshold) ? 0.0f : sampleR;
+            if (nsc > 0 || link) {
+                // One shared envelope, keyed from the sidechains or the loudest channel.
+                float key = 0.0f;
+                if (nsc > 0) {
+                    for (int k = 0; k < nsc; k++)
+                        key = keyFilter.combine(key, keyFilter.detect(k, side[k][i]));
+                }
+                else {
+                    for (int c = 0; c < nch; c++)
+                        key = std::max(key, keyFilter.detect(c, in[c][i]));
+                }
+                float coeff = (key > env[0]) ? att_coeff : rel_coeff;
+                env[0] = coeff * env[0] + (1.0f - coeff) * key;
+                float open = (env[0] < linThreshold) ? 0.0f : 1.0f;
+                for (int c = 0; c < nch; c++)
+                    out[c][i] = in[c][i] * open;
+            }
+            else {
+                for (int c = 0; c < nch; c++) {
+                    float sample = in[c][i];
+                    float absS = keyFilter.detect(c, sample);
+                    float coeff = (absS > env[c]) ? att_coeff : rel_coeff;
+                    env[c] = coeff * env[c] + (1.0f - coeff) * absS;
+                    // If the envelope is below threshold, output silence; otherwise, pass the input.
+                    out[c][i] = (env[c] < linThreshold) ? 0.0f : sample;
+                }
+            }
         }
         return 0;
     }
 
     // Control thread: allows real-time parameter updates via the console.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomGate] Enter parameters: threshold (dB), attack (ms), release (ms)\n"
-                    << "e.g., \"-40 10 50\" or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float newThreshold, newAttack, newRelease;
-            if (!(iss >> newThreshold >> newAttack >> newRelease)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomGate] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            threshold_dB.store(newThreshold);
-            attackTime.store(newAttack);
-            releaseTime.store(newRelease);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomGate] Updated parameters: threshold = " << newThreshold
-                    << " dB, attack = " << newAttack << " ms, release = " << newRelease << " ms" << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomGate] Enter parameters: threshold (dB), attack (ms), release (ms), [link 0/1]\n"
+            << "e.g., \"-40 10 50\", \"hpf 150\", \"lpf 4000\", \"mode max|sum\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        bool valid;
+        if (keyFilter.handleCommand(line, "PhantomGate", print_mutex, valid))
+            return valid;
+        std::istringstream iss(line);
+        float newThreshold, newAttack, newRelease;
+        if (!(iss >> newThreshold >> newAttack >> newRelease))
+            return false;
+        int newLink;
+        if (iss >> newLink)
+            linked.store(newLink != 0);
+        threshold_dB.store(newThreshold);
+        attackTime.store(newAttack);
+        releaseTime.store(newRelease);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomGate] Updated parameters: threshold = " << newThreshold
+                << " dB, attack = " << newAttack << " ms, release = " << newRelease << " ms, "
+                << (linked.load() ? "linked" : "unlinked") << std::endl;
         }
+        return true;
     }
 
 public:
-    PhantomGate(const char* client_name = "PhantomGate")
-        : client(nullptr), running(true), leftEnvelope(0.0f), rightEnvelope(0.0f)
+    PhantomGate(int channels = 2, int sidechains = 0, const char* client_name = "PhantomGate")
+        : phantom::Plugin(client_name), num_channels(channels), num_sidechains(sidechains)
     {
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            throw std::runtime_error("PhantomGate: Channel count must be between 1 and 8");
+        }
+        if (sidechains < 0 || sidechains > MAX_SIDECHAINS) {
+            throw std::runtime_error("PhantomGate: Sidechain count must be between 0 and 8");
+        }
+        envelope.assign(num_channels, 0.0f);
+        in_bufs.assign(num_channels, nullptr);
+        out_bufs.assign(num_channels, nullptr);
+        side_bufs.assign(num_sidechains, nullptr);
+
         // Set default parameters.
         threshold_dB.store(-40.0f);
         attackTime.store(10.0f);
         releaseTime.store(50.0f);
+        linked.store(false);
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomGate: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_left = jack_port_register(client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        in_right = jack_port_register(client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_left || !in_right || !out_left || !out_right) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomGate: Failed to register JACK ports");
-        }
+        keyFilter.allocate((num_sidechains > 0) ? num_sidechains : num_channels, sample_rate);
 
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomGate: Failed to set process callback");
+        for (int c = 0; c < num_channels; c++) {
+            jack_port_t* in = registerInput(phantom::channelPortName("in", c, num_channels));
+            jack_port_t* out = registerOutput(phantom::channelPortName("out", c, num_channels));
+            in_ports.push_back(in);
+            out_ports.push_back(out);
         }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomGate: Failed to activate JACK client");
+        for (int k = 0; k < num_sidechains; k++) {
+            side_ports.push_back(registerInput(phantom::numberedPortName("side", k, num_sidechains)));
         }
 
-        control_thread = std::thread(&PhantomGate::control_loop, this);
+        activate();
 
         std::lock_guard<std::mutex> lock(print_mutex);
-        std::cout << "[PhantomGate] Initialized. Sample rate: " << sample_rate << " Hz" << std::endl;
+        std::cout << "[PhantomGate] Initialized. Sample rate: " << sample_rate << " Hz, channels: " << num_channels
+            << ", sidechains: " << num_sidechains << std::endl;
         std::cout << "[PhantomGate] Default parameters: threshold = " << threshold_dB.load()
             << " dB, attack = " << attackTime.load() << " ms, release = " << releaseTime.load() << " ms" << std::endl;
     }
-
-    ~PhantomGate() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        std::cout << "[PhantomGate] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomGate] Shutting down." << std::endl;
-    }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomGate gate;
+        int channels = (argc > 1) ? std::atoi(argv[1]) : 2;
+        int sidechains = (argc > 2) ? std::atoi(argv[2]) : 0;
+        PhantomGate gate(channels, sidechains);
         gate.run();
     }
     catch (const std::exception& e) {
@@ -12,21 +12,16 @@
 // Compile with:
 //   g++ -std=c++11 PhantomGranular.cpp -ljack -lpthread -o PhantomGranular
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <vector>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <cstdlib>
+#include <cstdint>
 #include <ctime>
 
 using namespace std;
@@ -40,16 +35,10 @@ struct Grain {
     int remaining;   // Samples remaining to play
 };
 
-class PhantomGranular {
+class PhantomGranular : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
 
     // Granular parameters (atomic for real-time updates).
     atomic<float> grainSize_ms;   // Grain duration in milliseconds.
@@ -67,6 +56,7 @@ private:
     vector<float> delayBuffer;
     size_t bufferSize;            // Number of samples (e.g., sample_rate * 2 for 2 seconds).
     size_t writeIndex;            // Current write pointer.
+    phantom::Noise noise;         // Grain start jitter.
 
     // Active grains.
     vector<Grain> activeGrains;
@@ -92,7 +82,7 @@ private:
         float basePos = static_cast<float>(writeIndex) - grainSize_samples;
         if (basePos < 0) basePos += bufferSize;
         // Apply randomness: offset in range [-randomness * grainSize_samples, +randomness * grainSize_samples]
-        float randFactor = ((static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f); // -1 to 1
+        float randFactor = noise.bipolar(); // -1 to 1
         float offset = randFactor * randomness.load() * grainSize_samples;
         grain.startPos = basePos + offset;
         // Wrap-around:
@@ -137,80 +127,68 @@ private:
     }
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomGranular* pg = static_cast<PhantomGranular*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(pg->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(pg->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             float dry = in[i];
             // Write the input sample into the delay buffer.
-            pg->delayBuffer[pg->writeIndex] = dry;
-            pg->writeIndex = (pg->writeIndex + 1) % pg->bufferSize;
+            delayBuffer[writeIndex] = dry;
+            writeIndex = (writeIndex + 1) % bufferSize;
 
             // Increment sample counter and check for grain spawn.
-            pg->sampleCounter++;
-            if (pg->sampleCounter >= pg->grainTriggerInterval) {
-                pg->spawnGrain();
-                pg->sampleCounter = 0;
+            sampleCounter++;
+            if (sampleCounter >= grainTriggerInterval) {
+                spawnGrain();
+                sampleCounter = 0;
             }
 
             // Sum active grains.
-            float granularOutput = pg->processGrains();
+            float granularOutput = processGrains();
 
             // Final output is mix of dry and granular outputs.
-            float finalOutput = pg->mix.load() * granularOutput + (1.0f - pg->mix.load()) * dry;
+            float finalOutput = mix.load() * granularOutput + (1.0f - mix.load()) * dry;
             out[i] = finalOutput;
         }
         return 0;
     }
 
     // Control thread: update parameters via console.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomGranular] Enter parameters: grainSize (ms), grainDensity (grains/sec), pitchShift (multiplier), mix (0-1), randomness (0-1)" << endl;
-                cout << "e.g., \"100 10 1.2 0.5 0.5\" or type 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newGrainSize, newDensity, newPitchShift, newMix, newRandomness;
-            if (!(iss >> newGrainSize >> newDensity >> newPitchShift >> newMix >> newRandomness)) {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomGranular] Invalid input. Please try again." << endl;
-                continue;
-            }
-            // Update parameters.
-            grainSize_ms.store(newGrainSize);
-            pitchShift.store(newPitchShift);
-            mix.store(newMix);
-            randomness.store(newRandomness);
-            // Recompute derived parameters.
-            grainSize_samples = static_cast<int>(newGrainSize * sample_rate / 1000.0f);
-            if (newDensity <= 0) newDensity = 1;
-            grainTriggerInterval = static_cast<int>(sample_rate / newDensity);
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomGranular] Updated parameters:" << endl;
-                cout << "  Grain Size = " << newGrainSize << " ms (" << grainSize_samples << " samples)" << endl;
-                cout << "  Grain Density = " << newDensity << " grains/sec (interval = " << grainTriggerInterval << " samples)" << endl;
-                cout << "  Pitch Shift = " << newPitchShift << endl;
-                cout << "  Mix = " << newMix << endl;
-                cout << "  Randomness = " << newRandomness << endl;
-            }
+    void printPrompt() override {
+        cout << "\n[PhantomGranular] Enter parameters: grainSize (ms), grainDensity (grains/sec), pitchShift (multiplier), mix (0-1), randomness (0-1)" << endl;
+        cout << "e.g., \"100 10 1.2 0.5 0.5\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        float newGrainSize, newDensity, newPitchShift, newMix, newRandomness;
+        if (!(iss >> newGrainSize >> newDensity >> newPitchShift >> newMix >> newRandomness))
+            return false;
+        // Update parameters.
+        grainSize_ms.store(newGrainSize);
+        pitchShift.store(newPitchShift);
+        mix.store(newMix);
+        randomness.store(newRandomness);
+        // Recompute derived parameters.
+        grainSize_samples = static_cast<int>(newGrainSize * sample_rate / 1000.0f);
+        if (newDensity <= 0) newDensity = 1;
+        grainTriggerInterval = static_cast<int>(sample_rate / newDensity);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomGranular] Updated parameters:" << endl;
+            cout << "  Grain Size = " << newGrainSize << " ms (" << grainSize_samples << " samples)" << endl;
+            cout << "  Grain Density = " << newDensity << " grains/sec (interval = " << grainTriggerInterval << " samples)" << endl;
+            cout << "  Pitch Shift = " << newPitchShift << endl;
+            cout << "  Mix = " << newMix << endl;
+            cout << "  Randomness = " << newRandomness << endl;
         }
+        return true;
     }
 
 public:
     PhantomGranular(const char* client_name = "PhantomGranular")
-        : client(nullptr), running(true), writeIndex(0), sampleCounter(0)
+        : phantom::Plugin(client_name), writeIndex(0), sampleCounter(0)
     {
         // Initialize default parameters.
         grainSize_ms.store(100.0f);   // 100 ms grains.
@@ -234,14 +212,7 @@ public:
         activeGrains.clear();
 
         // Seed random number generator.
-        srand(static_cast<unsigned int>(time(nullptr)));
-
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomGranular: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
+        noise.setSeed(static_cast<uint32_t>(time(nullptr)));
         // Recompute derived parameters with actual sample rate.
         grainSize_samples = static_cast<int>(grainSize_ms.load() * sample_rate / 1000.0f);
         grainTriggerInterval = static_cast<int>(sample_rate / grainDensity.load());
@@ -249,24 +220,10 @@ public:
         delayBuffer.resize(bufferSize, 0.0f);
         writeIndex = 0;
 
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw runtime_error("PhantomGranular: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomGranular: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomGranular: Failed to activate JACK client");
-        }
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
 
-        control_thread = thread(&PhantomGranular::control_loop, this);
+        activate();
 
         {
             lock_guard<mutex> lock(print_mutex);
@@ -279,22 +236,6 @@ public:
             cout << "  Randomness = " << randomness.load() << endl;
         }
     }
-
-    ~PhantomGranular() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomGranular] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomGranular] Shutting down." << endl;
-    }
 };
 
 int main() {
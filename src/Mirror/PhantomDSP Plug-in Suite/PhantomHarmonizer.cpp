@@ -6,36 +6,24 @@
 // Compile with:
 //   g++ -std=c++11 PhantomHarmonizer.cpp -ljack -lpthread -o PhantomHarmonizer
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <vector>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 
 // Utility: Convert semitones to pitch shift ratio.
 inline float semitonesToRatio(float semitones) {
     return powf(2.0f, semitones / 12.0f);
 }
 
-class PhantomHarmonizer {
+class PhantomHarmonizer : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
 
     // Harmonizer parameters.
     std::atomic<float> semitoneShift;  // in semitones (e.g., 4.0 for major third up)
@@ -53,106 +41,87 @@ private:
     float virtualReadIndex;    // floating-point read pointer
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomHarmonizer* ph = static_cast<PhantomHarmonizer*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(ph->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(ph->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
 
         // Update derived parameters.
-        float currentSemitone = ph->semitoneShift.load();
-        ph->pitchRatio = semitonesToRatio(currentSemitone);
-        float currentBaseDelay_ms = ph->baseDelay_ms.load();
-        ph->baseDelaySamples = currentBaseDelay_ms * ph->sample_rate / 1000.0f;
+        float currentSemitone = semitoneShift.load();
+        pitchRatio = semitonesToRatio(currentSemitone);
+        float currentBaseDelay_ms = baseDelay_ms.load();
+        baseDelaySamples = currentBaseDelay_ms * sample_rate / 1000.0f;
 
-        float currentMix = ph->mix.load();
+        float currentMix = mix.load();
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             float dry = in[i];
 
             // Write current sample to delay buffer.
-            ph->delayBuffer[ph->writeIndex] = dry;
+            delayBuffer[writeIndex] = dry;
 
             // Read the pitch-shifted sample from the delay buffer using the virtual read pointer.
             // Use linear interpolation.
-            size_t index0 = static_cast<size_t>(ph->virtualReadIndex) % ph->bufferSize;
-            size_t index1 = (index0 + 1) % ph->bufferSize;
-            float frac = ph->virtualReadIndex - floorf(ph->virtualReadIndex);
-            float shiftedSample = (1.0f - frac) * ph->delayBuffer[index0] + frac * ph->delayBuffer[index1];
+            size_t index0 = static_cast<size_t>(virtualReadIndex) % bufferSize;
+            size_t index1 = (index0 + 1) % bufferSize;
+            float frac = virtualReadIndex - floorf(virtualReadIndex);
+            float shiftedSample = (1.0f - frac) * delayBuffer[index0] + frac * delayBuffer[index1];
 
             // Mix the dry and pitch-shifted signals.
             out[i] = (1.0f - currentMix) * dry + currentMix * shiftedSample;
 
             // Increment write pointer.
-            ph->writeIndex = (ph->writeIndex + 1) % ph->bufferSize;
+            writeIndex = (writeIndex + 1) % bufferSize;
 
             // Increment the virtual read pointer by pitchRatio.
-            ph->virtualReadIndex += ph->pitchRatio;
+            virtualReadIndex += pitchRatio;
 
             // Check the delay (the difference between writeIndex and virtualReadIndex, modulo buffer size).
             // We want the delay to remain roughly equal to baseDelaySamples.
-            float delay = static_cast<float>(ph->writeIndex) - ph->virtualReadIndex;
+            float delay = static_cast<float>(writeIndex) - virtualReadIndex;
             if (delay < 0)
-                delay += ph->bufferSize;
+                delay += bufferSize;
             float tolerance = 5.0f; // samples tolerance.
-            if (delay > ph->baseDelaySamples + tolerance) {
+            if (delay > baseDelaySamples + tolerance) {
                 // Reinitialize virtualReadIndex to maintain the desired delay.
-                ph->virtualReadIndex = static_cast<float>(ph->writeIndex) - ph->baseDelaySamples;
-                if (ph->virtualReadIndex < 0)
-                    ph->virtualReadIndex += ph->bufferSize;
+                virtualReadIndex = static_cast<float>(writeIndex) - baseDelaySamples;
+                if (virtualReadIndex < 0)
+                    virtualReadIndex += bufferSize;
             }
         }
         return 0;
     }
 
     // Control thread: update harmonizer parameters in real time.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomHarmonizer] Enter parameters: semitone shift (e.g., 4.0), mix (0-1), base delay (ms) (e.g., 20)\n"
-                    << "e.g., \"4.0 0.5 20\" or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float newSemitones, newMix, newBaseDelay;
-            if (!(iss >> newSemitones >> newMix >> newBaseDelay)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomHarmonizer] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            semitoneShift.store(newSemitones);
-            mix.store(newMix);
-            baseDelay_ms.store(newBaseDelay);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomHarmonizer] Updated parameters: semitone shift = " << newSemitones
-                    << " semitones, mix = " << newMix << ", base delay = " << newBaseDelay << " ms" << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomHarmonizer] Enter parameters: semitone shift (e.g., 4.0), mix (0-1), base delay (ms) (e.g., 20)\n"
+            << "e.g., \"4.0 0.5 20\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float newSemitones, newMix, newBaseDelay;
+        if (!(iss >> newSemitones >> newMix >> newBaseDelay))
+            return false;
+        semitoneShift.store(newSemitones);
+        mix.store(newMix);
+        baseDelay_ms.store(newBaseDelay);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomHarmonizer] Updated parameters: semitone shift = " << newSemitones
+                << " semitones, mix = " << newMix << ", base delay = " << newBaseDelay << " ms" << std::endl;
         }
+        return true;
     }
 
 public:
     PhantomHarmonizer(const char* client_name = "PhantomHarmonizer")
-        : client(nullptr), running(true), writeIndex(0), virtualReadIndex(0.0f)
+        : phantom::Plugin(client_name), writeIndex(0), virtualReadIndex(0.0f)
     {
         // Set default parameters.
         semitoneShift.store(4.0f);  // Major third up.
         mix.store(0.5f);            // 50% mix.
         baseDelay_ms.store(20.0f);   // 20 ms base delay.
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomHarmonizer: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
         // Choose a delay buffer size that provides headroom. For a 20 ms delay at 44100 Hz, that's about 882 samples.
         // We choose a fixed size (e.g., 2048 samples) for simplicity.
         bufferSize = 2048;
@@ -166,24 +135,10 @@ public:
             virtualReadIndex += bufferSize;
 
         // Register JACK ports.
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomHarmonizer: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomHarmonizer: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomHarmonizer: Failed to activate JACK client");
-        }
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
 
-        control_thread = std::thread(&PhantomHarmonizer::control_loop, this);
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
@@ -192,22 +147,6 @@ public:
                 << " semitones, mix = " << mix.load() << ", base delay = " << baseDelay_ms.load() << " ms" << std::endl;
         }
     }
-
-    ~PhantomHarmonizer() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        std::cout << "[PhantomHarmonizer] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomHarmonizer] Shutting down." << std::endl;
-    }
 };
 
 int main() {
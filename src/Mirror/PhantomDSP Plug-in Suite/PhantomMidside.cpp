@@ -9,38 +9,39 @@
 //   R_out = midGain * mid - sideGain * side
 //
 // Real-time control via a console allows updating midGain and sideGain.
+//
+// The channel count is given on the command line (2, 4, 6 or 8; default 2).
+// Channels are processed as stereo pairs: L/R (and the rear pair for quad), plus
+// the surround pairs for 5.1/7.1. Centre and LFE are passed through untouched.
+//
 // Compile with:
 //   g++ -std=c++11 PhantomMidSide.cpp -ljack -lpthread -o PhantomMidSide
+// Usage:
+//   ./PhantomMidSide [channels]
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <string>
+#include <vector>
+#include <cstdlib>
 
 using namespace std;
 
-class PhantomMidSide {
-private:
-    jack_client_t* client;
-    jack_port_t* in_left;
-    jack_port_t* in_right;
-    jack_port_t* out_left;
-    jack_port_t* out_right;
-    int sample_rate;
+class PhantomMidSide : public phantom::Plugin {
+public:
+    static const int MAX_CHANNELS = 8;
 
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
+private:
+    int num_channels;
+    vector<jack_port_t*> in_ports;
+    vector<jack_port_t*> out_ports;
+    vector<int> pairLeft, pairRight, singles;
+    vector<float*> in_bufs, out_bufs;
 
     // User-controllable parameters: mid and side gain.
     // When both are set to 1.0, the output is identical to the input.
@@ -48,122 +49,94 @@ private:
     atomic<float> sideGain;  // Default 1.0.
 
     // JACK process callback: processes each block of audio.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomMidSide* pms = static_cast<PhantomMidSide*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(pms->in_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(pms->in_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(pms->out_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(pms->out_right, nframes));
-
-        float currentMidGain = pms->midGain.load();
-        float currentSideGain = pms->sideGain.load();
+    int process(jack_nframes_t nframes) override {
+        for (int c = 0; c < num_channels; c++) {
+            in_bufs[c] = audioBuffer(in_ports[c], nframes);
+            out_bufs[c] = audioBuffer(out_ports[c], nframes);
+        }
 
-        // Process each sample.
-        for (jack_nframes_t i = 0; i < nframes; i++) {
-            float L = inL[i];
-            float R = inR[i];
-            // Convert stereo to mid-side.
-            float mid = (L + R) * 0.5f;
-            float side = (L - R) * 0.5f;
-            // Apply gain adjustments.
-            float L_out = currentMidGain * mid + currentSideGain * side;
-            float R_out = currentMidGain * mid - currentSideGain * side;
-            // Write outputs.
-            outL[i] = L_out;
-            outR[i] = R_out;
+        float currentMidGain = midGain.load();
+        float currentSideGain = sideGain.load();
+
+        // Process each stereo pair.
+        for (size_t p = 0; p < pairLeft.size(); p++) {
+            const float* inL = in_bufs[pairLeft[p]];
+            const float* inR = in_bufs[pairRight[p]];
+            float* outL = out_bufs[pairLeft[p]];
+            float* outR = out_bufs[pairRight[p]];
+            for (jack_nframes_t i = 0; i < nframes; i++) {
+                float L = inL[i];
+                float R = inR[i];
+                // Convert stereo to mid-side.
+                float mid = (L + R) * 0.5f;
+                float side = (L - R) * 0.5f;
+                // Apply gain adjustments and write outputs.
+                outL[i] = currentMidGain * mid + currentSideGain * side;
+                outR[i] = currentMidGain * mid - currentSideGain * side;
+            }
+        }
+        // Unpaired channels (centre, LFE) pass straight through.
+        for (int c : singles) {
+            const float* in = in_bufs[c];
+            float* out = out_bufs[c];
+            for (jack_nframes_t i = 0; i < nframes; i++)
+                out[i] = in[i];
         }
         return 0;
     }
 
     // Control thread: allows real-time updates of mid and side gain.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomMidSide] Enter new parameters (midGain sideGain), or type 'q' to quit:" << endl;
-                cout << "For example: \"1.0 0.5\" (mid at unity, side reduced to 0.5): ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newMidGain, newSideGain;
-            if (!(iss >> newMidGain >> newSideGain)) {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomMidSide] Invalid input. Please try again." << endl;
-                continue;
-            }
-            midGain.store(newMidGain);
-            sideGain.store(newSideGain);
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomMidSide] Updated parameters: midGain = " << newMidGain
-                    << ", sideGain = " << newSideGain << endl;
-            }
+    void printPrompt() override {
+        cout << "\n[PhantomMidSide] Enter new parameters (midGain sideGain), or type 'q' to quit:" << endl;
+        cout << "For example: \"1.0 0.5\" (mid at unity, side reduced to 0.5): ";
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        float newMidGain, newSideGain;
+        if (!(iss >> newMidGain >> newSideGain))
+            return false;
+        midGain.store(newMidGain);
+        sideGain.store(newSideGain);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomMidSide] Updated parameters: midGain = " << newMidGain
+                << ", sideGain = " << newSideGain << endl;
         }
+        return true;
     }
 
 public:
-    PhantomMidSide(const char* client_name = "PhantomMidSide")
-        : client(nullptr), running(true), midGain(1.0f), sideGain(1.0f)
+    PhantomMidSide(int channels = 2, const char* client_name = "PhantomMidSide")
+        : phantom::Plugin(client_name), num_channels(channels), midGain(1.0f), sideGain(1.0f)
     {
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomMidSide: Failed to open JACK client");
+        if (channels < 2 || channels > MAX_CHANNELS || channels % 2 != 0) {
+            throw runtime_error("PhantomMidSide: Channel count must be 2, 4, 6 or 8");
         }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_left = jack_port_register(client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        in_right = jack_port_register(client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_left || !in_right || !out_left || !out_right) {
-            jack_client_close(client);
-            throw runtime_error("PhantomMidSide: Failed to register JACK ports");
+        phantom::stereoPairs(num_channels, pairLeft, pairRight, singles);
+        in_bufs.assign(num_channels, nullptr);
+        out_bufs.assign(num_channels, nullptr);
+
+        for (int c = 0; c < num_channels; c++) {
+            jack_port_t* in = registerInput(phantom::channelPortName("in", c, num_channels));
+            jack_port_t* out = registerOutput(phantom::channelPortName("out", c, num_channels));
+            in_ports.push_back(in);
+            out_ports.push_back(out);
         }
 
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomMidSide: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomMidSide: Failed to activate JACK client");
-        }
-
-        control_thread = thread(&PhantomMidSide::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
-        cout << "[PhantomMidSide] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
+        cout << "[PhantomMidSide] Initialized. Sample rate: " << sample_rate << " Hz, channels: " << num_channels
+            << " (" << pairLeft.size() << " stereo pairs)" << endl;
         cout << "[PhantomMidSide] Default midGain = " << midGain.load() << ", sideGain = " << sideGain.load() << " (center)" << endl;
     }
-
-    ~PhantomMidSide() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomMidSide] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomMidSide] Shutting down." << endl;
-    }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomMidSide midSide;
+        int channels = (argc > 1) ? atoi(argv[1]) : 2;
+        PhantomMidSide midSide(channels);
         midSide.run();
     }
     catch (const exception& e) {
@@ -6,85 +6,40 @@
 // Compile with:
 //   g++ -std=c++11 PhantomMultibandComp.cpp -ljack -lpthread -o PhantomMultibandComp
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
-
-// ---------------------------------------------------
-// Simple first-order filter state structures
-struct LPF {
-    float y_prev;
-    LPF() : y_prev(0.0f) {}
-};
-
-struct HPF {
-    float x_prev;
-    float y_prev;
-    HPF() : x_prev(0.0f), y_prev(0.0f) {}
-};
-
-// ---------------------------------------------------
-// First-order low-pass filter function.
-// Uses: y[n] = α * x[n] + (1-α) * y[n-1], with α = dt/(RC+dt)
-inline float processLPF(float x, LPF& state, float cutoff, float dt) {
-    float RC = 1.0f / (2.0f * M_PI * cutoff);
-    float alpha = dt / (RC + dt);
-    float y = alpha * x + (1.0f - alpha) * state.y_prev;
-    state.y_prev = y;
-    return y;
-}
-
-// First-order high-pass filter function.
-// Uses: y[n] = β * (y[n-1] + x[n] - x[n-1]), with β = RC/(RC+dt)
-inline float processHPF(float x, HPF& state, float cutoff, float dt) {
-    float RC = 1.0f / (2.0f * M_PI * cutoff);
-    float beta = RC / (RC + dt);
-    float y = beta * (state.y_prev + x - state.x_prev);
-    state.x_prev = x;
-    state.y_prev = y;
-    return y;
-}
 
 // ---------------------------------------------------
 // PhantomMultibandComp class
-class PhantomMultibandComp {
+class PhantomMultibandComp : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_left, * in_right, * out_left, * out_right;
-    int sample_rate;
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
 
     // Fixed crossover frequencies:
     const float F1 = 200.0f;   // between Band 1 and 2
     const float F2 = 1000.0f;  // between Band 2 and 3
     const float F3 = 5000.0f;  // between Band 3 and 4
 
-    // Filter states for splitting (per channel, index 0=left, 1=right)
+    // Band-split filters (per channel, index 0=left, 1=right). The crossovers
+    // are fixed, so the coefficients are set once in the constructor.
     // Band 1 (Low): LPF at F1.
-    LPF lpf_low[2];
+    phantom::OnePoleLP lpf_low[2];
 
     // Band 2 (Low-Mid): HPF at F1, then LPF at F2.
-    HPF hpf_band2[2];
-    LPF lpf_band2[2];
+    phantom::OnePoleHP hpf_band2[2];
+    phantom::OnePoleLP lpf_band2[2];
 
     // Band 3 (High-Mid): HPF at F2, then LPF at F3.
-    HPF hpf_band3[2];
-    LPF lpf_band3[2];
+    phantom::OnePoleHP hpf_band3[2];
+    phantom::OnePoleLP lpf_band3[2];
 
     // Band 4 (High): HPF at F3.
-    HPF hpf_band4[2];
+    phantom::OnePoleHP hpf_band4[2];
 
     // Compressor parameters for each band (4 bands).
     // Each parameter is stored as an atomic float.
@@ -97,85 +52,95 @@ private:
     // Envelope state for compressor (per band, per channel: [band][channel])
     float envelope[4][2];
 
+    // Per-band detector and gain settings, read from the atomics once per block.
+    struct BandState {
+        float threshold_lin;
+        float exponent;      // 1/ratio - 1
+        float attack_coeff;
+        float release_coeff;
+        float makeup;
+    } bandState[4];
+
     // Helper function to convert dB to linear.
     inline float dBToLinear(float dB) {
         return powf(10.0f, dB / 20.0f);
     }
 
-    // Compressor function: processes a sample x for a given band and channel.
-    float compressSample(float x, int band, int channel, float dt) {
-        float threshold_dB = compThreshold[band].load();
-        float threshold_lin = dBToLinear(threshold_dB); // typically < 1 if threshold_dB is negative.
-        float ratio = compRatio[band].load();
-        float attack_ms = compAttack[band].load();
-        float release_ms = compRelease[band].load();
-        float makeup = compMakeup[band].load();
-
-        // Compute attack and release coefficients.
-        float attack_coeff = expf(-dt * 1000.0f / attack_ms);
-        float release_coeff = expf(-dt * 1000.0f / release_ms);
+    // Reads the band parameters and derives the per-sample constants.
+    void updateBandState(float dt) {
+        for (int band = 0; band < 4; band++) {
+            BandState& st = bandState[band];
+            st.threshold_lin = dBToLinear(compThreshold[band].load()); // typically < 1 if threshold_dB is negative.
+            st.exponent = 1.0f / compRatio[band].load() - 1.0f;
+            st.attack_coeff = expf(-dt * 1000.0f / compAttack[band].load());
+            st.release_coeff = expf(-dt * 1000.0f / compRelease[band].load());
+            st.makeup = compMakeup[band].load();
+        }
+    }
 
+    // Compressor function: processes a sample x for a given band and channel.
+    float compressSample(float x, int band, int channel) {
+        const BandState& st = bandState[band];
         float x_abs = fabs(x);
         float& env = envelope[band][channel];
         if (x_abs > env)
-            env = attack_coeff * env + (1.0f - attack_coeff) * x_abs;
+            env = st.attack_coeff * env + (1.0f - st.attack_coeff) * x_abs;
         else
-            env = release_coeff * env + (1.0f - release_coeff) * x_abs;
+            env = st.release_coeff * env + (1.0f - st.release_coeff) * x_abs;
 
         float gain = 1.0f;
-        if (env > threshold_lin && threshold_lin > 0)
-            gain = powf(env / threshold_lin, 1.0f / ratio - 1.0f);
+        if (env > st.threshold_lin && st.threshold_lin > 0)
+            gain = powf(env / st.threshold_lin, st.exponent);
 
-        return x * gain * makeup;
+        return x * gain * st.makeup;
     }
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomMultibandComp* comp = static_cast<PhantomMultibandComp*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(comp->in_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(comp->in_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(comp->out_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(comp->out_right, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* inL = audioBuffer(in_left, nframes);
+        float* inR = audioBuffer(in_right, nframes);
+        float* outL = audioBuffer(out_left, nframes);
+        float* outR = audioBuffer(out_right, nframes);
 
-        float dt = 1.0f / comp->sample_rate;
+        updateBandState(1.0f / sample_rate);
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             // Process left channel:
             float xL = inL[i];
             // Split into bands:
             // Band 1 (Low):
-            float band1 = processLPF(xL, comp->lpf_low[0], comp->F1, dt);
+            float band1 = lpf_low[0].process(xL);
             // Band 2 (Low-Mid): high-pass at F1, then low-pass at F2.
-            float temp2 = processHPF(xL, comp->hpf_band2[0], comp->F1, dt);
-            float band2 = processLPF(temp2, comp->lpf_band2[0], comp->F2, dt);
+            float temp2 = hpf_band2[0].process(xL);
+            float band2 = lpf_band2[0].process(temp2);
             // Band 3 (High-Mid): high-pass at F2, then low-pass at F3.
-            float temp3 = processHPF(xL, comp->hpf_band3[0], comp->F2, dt);
-            float band3 = processLPF(temp3, comp->lpf_band3[0], comp->F3, dt);
+            float temp3 = hpf_band3[0].process(xL);
+            float band3 = lpf_band3[0].process(temp3);
             // Band 4 (High):
-            float band4 = processHPF(xL, comp->hpf_band4[0], comp->F3, dt);
+            float band4 = hpf_band4[0].process(xL);
 
             // Apply compression per band.
-            float comp1 = comp->compressSample(band1, 0, 0, dt);
-            float comp2 = comp->compressSample(band2, 1, 0, dt);
-            float comp3 = comp->compressSample(band3, 2, 0, dt);
-            float comp4 = comp->compressSample(band4, 3, 0, dt);
+            float comp1 = compressSample(band1, 0, 0);
+            float comp2 = compressSample(band2, 1, 0);
+            float comp3 = compressSample(band3, 2, 0);
+            float comp4 = compressSample(band4, 3, 0);
 
             // Sum bands.
             outL[i] = comp1 + comp2 + comp3 + comp4;
 
             // Process right channel similarly:
             float xR = inR[i];
-            float band1_r = processLPF(xR, comp->lpf_low[1], comp->F1, dt);
-            float temp2_r = processHPF(xR, comp->hpf_band2[1], comp->F1, dt);
-            float band2_r = processLPF(temp2_r, comp->lpf_band2[1], comp->F2, dt);
-            float temp3_r = processHPF(xR, comp->hpf_band3[1], comp->F2, dt);
-            float band3_r = processLPF(temp3_r, comp->lpf_band3[1], comp->F3, dt);
-            float band4_r = processHPF(xR, comp->hpf_band4[1], comp->F3, dt);
-
-            float comp1_r = comp->compressSample(band1_r, 0, 1, dt);
-            float comp2_r = comp->compressSample(band2_r, 1, 1, dt);
-            float comp3_r = comp->compressSample(band3_r, 2, 1, dt);
-            float comp4_r = comp->compressSample(band4_r, 3, 1, dt);
+            float band1_r = lpf_low[1].process(xR);
+            float temp2_r = hpf_band2[1].process(xR);
+            float band2_r = lpf_band2[1].process(temp2_r);
+            float temp3_r = hpf_band3[1].process(xR);
+            float band3_r = lpf_band3[1].process(temp3_r);
+            float band4_r = hpf_band4[1].process(xR);
+
+            float comp1_r = compressSample(band1_r, 0, 1);
+            float comp2_r = compressSample(band2_r, 1, 1);
+            float comp3_r = compressSample(band3_r, 2, 1);
+            float comp4_r = compressSample(band4_r, 3, 1);
 
             outR[i] = comp1_r + comp2_r + comp3_r + comp4_r;
         }
@@ -183,55 +148,44 @@ private:
     }
 
     // Control thread: allows updating compressor parameters per band.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomMultibandComp] Enter band number (1-4) and new parameters:\n"
-                    << "Threshold (dB), Ratio, Attack (ms), Release (ms), Makeup (linear)\n"
-                    << "For example: \"2 -18 3.0 10 100 1.0\" to update band 2, or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            int band;
-            float newThreshold, newRatio, newAttack, newRelease, newMakeup;
-            if (!(iss >> band >> newThreshold >> newRatio >> newAttack >> newRelease >> newMakeup)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomMultibandComp] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            if (band < 1 || band > 4) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomMultibandComp] Band number must be between 1 and 4." << std::endl;
-                continue;
-            }
-            int idx = band - 1;
-            compThreshold[idx].store(newThreshold);
-            compRatio[idx].store(newRatio);
-            compAttack[idx].store(newAttack);
-            compRelease[idx].store(newRelease);
-            compMakeup[idx].store(newMakeup);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomMultibandComp] Updated band " << band << " parameters: "
-                    << "Threshold = " << newThreshold << " dB, "
-                    << "Ratio = " << newRatio << ", "
-                    << "Attack = " << newAttack << " ms, "
-                    << "Release = " << newRelease << " ms, "
-                    << "Makeup = " << newMakeup << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomMultibandComp] Enter band number (1-4) and new parameters:\n"
+            << "Threshold (dB), Ratio, Attack (ms), Release (ms), Makeup (linear)\n"
+            << "For example: \"2 -18 3.0 10 100 1.0\" to update band 2, or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        int band;
+        float newThreshold, newRatio, newAttack, newRelease, newMakeup;
+        if (!(iss >> band >> newThreshold >> newRatio >> newAttack >> newRelease >> newMakeup))
+            return false;
+        if (band < 1 || band > 4) {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomMultibandComp] Band number must be between 1 and 4." << std::endl;
+            return true;
         }
+        int idx = band - 1;
+        compThreshold[idx].store(newThreshold);
+        compRatio[idx].store(newRatio);
+        compAttack[idx].store(newAttack);
+        compRelease[idx].store(newRelease);
+        compMakeup[idx].store(newMakeup);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomMultibandComp] Updated band " << band << " parameters: "
+                << "Threshold = " << newThreshold << " dB, "
+                << "Ratio = " << newRatio << ", "
+                << "Attack = " << newAttack << " ms, "
+                << "Release = " << newRelease << " ms, "
+                << "Makeup = " << newMakeup << std::endl;
+        }
+        return true;
     }
 
 public:
     PhantomMultibandComp(const char* client_name = "PhantomMultibandComp")
-        : client(nullptr), running(true)
+        : phantom::Plugin(client_name)
     {
         // Initialize compressor envelope states to zero.
         for (int b = 0; b < 4; b++) {
@@ -239,6 +193,14 @@ public:
                 envelope[b][ch] = 0.0f;
             }
         }
+        for (int ch = 0; ch < 2; ch++) {
+            lpf_low[ch].setCutoff(F1, sample_rate);
+            hpf_band2[ch].setCutoff(F1, sample_rate);
+            lpf_band2[ch].setCutoff(F2, sample_rate);
+            hpf_band3[ch].setCutoff(F2, sample_rate);
+            lpf_band3[ch].setCutoff(F3, sample_rate);
+            hpf_band4[ch].setCutoff(F3, sample_rate);
+        }
         // Set default compressor parameters.
         // Band 1 (Low)
         compThreshold[0].store(-20.0f);
@@ -265,34 +227,13 @@ public:
         compRelease[3].store(100.0f);
         compMakeup[3].store(1.0f);
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomMultibandComp: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
+        in_left = registerInput("in_left");
+        in_right = registerInput("in_right");
+        out_left = registerOutput("out_left");
+        out_right = registerOutput("out_right");
 
-        in_left = jack_port_register(client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        in_right = jack_port_register(client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_left || !in_right || !out_left || !out_right) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomMultibandComp: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomMultibandComp: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomMultibandComp: Failed to activate JACK client");
-        }
-
-        // Start the control thread.
-        control_thread = std::thread(&PhantomMultibandComp::control_loop, this);
+        // Activate JACK processing and start the control thread.
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
@@ -307,22 +248,6 @@ public:
             }
         }
     }
-
-    ~PhantomMultibandComp() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        std::cout << "[PhantomMultibandComp] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomMultibandComp] Shutting down." << std::endl;
-    }
 };
 
 int main() {
@@ -3,152 +3,154 @@
 // It takes a mono input and pans it to stereo using an equal-power panning law.
 // The pan parameter ranges from -1.0 (full left) to +1.0 (full right).
 //
+// With a channel count on the command line (default 1, up to 8) the panner takes
+// that many mono inputs, pans each one independently and sums them onto the same
+// stereo pair, so one instance serves a whole bus. The per-channel gains live in
+// contiguous left/right arrays that the inner loop sweeps across.
+//
 // Compile with:
 //   g++ -std=c++11 PhantomPanner.cpp -ljack -lpthread -o PhantomPanner
+// Usage:
+//   ./PhantomPanner [channels]
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <string>
+#include <vector>
+#include <cstdlib>
 
 using namespace std;
 
-class PhantomPanner {
+class PhantomPanner : public phantom::Plugin {
+public:
+    static const int MAX_CHANNELS = 8;
+
 private:
-    jack_client_t* client;
-    jack_port_t* in_port;
+    int num_channels;
+    vector<jack_port_t*> in_ports;
     jack_port_t* out_left;
     jack_port_t* out_right;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
-
-    // Pan parameter: -1.0 (full left) to +1.0 (full right); 0.0 is center.
-    atomic<float> pan;
-
-    // JACK process callback: reads mono input and outputs stereo.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomPanner* panner = static_cast<PhantomPanner*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(panner->in_port, nframes));
-        float* left_out = static_cast<float*>(jack_port_get_buffer(panner->out_left, nframes));
-        float* right_out = static_cast<float*>(jack_port_get_buffer(panner->out_right, nframes));
 
-        float currentPan = panner->pan.load();
-        // Map pan from [-1, 1] to angle between 0 and π/2.
-        float angle = (currentPan + 1.0f) * (M_PI / 4.0f);
-        float leftGain = cos(angle);
-        float rightGain = sin(angle);
+    // Pan parameter per channel: -1.0 (full left) to +1.0 (full right); 0.0 is center.
+    atomic<float> pan[MAX_CHANNELS];
+
+    // Equal-power gains per channel, recomputed once per block.
+    vector<float> leftGain, rightGain;
+    vector<float*> in_bufs;
+
+    // JACK process callback: reads the mono inputs and mixes them to stereo.
+    int process(jack_nframes_t nframes) override {
+        const int nch = num_channels;
+        float* left_out = audioBuffer(out_left, nframes);
+        float* right_out = audioBuffer(out_right, nframes);
+        float** in = in_bufs.data();
+        float* lg = leftGain.data();
+        float* rg = rightGain.data();
+
+        for (int c = 0; c < nch; c++) {
+            in[c] = audioBuffer(in_ports[c], nframes);
+            // Map pan from [-1, 1] to angle between 0 and π/2.
+            float angle = (pan[c].load() + 1.0f) * (M_PI / 4.0f);
+            lg[c] = cos(angle);
+            rg[c] = sin(angle);
+        }
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
-            float sample = in[i];
-            left_out[i] = sample * leftGain;
-            right_out[i] = sample * rightGain;
+            float left = 0.0f;
+            float right = 0.0f;
+            for (int c = 0; c < nch; c++) {
+                float sample = in[c][i];
+                left += sample * lg[c];
+                right += sample * rg[c];
+            }
+            left_out[i] = left;
+            right_out[i] = right;
         }
         return 0;
     }
 
     // Control thread: allows updating the pan parameter.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomPanner] Enter pan value (-1.0 for full left to 1.0 for full right), or 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newPan;
-            if (!(iss >> newPan)) {
+    void printPrompt() override {
+        cout << "\n[PhantomPanner] Enter pan value (-1.0 for full left to 1.0 for full right), "
+            << "optionally prefixed by a channel number (1-" << num_channels << "), or 'q' to quit: ";
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        // "pan" sets every channel, "channel pan" sets one.
+        float first, second;
+        int channel = 0;
+        float newPan;
+        if (!(iss >> first))
+            return false;
+        if (iss >> second) {
+            channel = static_cast<int>(first);
+            newPan = second;
+            if (channel < 1 || channel > num_channels) {
                 lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomPanner] Invalid input. Please try again." << endl;
-                continue;
+                cout << "[PhantomPanner] Invalid channel. Please try again." << endl;
+                return true;
             }
-            // Clamp newPan to [-1.0, 1.0].
-            if (newPan < -1.0f)
-                newPan = -1.0f;
-            if (newPan > 1.0f)
-                newPan = 1.0f;
-            pan.store(newPan);
-            {
-                lock_guard<mutex> lock(print_mutex);
+        }
+        else {
+            newPan = first;
+        }
+        // Clamp newPan to [-1.0, 1.0].
+        if (newPan < -1.0f)
+            newPan = -1.0f;
+        if (newPan > 1.0f)
+            newPan = 1.0f;
+        for (int c = 0; c < num_channels; c++) {
+            if (channel == 0 || channel == c + 1)
+                pan[c].store(newPan);
+        }
+        {
+            lock_guard<mutex> lock(print_mutex);
+            if (channel == 0)
                 cout << "[PhantomPanner] Updated pan value: " << newPan << endl;
-            }
+            else
+                cout << "[PhantomPanner] Updated pan value for channel " << channel << ": " << newPan << endl;
         }
+        return true;
     }
 
 public:
-    PhantomPanner(const char* client_name = "PhantomPanner")
-        : client(nullptr), running(true), pan(0.0f)  // Default pan is center.
+    PhantomPanner(int channels = 1, const char* client_name = "PhantomPanner")
+        : phantom::Plugin(client_name), num_channels(channels)
     {
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomPanner: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_left || !out_right) {
-            jack_client_close(client);
-            throw runtime_error("PhantomPanner: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomPanner: Failed to set process callback");
+        if (channels < 1 || channels > MAX_CHANNELS) {
+            throw runtime_error("PhantomPanner: Channel count must be between 1 and 8");
         }
+        // Default pan is center.
+        for (int c = 0; c < MAX_CHANNELS; c++)
+            pan[c].store(0.0f);
+        leftGain.assign(num_channels, 0.0f);
+        rightGain.assign(num_channels, 0.0f);
+        in_bufs.assign(num_channels, nullptr);
 
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomPanner: Failed to activate JACK client");
-        }
+        // A single input keeps the original "in" name; more are numbered from 1.
+        for (int c = 0; c < num_channels; c++)
+            in_ports.push_back(registerInput(phantom::numberedPortName("in", c, num_channels)));
+        out_left = registerOutput("out_left");
+        out_right = registerOutput("out_right");
 
-        control_thread = thread(&PhantomPanner::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
-        cout << "[PhantomPanner] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
-        cout << "[PhantomPanner] Default pan: " << pan.load() << " (center)" << endl;
-    }
-
-    ~PhantomPanner() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomPanner] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomPanner] Shutting down." << endl;
+        cout << "[PhantomPanner] Initialized. Sample rate: " << sample_rate << " Hz, inputs: " << num_channels << endl;
+        cout << "[PhantomPanner] Default pan: " << pan[0].load() << " (center)" << endl;
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomPanner panner;
+        int channels = (argc > 1) ? atoi(argv[1]) : 1;
+        PhantomPanner panner(channels);
         panner.run();
     }
     catch (const exception& e) {
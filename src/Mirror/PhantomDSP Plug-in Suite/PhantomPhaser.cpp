@@ -4,40 +4,27 @@
 // Compile with:
 //   g++ -std=c++11 PhantomPhaser.cpp -ljack -lpthread -o PhantomPhaser
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <vector>
 
 #define NUM_STAGES 4
 
 // Structure for a single all-pass filter stage used in the phaser.
 struct AllPassStage {
-    float x_prev;
-    float y_prev;
+    phantom::AllPass1 filter;
     float lfo_offset; // Unique offset for this stage's modulation.
-    AllPassStage(float offset) : x_prev(0.0f), y_prev(0.0f), lfo_offset(offset) {}
+    AllPassStage(float offset) : lfo_offset(offset) {}
 };
 
-class PhantomPhaser {
+class PhantomPhaser : public phantom::Plugin {
 private:
-    jack_client_t* client;
     jack_port_t* in_left, * in_right, * out_left, * out_right;
-    int sample_rate;
-
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
 
     // Phaser parameters
     std::atomic<float> rate;     // LFO frequency in Hz (e.g., 0.5 Hz)
@@ -56,103 +43,85 @@ private:
     float left_fb, right_fb;
 
     // JACK process callback: processes audio block by block.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomPhaser* phaser = static_cast<PhantomPhaser*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(phaser->in_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(phaser->in_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(phaser->out_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(phaser->out_right, nframes));
-
-        float current_rate = phaser->rate.load();
-        float current_depth = phaser->depth.load();
-        float current_feedback = phaser->feedback.load();
-        float current_mix = phaser->mix.load();
-
-        float dt = 1.0f / phaser->sample_rate;
+    int process(jack_nframes_t nframes) override {
+        float* inL = audioBuffer(in_left, nframes);
+        float* inR = audioBuffer(in_right, nframes);
+        float* outL = audioBuffer(out_left, nframes);
+        float* outR = audioBuffer(out_right, nframes);
+
+        float current_rate = rate.load();
+        float current_depth = depth.load();
+        float current_feedback = feedback.load();
+        float current_mix = mix.load();
+
+        float dt = 1.0f / sample_rate;
         float lfo_increment = 2.0f * M_PI * current_rate * dt;
 
         for (jack_nframes_t i = 0; i < nframes; i++) {
             // --- Process Left Channel ---
             float inputL = inL[i];
+            // Compute modulated coefficients once; both channels share the stage offsets.
+            // Here, we choose a base coefficient of 0.5 and modulate it by 0.3 * depth.
+            float coeffs[NUM_STAGES];
+            for (int stage = 0; stage < NUM_STAGES; stage++)
+                coeffs[stage] = 0.5f + 0.3f * current_depth * sinf(lfo_phase + left_stages[stage].lfo_offset);
+
             // Incorporate feedback into the input.
-            float xL = inputL + phaser->left_fb * current_feedback;
+            float xL = inputL + left_fb * current_feedback;
             // Process through each all-pass filter stage.
-            for (int stage = 0; stage < NUM_STAGES; stage++) {
-                // Compute modulated coefficient for this stage.
-                // Here, we choose a base coefficient of 0.5 and modulate it by 0.3 * depth.
-                float a = 0.5f + 0.3f * current_depth * sinf(phaser->lfo_phase + phaser->left_stages[stage].lfo_offset);
-                float y = -a * xL + phaser->left_stages[stage].x_prev + a * phaser->left_stages[stage].y_prev;
-                phaser->left_stages[stage].x_prev = xL;
-                phaser->left_stages[stage].y_prev = y;
-                xL = y;
-            }
+            for (int stage = 0; stage < NUM_STAGES; stage++)
+                xL = left_stages[stage].filter.process(xL, coeffs[stage]);
             // Store the processed output for feedback.
-            phaser->left_fb = xL;
+            left_fb = xL;
             // Mix processed signal with dry signal.
             float outputL = current_mix * xL + (1.0f - current_mix) * inputL;
             outL[i] = outputL;
 
             // --- Process Right Channel ---
             float inputR = inR[i];
-            float xR = inputR + phaser->right_fb * current_feedback;
-            for (int stage = 0; stage < NUM_STAGES; stage++) {
-                float a = 0.5f + 0.3f * current_depth * sinf(phaser->lfo_phase + phaser->right_stages[stage].lfo_offset);
-                float y = -a * xR + phaser->right_stages[stage].x_prev + a * phaser->right_stages[stage].y_prev;
-                phaser->right_stages[stage].x_prev = xR;
-                phaser->right_stages[stage].y_prev = y;
-                xR = y;
-            }
-            phaser->right_fb = xR;
+            float xR = inputR + right_fb * current_feedback;
+            for (int stage = 0; stage < NUM_STAGES; stage++)
+                xR = right_stages[stage].filter.process(xR, coeffs[stage]);
+            right_fb = xR;
             float outputR = current_mix * xR + (1.0f - current_mix) * inputR;
             outR[i] = outputR;
 
             // Advance the global LFO phase.
-            phaser->lfo_phase += lfo_increment;
-            if (phaser->lfo_phase >= 2.0f * M_PI)
-                phaser->lfo_phase -= 2.0f * M_PI;
+            lfo_phase += lfo_increment;
+            if (lfo_phase >= 2.0f * M_PI)
+                lfo_phase -= 2.0f * M_PI;
         }
         return 0;
     }
 
     // Control thread: allows real-time parameter updates.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomPhaser] Enter parameters: rate (Hz), depth (0-1), feedback (-1 to 1), mix (0-1)\n"
-                    << "e.g., \"0.5 0.5 0.3 0.5\" or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float new_rate, new_depth, new_feedback, new_mix;
-            if (!(iss >> new_rate >> new_depth >> new_feedback >> new_mix)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomPhaser] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            rate.store(new_rate);
-            depth.store(new_depth);
-            feedback.store(new_feedback);
-            mix.store(new_mix);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomPhaser] Updated parameters: rate = " << new_rate
-                    << " Hz, depth = " << new_depth
-                    << ", feedback = " << new_feedback
-                    << ", mix = " << new_mix << std::endl;
-            }
+    void printPrompt() override {
+        std::cout << "\n[PhantomPhaser] Enter parameters: rate (Hz), depth (0-1), feedback (-1 to 1), mix (0-1)\n"
+            << "e.g., \"0.5 0.5 0.3 0.5\" or type 'q' to quit: ";
+    }
+
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float new_rate, new_depth, new_feedback, new_mix;
+        if (!(iss >> new_rate >> new_depth >> new_feedback >> new_mix))
+            return false;
+        rate.store(new_rate);
+        depth.store(new_depth);
+        feedback.store(new_feedback);
+        mix.store(new_mix);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomPhaser] Updated parameters: rate = " << new_rate
+                << " Hz, depth = " << new_depth
+                << ", feedback = " << new_feedback
+                << ", mix = " << new_mix << std::endl;
         }
+        return true;
     }
 
 public:
     PhantomPhaser(const char* client_name = "PhantomPhaser")
-        : client(nullptr), running(true), lfo_phase(0.0f), left_fb(0.0f), right_fb(0.0f)
+        : phantom::Plugin(client_name), lfo_phase(0.0f), left_fb(0.0f), right_fb(0.0f)
     {
         // Set default phaser parameters.
         rate.store(0.5f);     // 0.5 Hz LFO
@@ -160,31 +129,10 @@ public:
         feedback.store(0.3f); // Some feedback
         mix.store(0.5f);      // 50/50 dry/wet mix
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomPhaser: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        in_left = jack_port_register(client, "in_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        in_right = jack_port_register(client, "in_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_left = jack_port_register(client, "out_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        out_right = jack_port_register(client, "out_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_left || !in_right || !out_left || !out_right) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomPhaser: Failed to register JACK ports");
-        }
-
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomPhaser: Failed to set process callback");
-        }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomPhaser: Failed to activate JACK client");
-        }
+        in_left = registerInput("in_left");
+        in_right = registerInput("in_right");
+        out_left = registerOutput("out_left");
+        out_right = registerOutput("out_right");
 
         // Initialize filter chains for both channels.
         // Distribute phase offsets evenly for the stages.
@@ -194,7 +142,7 @@ public:
             right_stages.push_back(AllPassStage(offset));
         }
 
-        control_thread = std::thread(&PhantomPhaser::control_loop, this);
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
@@ -205,24 +153,6 @@ public:
                 << ", mix = " << mix.load() << std::endl;
         }
     }
-
-    ~PhantomPhaser() {
-        running.store(false);
-        if (control_thread.joinable()) {
-            control_thread.join();
-        }
-        if (client) {
-            jack_client_close(client);
-        }
-    }
-
-    void run() {
-        std::cout << "[PhantomPhaser] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomPhaser] Shutting down." << std::endl;
-    }
 };
 
 int main() {
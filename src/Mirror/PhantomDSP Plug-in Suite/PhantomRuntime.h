@@ -0,0 +1,856 @@
+// PhantomRuntime.h
+// Shared header-only runtime for the PhantomDSP plug-in suite.
+//
+// - phantom::Plugin owns the JACK client lifecycle (open, port registration,
+//   activation, shutdown) and the console control thread. A plug-in derives
+//   from it and only implements process(), printPrompt() and handleCommand().
+//   channelPortName()/numberedPortName() name the ports of N-channel plug-ins,
+//   and stereoPairs() splits an even bus into the pairs a stereo effect works on.
+// - KeyFilter holds the sidechain key filter and combine mode shared by the
+//   dynamics plug-ins, including their "hpf"/"lpf"/"mode" console commands.
+// - Every process() call runs with flush-to-zero / denormals-are-zero enabled,
+//   so recursive filters decaying towards silence never hit denormal slow paths.
+// - AlignedBuffer is 64-byte aligned storage allocated once, outside the audio thread.
+// - OnePoleLP, OnePoleHP, SVF, Biquad, AllPass1, AllPassDelay and DelayLine are the
+//   common DSP building blocks. Each has a per-sample process() and, where the
+//   recursion allows, a processBlock() loop the compiler can keep in registers.
+//   Noise replaces rand() on the audio thread.
+// - TempoClock reads the JACK transport once per period and turns note divisions
+//   ("1/8d", "1/4t", ...) into delay lengths and LFO rates; CrossfadeTap moves a
+//   delay read head to a new length without clicks. handleTempoCommand() parses
+//   the shared "bpm" / "sync" console commands.
+//
+// Include it instead of <jack/jack.h>; plug-ins still compile as a single file:
+//   g++ -std=c++11 PhantomComp.cpp -ljack -lpthread -o PhantomComp
+
+#ifndef PHANTOM_RUNTIME_H
+#define PHANTOM_RUNTIME_H
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#include <jack/jack.h>
+#include <jack/transport.h>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PHANTOM_HAVE_SSE 1
+#endif
+
+namespace phantom {
+
+// ----------------------------
+// Denormal protection
+
+// Sets flush-to-zero and denormals-are-zero for the calling thread.
+inline void enableFlushToZero() {
+#if defined(PHANTOM_HAVE_SSE)
+    _mm_setcsr(_mm_getcsr() | 0x8040);  // FTZ (bit 15) | DAZ (bit 6)
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ULL << 24)));  // FZ
+#endif
+}
+
+// ----------------------------
+// Aligned, preallocated storage
+
+// Zero-initialised buffer aligned for SIMD loads. Allocate it from the
+// constructor or the control thread, never from process().
+template <typename T>
+class AlignedBuffer {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    AlignedBuffer() : ptr(nullptr), count(0) {}
+    explicit AlignedBuffer(size_t n) : ptr(nullptr), count(0) { allocate(n); }
+    AlignedBuffer(const AlignedBuffer& other) : ptr(nullptr), count(0) {
+        allocate(other.count);
+        if (count)
+            std::memcpy(ptr, other.ptr, count * sizeof(T));
+    }
+    AlignedBuffer(AlignedBuffer&& other) noexcept : ptr(other.ptr), count(other.count) {
+        other.ptr = nullptr;
+        other.count = 0;
+    }
+    AlignedBuffer& operator=(AlignedBuffer other) noexcept {
+        std::swap(ptr, other.ptr);
+        std::swap(count, other.count);
+        return *this;
+    }
+    ~AlignedBuffer() { release(); }
+
+    void allocate(size_t n) {
+        release();
+        if (n == 0)
+            return;
+        void* mem = nullptr;
+        size_t bytes = ((n * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+#if defined(_WIN32)
+        mem = _aligned_malloc(bytes, ALIGNMENT);
+#else
+        if (posix_memalign(&mem, ALIGNMENT, bytes) != 0)
+            mem = nullptr;
+#endif
+        if (!mem)
+            throw std::bad_alloc();
+        std::memset(mem, 0, bytes);
+        ptr = static_cast<T*>(mem);
+        count = n;
+    }
+    void clear() {
+        if (count)
+            std::memset(ptr, 0, count * sizeof(T));
+    }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+private:
+    void release() {
+        if (!ptr)
+            return;
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+        ptr = nullptr;
+        count = 0;
+    }
+
+    T* ptr;
+    size_t count;
+};
+
+// ----------------------------
+// DSP primitives
+
+// First-order RC low-pass.
+struct OnePoleLP {
+    float cutoff;  // cutoff frequency in Hz
+    float a;       // smoothing coefficient
+    float z;
+
+    OnePoleLP(float cutoffHz = 1000.0f, int fs = 48000) : z(0.0f) { setCutoff(cutoffHz, fs); }
+    void setCutoff(float cutoffHz, int fs) {
+        cutoff = cutoffHz;
+        float dt = 1.0f / fs;
+        float RC = 1.0f / (2.0f * static_cast<float>(M_PI) * cutoff);
+        a = dt / (RC + dt);
+    }
+    float process(float x) {
+        z += a * (x - z);
+        return z;
+    }
+    void processBlock(const float* in, float* out, size_t n) {
+        float s = z;
+        for (size_t i = 0; i < n; i++) {
+            s += a * (in[i] - s);
+            out[i] = s;
+        }
+        z = s;
+    }
+    void reset() { z = 0.0f; }
+};
+
+// First-order RC high-pass.
+struct OnePoleHP {
+    float cutoff;  // cutoff frequency in Hz
+    float beta;    // smoothing coefficient
+    float x1, y1;
+
+    OnePoleHP(float cutoffHz = 1000.0f, int fs = 48000) : x1(0.0f), y1(0.0f) { setCutoff(cutoffHz, fs); }
+    void setCutoff(float cutoffHz, int fs) {
+        cutoff = cutoffHz;
+        float dt = 1.0f / fs;
+        float RC = 1.0f / (2.0f * static_cast<float>(M_PI) * cutoff);
+        beta = RC / (RC + dt);
+    }
+    float process(float x) {
+        float y = beta * (y1 + x - x1);
+        x1 = x;
+        y1 = y;
+        return y;
+    }
+    void processBlock(const float* in, float* out, size_t n) {
+        float px = x1, py = y1;
+        for (size_t i = 0; i < n; i++) {
+            float x = in[i];
+            py = beta * (py + x - px);
+            px = x;
+            out[i] = py;
+        }
+        x1 = px;
+        y1 = py;
+    }
+    void reset() { x1 = 0.0f; y1 = 0.0f; }
+};
+
+// Trapezoidal (zero-delay feedback) state-variable filter. One call yields
+// low, band and high outputs; stays stable under fast cutoff modulation.
+struct SVF {
+    float g, k, a1, a2, a3;
+    float ic1eq, ic2eq;
+    float low, band, high;
+
+    SVF() : g(0.0f), k(1.0f), a1(0.0f), a2(0.0f), a3(0.0f), ic1eq(0.0f), ic2eq(0.0f),
+        low(0.0f), band(0.0f), high(0.0f) {}
+    void set(float cutoffHz, float Q, int fs) {
+        g = std::tan(static_cast<float>(M_PI) * cutoffHz / fs);
+        k = 1.0f / Q;
+        a1 = 1.0f / (1.0f + g * (g + k));
+        a2 = g * a1;
+        a3 = g * a2;
+    }
+    // Processes one sample; results are left in low/band/high.
+    void process(float v0) {
+        float v3 = v0 - ic2eq;
+        float v1 = a1 * ic1eq + a2 * v3;
+        float v2 = ic2eq + a2 * ic1eq + a3 * v3;
+        ic1eq = 2.0f * v1 - ic1eq;
+        ic2eq = 2.0f * v2 - ic2eq;
+        low = v2;
+        band = v1;
+        high = v0 - k * v1 - v2;
+    }
+    void reset() { ic1eq = ic2eq = 0.0f; low = band = high = 0.0f; }
+};
+
+// RBJ cookbook biquad in transposed direct form II.
+struct Biquad {
+    enum Type { LOWPASS, HIGHPASS, BANDPASS, NOTCH, PEAK, LOWSHELF, HIGHSHELF };
+
+    float b0, b1, b2, a1, a2;
+    float z1, z2;
+
+    Biquad() : b0(1.0f), b1(0.0f), b2(0.0f), a1(0.0f), a2(0.0f), z1(0.0f), z2(0.0f) {}
+    void set(Type type, float freq, float Q, float gainDB, int fs) {
+        double A = std::pow(10.0, gainDB / 40.0);
+        double w0 = 2.0 * M_PI * freq / fs;
+        double cw = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * Q);
+        double sqA = 2.0 * std::sqrt(A) * alpha;
+        double nb0, nb1, nb2, na0, na1, na2;
+        switch (type) {
+        case LOWPASS:
+            nb0 = (1.0 - cw) / 2.0; nb1 = 1.0 - cw; nb2 = (1.0 - cw) / 2.0;
+            na0 = 1.0 + alpha; na1 = -2.0 * cw; na2 = 1.0 - alpha;
+            break;
+        case HIGHPASS:
+            nb0 = (1.0 + cw) / 2.0; nb1 = -(1.0 + cw); nb2 = (1.0 + cw) / 2.0;
+            na0 = 1.0 + alpha; na1 = -2.0 * cw; na2 = 1.0 - alpha;
+            break;
+        case BANDPASS:
+            nb0 = alpha; nb1 = 0.0; nb2 = -alpha;
+            na0 = 1.0 + alpha; na1 = -2.0 * cw; na2 = 1.0 - alpha;
+            break;
+        case NOTCH:
+            nb0 = 1.0; nb1 = -2.0 * cw; nb2 = 1.0;
+            na0 = 1.0 + alpha; na1 = -2.0 * cw; na2 = 1.0 - alpha;
+            break;
+        case PEAK:
+            nb0 = 1.0 + alpha * A; nb1 = -2.0 * cw; nb2 = 1.0 - alpha * A;
+            na0 = 1.0 + alpha / A; na1 = -2.0 * cw; na2 = 1.0 - alpha / A;
+            break;
+        case LOWSHELF:
+            nb0 = A * ((A + 1.0) - (A - 1.0) * cw + sqA);
+            nb1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+            nb2 = A * ((A + 1.0) - (A - 1.0) * cw - sqA);
+            na0 = (A + 1.0) + (A - 1.0) * cw + sqA;
+            na1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+            na2 = (A + 1.0) + (A - 1.0) * cw - sqA;
+            break;
+        case HIGHSHELF:
+        default:
+            nb0 = A * ((A + 1.0) + (A - 1.0) * cw + sqA);
+            nb1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+            nb2 = A * ((A + 1.0) + (A - 1.0) * cw - sqA);
+            na0 = (A + 1.0) - (A - 1.0) * cw + sqA;
+            na1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+            na2 = (A + 1.0) - (A - 1.0) * cw - sqA;
+            break;
+        }
+        b0 = static_cast<float>(nb0 / na0);
+        b1 = static_cast<float>(nb1 / na0);
+        b2 = static_cast<float>(nb2 / na0);
+        a1 = static_cast<float>(na1 / na0);
+        a2 = static_cast<float>(na2 / na0);
+    }
+    float process(float x) {
+        float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        return y;
+    }
+    void processBlock(const float* in, float* out, size_t n) {
+        float s1 = z1, s2 = z2;
+        for (size_t i = 0; i < n; i++) {
+            float x = in[i];
+            float y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            out[i] = y;
+        }
+        z1 = s1;
+        z2 = s2;
+    }
+    void reset() { z1 = z2 = 0.0f; }
+};
+
+// First-order all-pass with a per-call coefficient (phaser stages).
+struct AllPass1 {
+    float x1, y1;
+
+    AllPass1() : x1(0.0f), y1(0.0f) {}
+    float process(float x, float a) {
+        float y = -a * x + x1 + a * y1;
+        x1 = x;
+        y1 = y;
+        return y;
+    }
+    void reset() { x1 = y1 = 0.0f; }
+};
+
+// Schroeder delay-line all-pass (reverb diffusion).
+struct AllPassDelay {
+    AlignedBuffer<float> buffer;
+    size_t length;
+    size_t writeIndex;
+    float feedback;
+
+    AllPassDelay() : length(0), writeIndex(0), feedback(0.0f) {}
+    AllPassDelay(size_t delaySamples, float fb) : length(0), writeIndex(0), feedback(fb) { setLength(delaySamples); }
+    void setLength(size_t delaySamples) {
+        length = delaySamples > 0 ? delaySamples : 1;
+        buffer.allocate(length);
+        writeIndex = 0;
+    }
+    float process(float input) {
+        float buffered = buffer[writeIndex];
+        float output = -feedback * input + buffered;
+        buffer[writeIndex] = input + output * feedback;
+        if (++writeIndex == length)
+            writeIndex = 0;
+        return output;
+    }
+    void reset() { buffer.clear(); writeIndex = 0; }
+};
+
+// Power-of-two circular delay line, preallocated to a maximum length.
+// Reads are relative to the most recent write.
+class DelayLine {
+public:
+    DelayLine() : mask(0), writeIndex(0), maxDelay(0) {}
+    explicit DelayLine(size_t maxDelaySamples) : mask(0), writeIndex(0), maxDelay(0) { allocate(maxDelaySamples); }
+
+    void allocate(size_t maxDelaySamples) {
+        size_t size = 1;
+        while (size < maxDelaySamples + 2)
+            size <<= 1;
+        buffer.allocate(size);
+        mask = size - 1;
+        writeIndex = 0;
+        maxDelay = maxDelaySamples;
+    }
+    size_t capacity() const { return maxDelay; }
+
+    void write(float x) {
+        writeIndex = (writeIndex + 1) & mask;
+        buffer[writeIndex] = x;
+    }
+    // Sample written 'delay' writes ago (0 = the latest).
+    float read(size_t delay) const {
+        return buffer[(writeIndex - delay) & mask];
+    }
+    // Linear interpolation between whole-sample taps.
+    float readFrac(float delay) const {
+        size_t d = static_cast<size_t>(delay);
+        float frac = delay - static_cast<float>(d);
+        float a = buffer[(writeIndex - d) & mask];
+        float b = buffer[(writeIndex - d - 1) & mask];
+        return a + frac * (b - a);
+    }
+    void reset() { buffer.clear(); writeIndex = 0; }
+
+private:
+    AlignedBuffer<float> buffer;
+    size_t mask;
+    size_t writeIndex;
+    size_t maxDelay;
+};
+
+// Per-instance xorshift32 noise source. Lock-free and allocation-free, unlike
+// rand(), so it can run on the audio thread; seed it from the constructor.
+class Noise {
+public:
+    explicit Noise(uint32_t seed = 0x9E3779B9u) { setSeed(seed); }
+    void setSeed(uint32_t seed) { state = seed ? seed : 0x9E3779B9u; }
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    // Uniform in [0, 1).
+    float uniform() { return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f); }
+    // Uniform in [-1, 1).
+    float bipolar() { return 2.0f * uniform() - 1.0f; }
+
+private:
+    uint32_t state;
+};
+
+// Delay read head that moves to a new length by crossfading between the old
+// and new taps instead of jumping. Delays use DelayLine terms (0 = latest write).
+class CrossfadeTap {
+public:
+    CrossfadeTap() : current(0.0f), previous(0.0f), fadePos(0), fadeLen(1), invFadeLen(1.0f) {}
+
+    void setFadeLength(size_t samples) {
+        fadeLen = samples > 0 ? samples : 1;
+        invFadeLen = 1.0f / static_cast<float>(fadeLen);
+        fadePos = fadeLen;
+    }
+    // Jump straight to a delay (initialisation, no fade).
+    void snap(float delay) {
+        current = previous = delay;
+        fadePos = fadeLen;
+    }
+    // Called once per block. A change that arrives mid-fade is picked up by
+    // the first block after the running fade completes.
+    void setDelay(float delay) {
+        if (delay != current && fadePos >= fadeLen) {
+            previous = current;
+            current = delay;
+            fadePos = 0;
+        }
+    }
+    float delay() const { return current; }
+
+    float read(const DelayLine& line) {
+        if (fadePos >= fadeLen)
+            return line.readFrac(current);
+        float g = static_cast<float>(fadePos++) * invFadeLen;
+        return line.readFrac(previous) + g * (line.readFrac(current) - line.readFrac(previous));
+    }
+
+private:
+    float current, previous;
+    size_t fadePos, fadeLen;
+    float invFadeLen;
+};
+
+// ----------------------------
+// Console parsing
+
+// Parses a whole token as a finite number; "abc", "12x" and "" are rejected.
+inline bool parseNumber(const std::string& text, float& value) {
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    float v = std::strtof(begin, &end);
+    if (end == begin || *end != '\0' || !std::isfinite(v))
+        return false;
+    value = v;
+    return true;
+}
+
+// ----------------------------
+// Tempo sync
+
+// Parses a note division into beats (quarter notes): "1/4" = 1, "1/8" = 0.5,
+// "1/1" = 4, with an optional 'd' (dotted) or 't' (triplet) suffix.
+inline bool parseNoteDivision(const std::string& text, float& beats) {
+    int num = 0, den = 0;
+    char modifier = 0;
+    int fields = std::sscanf(text.c_str(), "%d/%d%c", &num, &den, &modifier);
+    if (fields < 2 || num <= 0 || den <= 0)
+        return false;
+    beats = 4.0f * static_cast<float>(num) / static_cast<float>(den);
+    if (fields == 3) {
+        if (modifier == 'd' || modifier == 'D')
+            beats *= 1.5f;
+        else if (modifier == 't' || modifier == 'T')
+            beats *= 2.0f / 3.0f;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Tempo source for synced plug-ins. update() queries the JACK transport once
+// per period; when a timebase master publishes BBT the tempo and beat position
+// follow it, otherwise the console-set fallback BPM is used.
+// Everything except setFallbackBpm() is for the audio thread only.
+class TempoClock {
+public:
+    static const int MIN_BPM = 20;
+    static const int MAX_BPM = 300;
+
+    TempoClock() : fallbackBpm(120.0f), currentBpm(120.0f), beatPos(0.0), fromTransport(false), rolling(false) {}
+
+    void setFallbackBpm(float bpm) { fallbackBpm.store(clampBpm(bpm)); }
+    float getFallbackBpm() const { return fallbackBpm.load(); }
+
+    void update(jack_client_t* client) {
+        jack_position_t pos;
+        jack_transport_state_t state = jack_transport_query(client, &pos);
+        fromTransport = (pos.valid & JackPositionBBT) && pos.beats_per_minute > 0.0;
+        rolling = fromTransport && state == JackTransportRolling;
+        if (fromTransport) {
+            // JACK counts beats in the time-signature unit; convert to quarter notes.
+            double quarterPerBeat = pos.beat_type > 0.0f ? 4.0 / pos.beat_type : 1.0;
+            double beats = (pos.bar - 1) * static_cast<double>(pos.beats_per_bar) + (pos.beat - 1);
+            if (pos.ticks_per_beat > 0.0)
+                beats += pos.tick / pos.ticks_per_beat;
+            beatPos = beats * quarterPerBeat;
+            currentBpm = clampBpm(static_cast<float>(pos.beats_per_minute * quarterPerBeat));
+        }
+        else {
+            currentBpm = fallbackBpm.load();
+        }
+    }
+
+    float bpm() const { return currentBpm; }
+    bool transportSynced() const { return fromTransport; }
+
+    // Length of 'beats' quarter notes at the current tempo.
+    float samplesFor(float beats, int fs) const { return beats * 60.0f * static_cast<float>(fs) / currentBpm; }
+    // Rate of a cycle lasting 'beats' quarter notes.
+    float hzFor(float beats) const { return currentBpm / (60.0f * beats); }
+
+    // LFO phase (radians) aligned to the transport grid for a cycle of 'beats'.
+    // Returns false when the transport is not rolling, leaving 'phase' alone.
+    bool lfoPhase(float beats, float& phase) const {
+        if (!rolling || beats <= 0.0f)
+            return false;
+        double cycles = beatPos / beats;
+        phase = static_cast<float>(2.0 * M_PI * (cycles - std::floor(cycles)));
+        return true;
+    }
+
+private:
+    std::atomic<float> fallbackBpm;
+    float currentBpm;
+    double beatPos;
+    bool fromTransport;
+    bool rolling;
+
+    static float clampBpm(float bpm) {
+        if (bpm < MIN_BPM) return static_cast<float>(MIN_BPM);
+        if (bpm > MAX_BPM) return static_cast<float>(MAX_BPM);
+        return bpm;
+    }
+};
+
+// Control thread: applies "bpm <value>" (fallback tempo) or "sync <division|off>"
+// (stores the division in beats, 0 = off, into syncBeats). Returns false if the
+// line is not a tempo command. A tempo command with a bad value is still consumed,
+// with valid set to false so the caller reports invalid input.
+inline bool handleTempoCommand(const std::string& line, TempoClock& tempo, std::atomic<float>& syncBeats,
+                               const char* tag, std::mutex& printMutex, bool& valid) {
+    char cmd[8] = { 0 }, value[32] = { 0 }, extra = 0;
+    int fields = std::sscanf(line.c_str(), "%7s %31s %c", cmd, value, &extra);
+    std::string name(cmd);
+    if (fields < 1 || (name != "bpm" && name != "sync"))
+        return false;
+    valid = false;
+    if (fields != 2)
+        return true;
+    std::string text(value);
+    if (name == "bpm") {
+        float bpm;
+        if (!parseNumber(text, bpm))
+            return true;
+        tempo.setFallbackBpm(bpm);
+        std::lock_guard<std::mutex> lock(printMutex);
+        std::cout << "[" << tag << "] Fallback tempo = " << tempo.getFallbackBpm() << " BPM" << std::endl;
+    }
+    else {
+        float beats = 0.0f;
+        if (text != "off" && !parseNoteDivision(text, beats))
+            return true;
+        syncBeats.store(beats);
+        std::lock_guard<std::mutex> lock(printMutex);
+        std::cout << "[" << tag << "] Tempo sync " << (beats > 0.0f ? "= " + text : std::string("off")) << std::endl;
+    }
+    valid = true;
+    return true;
+}
+
+// ----------------------------
+// Port naming
+
+// Port name for channel c of an n-channel bus. A lone channel keeps the bare
+// name and stereo uses _left/_right, matching the ports the plug-ins had before
+// they took N channels; other layouts are numbered from 1.
+inline std::string channelPortName(const char* base, int c, int n) {
+    if (n == 1)
+        return base;
+    if (n == 2)
+        return std::string(base) + (c == 0 ? "_left" : "_right");
+    return std::string(base) + "_" + std::to_string(c + 1);
+}
+
+// Port name for input k of n independent inputs (sidechain keys): the bare
+// name for one, numbered from 1 otherwise.
+inline std::string numberedPortName(const char* base, int k, int n) {
+    if (n == 1)
+        return base;
+    return std::string(base) + "_" + std::to_string(k + 1);
+}
+
+// Splits an even n-channel bus into stereo pairs. For 5.1 and 7.1
+// (L R C LFE Ls Rs [Lb Rb]) the centre and LFE channels have no partner and
+// are returned in 'single'. Odd layouts are not supported; callers reject them.
+inline void stereoPairs(int n, std::vector<int>& left, std::vector<int>& right, std::vector<int>& single) {
+    for (int c = 0; c + 1 < n; c += 2) {
+        if (n >= 6 && c == 2) {
+            single.push_back(2);
+            single.push_back(3);
+            continue;
+        }
+        left.push_back(c);
+        right.push_back(c + 1);
+    }
+}
+
+// ----------------------------
+// Sidechain key filter
+
+// Band-limits and rectifies the detector input of a dynamics plug-in, one
+// filter pair per key lane, and combines several keys by max or sum. The
+// console thread sets the cutoffs (0 = off) and mode through handleCommand();
+// the audio thread calls refresh() once per block, then detect() per sample.
+class KeyFilter {
+public:
+    enum Mode { MAX = 0, SUM = 1 };
+
+    KeyFilter() : hpfHz(0.0f), lpfHz(0.0f), mode(MAX), fs(48000), useHPF(false), useLPF(false), sumKeys(false) {}
+
+    // Sizes the per-lane filters. Call from the constructor, never from process().
+    void allocate(int lanes, int sampleRate) {
+        fs = sampleRate;
+        // Filters start disabled; refresh() retunes them on first use.
+        highPass.assign(lanes, OnePoleHP(20.0f, fs));
+        lowPass.assign(lanes, OnePoleLP(20000.0f, fs));
+    }
+
+    // Audio thread: picks up new settings and retunes filters whose cutoff changed.
+    void refresh() {
+        float hp = hpfHz.load();
+        float lp = lpfHz.load();
+        useHPF = hp > 0.0f;
+        useLPF = lp > 0.0f && lp < 0.5f * fs;
+        sumKeys = mode.load() == SUM;
+        for (size_t k = 0; k < highPass.size(); k++) {
+            if (useHPF && highPass[k].cutoff != hp)
+                highPass[k].setCutoff(hp, fs);
+            if (useLPF && lowPass[k].cutoff != lp)
+                lowPass[k].setCutoff(lp, fs);
+        }
+    }
+
+    // Audio thread: key-filtered, rectified detector input for lane k.
+    float detect(int k, float x) {
+        if (useHPF)
+            x = highPass[k].process(x);
+        if (useLPF)
+            x = lowPass[k].process(x);
+        return std::fabs(x);
+    }
+
+    // Audio thread: folds one lane's detector value into the combined key.
+    float combine(float key, float d) const {
+        return sumKeys ? key + d : (d > key ? d : key);
+    }
+
+    // Control thread: applies "hpf <Hz>", "lpf <Hz>" or "mode max|sum". Returns
+    // false if the line is not a key command. A key command with a bad value is
+    // still consumed, with valid set to false so the caller reports invalid input.
+    bool handleCommand(const std::string& line, const char* tag, std::mutex& printMutex, bool& valid) {
+        char cmd[8] = { 0 }, value[32] = { 0 }, extra = 0;
+        int fields = std::sscanf(line.c_str(), "%7s %31s %c", cmd, value, &extra);
+        std::string name(cmd);
+        if (fields < 1 || (name != "hpf" && name != "lpf" && name != "mode"))
+            return false;
+        valid = false;
+        if (fields != 2)
+            return true;
+        std::lock_guard<std::mutex> lock(printMutex);
+        if (name == "mode") {
+            std::string m(value);
+            if (m != "max" && m != "sum")
+                return true;
+            mode.store(m == "sum" ? SUM : MAX);
+            std::cout << "[" << tag << "] Sidechains combined by " << m << std::endl;
+        }
+        else {
+            float hz;
+            if (!parseNumber(value, hz))
+                return true;
+            if (hz < 0.0f)
+                hz = 0.0f;
+            (name == "hpf" ? hpfHz : lpfHz).store(hz);
+            std::cout << "[" << tag << "] Key " << name << " = " << hz << " Hz" << (hz == 0.0f ? " (off)" : "") << std::endl;
+        }
+        valid = true;
+        return true;
+    }
+
+private:
+    std::atomic<float> hpfHz;  // detector high-pass cutoff in Hz (0 = off)
+    std::atomic<float> lpfHz;  // detector low-pass cutoff in Hz (0 = off)
+    std::atomic<int> mode;     // how multiple keys are combined
+    int fs;
+    // Audio-thread state, latched by refresh().
+    bool useHPF, useLPF, sumKeys;
+    std::vector<OnePoleHP> highPass;
+    std::vector<OnePoleLP> lowPass;
+};
+
+// ----------------------------
+// Plug-in base class
+
+// Owns the JACK client and the console control thread. Derived plug-ins
+// register their ports in the constructor, then call activate() once all
+// DSP state is ready. run() blocks until the user types 'q' and deactivates
+// the client before returning, so process() never runs on a half-destroyed object.
+class Plugin {
+public:
+    explicit Plugin(const char* client_name)
+        : name(client_name), client(nullptr), sample_rate(0), running(true), active(false)
+    {
+        jack_status_t status;
+        client = jack_client_open(client_name, JackNullOption, &status);
+        if (!client) {
+            throw std::runtime_error(name + ": Failed to open JACK client");
+        }
+        sample_rate = jack_get_sample_rate(client);
+    }
+
+    virtual ~Plugin() {
+        stop();
+        if (client)
+            jack_client_close(client);
+    }
+
+    void run() {
+        std::cout << "[" << name << "] Running. Type 'q' in the control console to quit." << std::endl;
+        while (running.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        stop();
+        std::cout << "[" << name << "] Shutting down." << std::endl;
+    }
+
+    void stop() {
+        running.store(false);
+        if (active) {
+            jack_deactivate(client);
+            active = false;
+        }
+        if (control_thread.joinable())
+            control_thread.join();
+    }
+
+protected:
+    std::string name;
+    jack_client_t* client;
+    int sample_rate;
+    std::atomic<bool> running;
+    std::mutex print_mutex;
+
+    // Audio thread: render one block.
+    virtual int process(jack_nframes_t nframes) = 0;
+    // Control thread: print the parameter prompt (print_mutex is held).
+    virtual void printPrompt() = 0;
+    // Control thread: apply one console line. Return false if it could not be parsed.
+    virtual bool handleCommand(const std::string& line) = 0;
+
+    jack_port_t* registerInput(const std::string& port, const char* type = JACK_DEFAULT_AUDIO_TYPE) {
+        return registerPort(port, type, JackPortIsInput);
+    }
+    jack_port_t* registerOutput(const std::string& port, const char* type = JACK_DEFAULT_AUDIO_TYPE) {
+        return registerPort(port, type, JackPortIsOutput);
+    }
+
+    static float* audioBuffer(jack_port_t* port, jack_nframes_t nframes) {
+        return static_cast<float*>(jack_port_get_buffer(port, nframes));
+    }
+
+    // Installs the process callback, activates the client and starts the console.
+    void activate() {
+        if (jack_set_process_callback(client, process_trampoline, this) != 0) {
+            throw std::runtime_error(name + ": Failed to set process callback");
+        }
+        if (jack_activate(client) != 0) {
+            throw std::runtime_error(name + ": Failed to activate JACK client");
+        }
+        active = true;
+        control_thread = std::thread(&Plugin::control_loop, this);
+    }
+
+private:
+    std::thread control_thread;
+    bool active;
+
+    jack_port_t* registerPort(const std::string& port, const char* type, unsigned long flags) {
+        jack_port_t* p = jack_port_register(client, port.c_str(), type, flags, 0);
+        if (!p) {
+            throw std::runtime_error(name + ": Failed to register JACK ports");
+        }
+        return p;
+    }
+
+    static int process_trampoline(jack_nframes_t nframes, void* arg) {
+        enableFlushToZero();
+        return static_cast<Plugin*>(arg)->process(nframes);
+    }
+
+    void control_loop() {
+        std::string line;
+        while (running.load()) {
+            {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                printPrompt();
+            }
+            if (!std::getline(std::cin, line))
+                break;
+            if (line == "q" || line == "Q") {
+                running.store(false);
+                break;
+            }
+            if (!handleCommand(line)) {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                std::cout << "[" << name << "] Invalid input. Please try again." << std::endl;
+            }
+        }
+    }
+};
+
+} // namespace phantom
+
+#endif // PHANTOM_RUNTIME_H
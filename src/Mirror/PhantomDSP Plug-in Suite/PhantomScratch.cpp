@@ -1,110 +1,279 @@
 // PhantomScratch.cpp
 // A simple mono vinyl scratch simulator using JACK and standard C++.
-// It uses a circular delay buffer and a variable-speed read pointer to simulate the sound of a vinyl scratch.
-// When scratch speed is zero, the plugin writes new samples to the buffer and outputs the dry signal.
-// When scratch speed is nonzero, the delay buffer is "frozen" and the read pointer is advanced at the specified speed.
+// It uses a circular record buffer and a variable-speed read pointer to simulate the sound of a vinyl scratch.
+// When the platter is released, the plugin writes new samples to the buffer and outputs the dry signal.
+// When the platter is touched, the record buffer is "frozen" and the read pointer follows the platter velocity.
 // A mix parameter blends the scratch-processed signal with the dry signal.
 //
+// Scratch engine:
+//   - The record buffer is preallocated (8 seconds, rounded up to a power of two) so wrapping is a mask.
+//   - Reads use 4-point Hermite or 8-tap Blackman-windowed sinc interpolation from precomputed
+//     polyphase tables: the fractional position picks a table row, so a Hermite read costs four
+//     multiply-adds, close to the old linear read. Linear is kept as a third option.
+//   - Platter velocity is smoothed per sample towards its target with a one-pole ramp.
+//   - Control messages reach the audio thread through a lock-free single-producer queue (console)
+//     or the "midi_in" JACK MIDI port. MIDI events carry their frame offset, so platter moves
+//     land on the exact sample.
+//
+// MIDI mapping (any channel):
+//   - Note on / CC 64 >= 64: touch the platter (freeze the record and start scratching).
+//   - Note off / CC 64 < 64: release the platter (resume normal playback).
+//   - Pitch bend: platter velocity, -4.0 .. +4.0 times normal speed (centre = stopped hand).
+//
 // Real-time adjustable parameters (via console):
-//   - Scratch Speed (float): in samples per sample; 0.0 means normal mode,
+//   - Scratch Speed (float): in samples per sample; 0.0 releases the platter (normal mode),
 //       positive values play forward (e.g., 1.0 is normal speed, 2.0 is double speed),
 //       negative values play in reverse.
 //   - Mix (0.0 = 100% dry, 1.0 = 100% scratch signal)
+//   - "interp linear|hermite|sinc" selects the interpolator (default hermite).
+//   - "smooth <ms>" sets the velocity ramp time (default 5 ms).
 //
 // Compile with:
 //   g++ -std=c++11 PhantomScratch.cpp -ljack -lpthread -o PhantomScratch
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
+#include <jack/midiport.h>
 #include <iostream>
 #include <vector>
 #include <atomic>
-#include <thread>
 #include <mutex>
+#include <thread>
+#include <chrono>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
-#include <chrono>
 #include <string>
+#include <cstdlib>
 
 using namespace std;
 
-class PhantomScratch {
+// Fixed-size single-producer/single-consumer queue. The control thread pushes,
+// the JACK thread pops; neither side ever blocks or allocates.
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {}
+    bool push(const T& item) {
+        size_t t = tail.load(memory_order_relaxed);
+        size_t next = (t + 1) % N;
+        if (next == head.load(memory_order_acquire))
+            return false; // full
+        items[t] = item;
+        tail.store(next, memory_order_release);
+        return true;
+    }
+    // Producer side: true if the next 'count' pushes are guaranteed to fit.
+    bool hasRoom(size_t count) const {
+        size_t used = (tail.load(memory_order_relaxed) + N - head.load(memory_order_acquire)) % N;
+        return used + count < N;
+    }
+    bool pop(T& item) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire))
+            return false; // empty
+        item = items[h];
+        head.store((h + 1) % N, memory_order_release);
+        return true;
+    }
+private:
+    T items[N];
+    atomic<size_t> head;
+    atomic<size_t> tail;
+};
+
+class PhantomScratch : public phantom::Plugin {
+public:
+    enum Interp { INTERP_LINEAR = 0, INTERP_HERMITE = 1, INTERP_SINC = 2 };
+
 private:
-    jack_client_t* client;
+    // Control message sent from the console to the audio thread.
+    struct ScratchMessage {
+        enum Type { TOUCH, RELEASE, VELOCITY } type;
+        float value;
+    };
+
+    static const int RECORD_SECONDS = 8;
+    static const int TABLE_PHASES = 1024;  // fractional positions per sample
+    static const int SINC_TAPS = 8;
+
     jack_port_t* in_port;
     jack_port_t* out_port;
-    int sample_rate;
-
-    atomic<bool> running;
-    thread control_thread;
-    mutex print_mutex;
+    jack_port_t* midi_port;
 
     // Parameters:
-    // scratchSpeed: if 0.0, normal mode (no scratch effect, delay buffer updates continuously).
-    // If nonzero, the delay buffer is frozen and the read pointer is advanced at this rate.
+    // scratchSpeed: last platter speed requested from the console (0.0 = released, normal mode).
+    // If nonzero, the record buffer is frozen and the read pointer is advanced at this rate.
     atomic<float> scratchSpeed;  // in samples per sample. Typical values: 0.0 (normal), 1.0 (normal forward), -1.0 (normal reverse), >1 or < -1 for speed variations.
     atomic<float> mix;           // Mix between dry and scratch output (0.0 = dry, 1.0 = fully processed).
+    atomic<int> interpMode;      // Interp
+    atomic<float> smoothMs;      // velocity ramp time constant
 
-    // Delay buffer to store incoming audio.
-    vector<float> delayBuffer;
-    size_t bufferSize;  // e.g., 1 second of audio.
-    size_t writeIndex;  // Position where new samples are written.
-    float readPointer;  // Floating-point read pointer for scratch playback.
+    SpscQueue<ScratchMessage, 256> messages;
 
-    // We also maintain a flag to know if we are currently in scratch mode.
-    // When switching from normal to scratch mode, we "freeze" the delay buffer.
-    // When switching back to normal, we resume updating the delay buffer.
-    // (We simply check if scratchSpeed is nonzero.)
+    // Record buffer to store incoming audio (power-of-two length).
+    vector<float> recordBuffer;
+    size_t bufferSize;
+    size_t bufferMask;
+    size_t writeIndex;   // Position where new samples are written.
+    double readPointer;  // Read position; double keeps sub-sample precision across several seconds.
+
+    // Platter state, owned by the audio thread.
+    bool touched;
+    float velocity;        // smoothed speed, samples per sample
+    float targetVelocity;  // speed the ramp is heading for
+
+    // Polyphase interpolation tables: row p holds the taps for fraction p / TABLE_PHASES.
+    vector<float> hermiteTable;  // TABLE_PHASES x 4
+    vector<float> sincTable;     // TABLE_PHASES x SINC_TAPS
+
+    void buildTables() {
+        hermiteTable.resize(TABLE_PHASES * 4);
+        sincTable.resize(TABLE_PHASES * SINC_TAPS);
+        for (int p = 0; p < TABLE_PHASES; p++) {
+            double t = static_cast<double>(p) / TABLE_PHASES;
+            double t2 = t * t;
+            double t3 = t2 * t;
+            // Catmull-Rom Hermite weights for x[-1], x[0], x[1], x[2].
+            float* h = &hermiteTable[p * 4];
+            h[0] = static_cast<float>(0.5 * (-t3 + 2.0 * t2 - t));
+            h[1] = static_cast<float>(0.5 * (3.0 * t3 - 5.0 * t2 + 2.0));
+            h[2] = static_cast<float>(0.5 * (-3.0 * t3 + 4.0 * t2 + t));
+            h[3] = static_cast<float>(0.5 * (t3 - t2));
+
+            // Blackman-windowed sinc over taps x[-3] .. x[4], normalised to unity gain.
+            float* w = &sincTable[p * SINC_TAPS];
+            double sum = 0.0;
+            for (int k = 0; k < SINC_TAPS; k++) {
+                double x = (k - (SINC_TAPS / 2 - 1)) - t;
+                double sinc = (fabs(x) < 1e-9) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+                double n = (x + SINC_TAPS / 2) / SINC_TAPS;  // 0..1 across the window
+                double win = 0.42 - 0.5 * cos(2.0 * M_PI * n) + 0.08 * cos(4.0 * M_PI * n);
+                w[k] = static_cast<float>(sinc * win);
+                sum += sinc * win;
+            }
+            for (int k = 0; k < SINC_TAPS; k++)
+                w[k] = static_cast<float>(w[k] / sum);
+        }
+    }
+
+    // Reads the record buffer at a fractional position using the selected interpolator.
+    inline float readInterpolated(double pos, int mode) const {
+        double base = floor(pos);
+        size_t i0 = static_cast<size_t>(static_cast<long long>(base)) & bufferMask;
+        float frac = static_cast<float>(pos - base);
+        const float* buf = recordBuffer.data();
+        if (mode == INTERP_LINEAR) {
+            return (1.0f - frac) * buf[i0] + frac * buf[(i0 + 1) & bufferMask];
+        }
+        int phase = static_cast<int>(frac * TABLE_PHASES);
+        if (phase >= TABLE_PHASES)
+            phase = TABLE_PHASES - 1;
+        if (mode == INTERP_HERMITE) {
+            const float* h = &hermiteTable[phase * 4];
+            return h[0] * buf[(i0 - 1) & bufferMask] + h[1] * buf[i0]
+                + h[2] * buf[(i0 + 1) & bufferMask] + h[3] * buf[(i0 + 2) & bufferMask];
+        }
+        const float* w = &sincTable[phase * SINC_TAPS];
+        size_t start = i0 - (SINC_TAPS / 2 - 1);
+        float acc = 0.0f;
+        for (int k = 0; k < SINC_TAPS; k++)
+            acc += w[k] * buf[(start + k) & bufferMask];
+        return acc;
+    }
+
+    void applyMessage(const ScratchMessage& msg) {
+        switch (msg.type) {
+        case ScratchMessage::TOUCH:
+            if (!touched) {
+                // Freeze the record: the needle starts at the newest sample.
+                touched = true;
+                readPointer = static_cast<double>((writeIndex - 1) & bufferMask);
+                velocity = 1.0f;  // the record was turning at normal speed when grabbed
+            }
+            break;
+        case ScratchMessage::RELEASE:
+            touched = false;
+            break;
+        case ScratchMessage::VELOCITY:
+            targetVelocity = msg.value;
+            break;
+        }
+    }
+
+    // Translates one JACK MIDI event into a platter message. Returns false if ignored.
+    static bool midiToMessage(const jack_midi_event_t& ev, ScratchMessage& msg) {
+        if (ev.size < 3)
+            return false;
+        unsigned char status = ev.buffer[0] & 0xF0;
+        unsigned char d1 = ev.buffer[1];
+        unsigned char d2 = ev.buffer[2];
+        if (status == 0x90 && d2 > 0) {
+            msg.type = ScratchMessage::TOUCH;
+        }
+        else if (status == 0x80 || (status == 0x90 && d2 == 0)) {
+            msg.type = ScratchMessage::RELEASE;
+        }
+        else if (status == 0xB0 && d1 == 64) {
+            msg.type = (d2 >= 64) ? ScratchMessage::TOUCH : ScratchMessage::RELEASE;
+        }
+        else if (status == 0xE0) {
+            int bend = ((d2 << 7) | d1) - 8192;  // -8192 .. 8191
+            msg.type = ScratchMessage::VELOCITY;
+            msg.value = 4.0f * static_cast<float>(bend) / 8192.0f;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
 
     // JACK process callback.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomScratch* ps = static_cast<PhantomScratch*>(arg);
-        float* in = static_cast<float*>(jack_port_get_buffer(ps->in_port, nframes));
-        float* out = static_cast<float*>(jack_port_get_buffer(ps->out_port, nframes));
+    int process(jack_nframes_t nframes) override {
+        float* in = audioBuffer(in_port, nframes);
+        float* out = audioBuffer(out_port, nframes);
+        void* midiBuf = jack_port_get_buffer(midi_port, nframes);
+
+        // Console messages have no timestamp; they take effect at the start of the block.
+        ScratchMessage msg;
+        while (messages.pop(msg))
+            applyMessage(msg);
 
         // Get current parameters.
-        float currentScratchSpeed = ps->scratchSpeed.load();
-        float currentMix = ps->mix.load();
+        float currentMix = mix.load();
+        int mode = interpMode.load();
+        float smoothCoeff = 1.0f - expf(-1000.0f / (smoothMs.load() * sample_rate));
+
+        uint32_t midiCount = jack_midi_get_event_count(midiBuf);
+        uint32_t midiIndex = 0;
+        jack_midi_event_t ev;
+        bool haveEvent = midiCount > 0 && jack_midi_event_get(&ev, midiBuf, 0) == 0;
 
+        const double size = static_cast<double>(bufferSize);
         for (jack_nframes_t i = 0; i < nframes; i++) {
+            // Apply every MIDI event stamped for this frame.
+            while (haveEvent && ev.time <= i) {
+                if (midiToMessage(ev, msg))
+                    applyMessage(msg);
+                haveEvent = ++midiIndex < midiCount && jack_midi_event_get(&ev, midiBuf, midiIndex) == 0;
+            }
+
             float dry = in[i];
-            float processed = 0.0f;
-            if (fabs(currentScratchSpeed) < 1e-6f) {
-                // Normal mode: update delay buffer with new sample.
-                ps->delayBuffer[ps->writeIndex] = dry;
-                // Set read pointer equal to writeIndex (or writeIndex - offset if desired).
-                ps->readPointer = static_cast<float>(ps->writeIndex);
-                // Output is just the dry signal (or could blend, but typically mix is 0 when not scratching).
+            float processed;
+            if (!touched) {
+                // Normal mode: update the record buffer with the new sample and pass the dry signal.
+                recordBuffer[writeIndex] = dry;
+                writeIndex = (writeIndex + 1) & bufferMask;
                 processed = dry;
             }
             else {
-                // Scratch mode: do NOT update the delay buffer.
-                // Instead, read from the buffer at the current read pointer.
-                // Use linear interpolation.
-                float readPos = ps->readPointer;
-                // Wrap readPos into [0, bufferSize).
-                while (readPos < 0) readPos += ps->bufferSize;
-                while (readPos >= ps->bufferSize) readPos -= ps->bufferSize;
-                size_t index0 = static_cast<size_t>(floor(readPos));
-                size_t index1 = (index0 + 1) % ps->bufferSize;
-                float frac = readPos - floor(readPos);
-                processed = (1.0f - frac) * ps->delayBuffer[index0] + frac * ps->delayBuffer[index1];
-                // Advance read pointer by scratch speed.
-                ps->readPointer += currentScratchSpeed;
-                // Wrap readPointer.
-                if (ps->readPointer < 0)
-                    ps->readPointer += ps->bufferSize;
-                if (ps->readPointer >= ps->bufferSize)
-                    ps->readPointer -= ps->bufferSize;
-            }
-            // In both modes, update the write index (only in normal mode we update the buffer).
-            if (fabs(currentScratchSpeed) < 1e-6f) {
-                ps->writeIndex = (ps->writeIndex + 1) % ps->bufferSize;
-            }
-            else {
-                // In scratch mode, we might choose not to update the write pointer.
-                // For a true scratch simulation, we "freeze" the buffer.
-                // So we do nothing here.
+                // Scratch mode: the buffer is frozen; read at the needle and move it by the ramped velocity.
+                velocity += (targetVelocity - velocity) * smoothCoeff;
+                processed = readInterpolated(readPointer, mode);
+                readPointer += velocity;
+                if (readPointer < 0.0)
+                    readPointer += size;
+                else if (readPointer >= size)
+                    readPointer -= size;
             }
             // Blend the dry signal and the processed (scratch) signal.
             out[i] = (1.0f - currentMix) * dry + currentMix * processed;
@@ -113,103 +282,115 @@ private:
     }
 
     // Control thread: allows updating scratch parameters via console.
-    void control_loop() {
-        string line;
-        while (running.load()) {
-            {
-                lock_guard<mutex> lock(print_mutex);
-                cout << "\n[PhantomScratch] Enter parameters: scratchSpeed (samples per sample, 0.0 = normal, e.g., 1.0, -1.0, 2.0, etc.) and mix (0.0-1.0)" << endl;
-                cout << "e.g., \"1.0 1.0\" for normal forward scratch, \"-1.0 1.0\" for reverse scratch, or \"0 0\" to resume normal playback, or 'q' to quit: ";
-            }
-            if (!getline(cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            istringstream iss(line);
-            float newSpeed, newMix;
-            if (!(iss >> newSpeed >> newMix)) {
+    void printPrompt() override {
+        cout << "\n[PhantomScratch] Enter parameters: scratchSpeed (samples per sample, 0.0 = normal, e.g., 1.0, -1.0, 2.0, etc.) and mix (0.0-1.0)" << endl;
+        cout << "e.g., \"1.0 1.0\" for normal forward scratch, \"-1.0 1.0\" for reverse scratch, or \"0 0\" to resume normal playback," << endl;
+        cout << "\"interp linear|hermite|sinc\", \"smooth <ms>\", or 'q' to quit: ";
+    }
+
+    // Control thread: waits up to ~100 ms for the audio thread to drain the
+    // queue until 'count' messages fit, so a TOUCH never lands without its
+    // VELOCITY. False if it never made room (e.g. JACK stopped calling process()).
+    bool waitForRoom(size_t count) {
+        for (int tries = 0; !messages.hasRoom(count); tries++) {
+            if (tries == 100)
+                return false;
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    bool handleCommand(const string& line) override {
+        istringstream iss(line);
+        string cmd, value, extra;
+        istringstream peek(line);
+        if (peek >> cmd && (cmd == "interp" || cmd == "smooth")) {
+            float ms;
+            if (!(peek >> value) || (peek >> extra))
+                return false;
+            if (cmd == "interp" && (value == "linear" || value == "hermite" || value == "sinc")) {
+                interpMode.store(value == "linear" ? INTERP_LINEAR : value == "hermite" ? INTERP_HERMITE : INTERP_SINC);
                 lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomScratch] Invalid input. Please try again." << endl;
-                continue;
+                cout << "[PhantomScratch] Interpolation: " << value << endl;
+                return true;
             }
-            // No clamping on newSpeed (it can be negative, positive, or zero).
-            if (newMix < 0.0f) newMix = 0.0f;
-            if (newMix > 1.0f) newMix = 1.0f;
-            scratchSpeed.store(newSpeed);
-            mix.store(newMix);
-            {
+            if (cmd == "smooth" && phantom::parseNumber(value, ms) && ms > 0.0f) {
+                smoothMs.store(ms);
                 lock_guard<mutex> lock(print_mutex);
-                cout << "[PhantomScratch] Updated parameters:" << endl;
-                cout << "  Scratch Speed = " << newSpeed << " samples per sample" << endl;
-                cout << "  Mix = " << newMix << endl;
+                cout << "[PhantomScratch] Velocity smoothing: " << ms << " ms" << endl;
+                return true;
             }
+            return false;
+        }
+        float newSpeed, newMix;
+        if (!(iss >> newSpeed >> newMix))
+            return false;
+        // No clamping on newSpeed (it can be negative, positive, or zero).
+        if (newMix < 0.0f) newMix = 0.0f;
+        if (newMix > 1.0f) newMix = 1.0f;
+        // Hand the platter move to the audio thread; a release is one message,
+        // a touch is TOUCH followed by its VELOCITY.
+        bool release = fabs(newSpeed) < 1e-6f;
+        if (!waitForRoom(release ? 1 : 2)) {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomScratch] Audio thread is not draining messages; platter move dropped." << endl;
+            return true;
+        }
+        // This thread is the only producer, so these pushes cannot fail now.
+        ScratchMessage msg;
+        if (release) {
+            msg.type = ScratchMessage::RELEASE;
+            msg.value = 0.0f;
+            messages.push(msg);
+        }
+        else {
+            msg.type = ScratchMessage::TOUCH;
+            msg.value = 0.0f;
+            messages.push(msg);
+            msg.type = ScratchMessage::VELOCITY;
+            msg.value = newSpeed;
+            messages.push(msg);
         }
+        scratchSpeed.store(newSpeed);
+        mix.store(newMix);
+        {
+            lock_guard<mutex> lock(print_mutex);
+            cout << "[PhantomScratch] Updated parameters:" << endl;
+            cout << "  Scratch Speed = " << newSpeed << " samples per sample" << endl;
+            cout << "  Mix = " << newMix << endl;
+        }
+        return true;
     }
 
 public:
     PhantomScratch(const char* client_name = "PhantomScratch")
-        : client(nullptr), running(true), scratchSpeed(0.0f), mix(0.0f)
+        : phantom::Plugin(client_name), scratchSpeed(0.0f), mix(0.0f),
+        interpMode(INTERP_HERMITE), smoothMs(5.0f),
+        touched(false), velocity(0.0f), targetVelocity(0.0f)
     {
         // Default: normal mode (scratchSpeed 0 means no scratch), mix 0 (dry signal only).
         // Later, the user can set scratchSpeed to nonzero to engage the scratch effect.
-        // Set up a delay buffer of, say, 2 seconds.
-        sample_rate = 44100;  // We'll update after JACK client opens.
-        bufferSize = sample_rate * 2;
-        delayBuffer.resize(bufferSize, 0.0f);
+        buildTables();
+        // Preallocate the record buffer once the sample rate is known.
+        bufferSize = 1;
+        while (bufferSize < static_cast<size_t>(sample_rate) * RECORD_SECONDS)
+            bufferSize <<= 1;
+        bufferMask = bufferSize - 1;
+        recordBuffer.assign(bufferSize, 0.0f);
         writeIndex = 0;
-        readPointer = 0.0f;
+        readPointer = 0.0;
 
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw runtime_error("PhantomScratch: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-        // Resize delay buffer if necessary.
-        bufferSize = sample_rate * 2;
-        delayBuffer.resize(bufferSize, 0.0f);
-        writeIndex = 0;
-        readPointer = 0.0f;
+        in_port = registerInput("in");
+        out_port = registerOutput("out");
+        midi_port = registerInput("midi_in", JACK_DEFAULT_MIDI_TYPE);
 
-        in_port = jack_port_register(client, "in", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        out_port = jack_port_register(client, "out", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!in_port || !out_port) {
-            jack_client_close(client);
-            throw runtime_error("PhantomScratch: Failed to register JACK ports");
-        }
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomScratch: Failed to set process callback");
-        }
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw runtime_error("PhantomScratch: Failed to activate JACK client");
-        }
-
-        control_thread = thread(&PhantomScratch::control_loop, this);
+        activate();
 
         lock_guard<mutex> lock(print_mutex);
-        cout << "[PhantomScratch] Initialized. Sample rate: " << sample_rate << " Hz" << endl;
+        cout << "[PhantomScratch] Initialized. Sample rate: " << sample_rate << " Hz, record buffer: "
+            << static_cast<double>(bufferSize) / sample_rate << " s" << endl;
         cout << "[PhantomScratch] Default parameters: scratchSpeed = " << scratchSpeed.load() << " (normal mode), mix = " << mix.load() << " (dry)" << endl;
     }
-
-    ~PhantomScratch() {
-        running.store(false);
-        if (control_thread.joinable())
-            control_thread.join();
-        if (client)
-            jack_client_close(client);
-    }
-
-    void run() {
-        cout << "[PhantomScratch] Running. Type 'q' in the control console to quit." << endl;
-        while (running.load()) {
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-        cout << "[PhantomScratch] Shutting down." << endl;
-    }
 };
 
 int main() {
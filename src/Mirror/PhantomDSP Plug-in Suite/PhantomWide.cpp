@@ -1,158 +1,132 @@
 // PhantomWide.cpp
 // A simple real-time stereo widening effect using JACK
 //
+// The channel count is given on the command line (2, 4, 6 or 8; default 2).
+// Each stereo pair of the bus is widened; for 5.1/7.1 the centre and LFE
+// channels are passed through.
+//
 // Compile with:
 //   g++ -std=c++11 PhantomWide.cpp -ljack -lpthread -o PhantomWide
+// Usage:
+//   ./PhantomWide [channels]
 
-#include <jack/jack.h>
+#include "PhantomRuntime.h"
 #include <iostream>
 #include <atomic>
-#include <thread>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
-#include <chrono>
 #include <cmath>
+#include <string>
+#include <vector>
+#include <cstdlib>
 
-class PhantomWide {
-private:
-    jack_client_t* client;
-    jack_port_t* input_port_left;
-    jack_port_t* input_port_right;
-    jack_port_t* output_port_left;
-    jack_port_t* output_port_right;
-    int sample_rate;
+class PhantomWide : public phantom::Plugin {
+public:
+    static const int MAX_CHANNELS = 8;
 
-    std::atomic<bool> running;
-    std::thread control_thread;
-    std::mutex print_mutex;
+private:
+    int num_channels;
+    std::vector<jack_port_t*> input_ports;
+    std::vector<jack_port_t*> output_ports;
+    std::vector<int> pair_left, pair_right, singles;
+    std::vector<float*> in_bufs, out_bufs;
 
     // Stereo widening parameter:
     // side_gain: multiplier applied to the side channel.
     // Default 1.0 means no change.
     std::atomic<float> side_gain;
 
-    // JACK process callback: processes stereo audio.
-    static int process_callback(jack_nframes_t nframes, void* arg) {
-        PhantomWide* wide = static_cast<PhantomWide*>(arg);
-        float* inL = static_cast<float*>(jack_port_get_buffer(wide->input_port_left, nframes));
-        float* inR = static_cast<float*>(jack_port_get_buffer(wide->input_port_right, nframes));
-        float* outL = static_cast<float*>(jack_port_get_buffer(wide->output_port_left, nframes));
-        float* outR = static_cast<float*>(jack_port_get_buffer(wide->output_port_right, nframes));
-
-        float current_side_gain = wide->side_gain.load();
+    // JACK process callback: processes every stereo pair of the bus.
+    int process(jack_nframes_t nframes) override {
+        for (int c = 0; c < num_channels; c++) {
+            in_bufs[c] = audioBuffer(input_ports[c], nframes);
+            out_bufs[c] = audioBuffer(output_ports[c], nframes);
+        }
 
-        // Process each sample frame
-        for (jack_nframes_t i = 0; i < nframes; i++) {
-            float L = inL[i];
-            float R = inR[i];
-            // Convert to mid-side representation
-            float mid = 0.5f * (L + R);
-            float side = 0.5f * (L - R);
-            // Apply widening factor to the side channel
-            side *= current_side_gain;
-            // Reconstruct stereo signal
-            outL[i] = mid + side;
-            outR[i] = mid - side;
+        float current_side_gain = side_gain.load();
+
+        for (size_t p = 0; p < pair_left.size(); p++) {
+            const float* inL = in_bufs[pair_left[p]];
+            const float* inR = in_bufs[pair_right[p]];
+            float* outL = out_bufs[pair_left[p]];
+            float* outR = out_bufs[pair_right[p]];
+            // Process each sample frame
+            for (jack_nframes_t i = 0; i < nframes; i++) {
+                float L = inL[i];
+                float R = inR[i];
+                // Convert to mid-side representation
+                float mid = 0.5f * (L + R);
+                float side = 0.5f * (L - R);
+                // Apply widening factor to the side channel
+                side *= current_side_gain;
+                // Reconstruct stereo signal
+                outL[i] = mid + side;
+                outR[i] = mid - side;
+            }
+        }
+        // Centre and LFE have no width; copy them through.
+        for (int c : singles) {
+            const float* in = in_bufs[c];
+            float* out = out_bufs[c];
+            for (jack_nframes_t i = 0; i < nframes; i++)
+                out[i] = in[i];
         }
         return 0;
     }
 
     // Control thread: allows real-time adjustment of the side gain.
-    void control_loop() {
-        std::string line;
-        while (running.load()) {
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "\n[PhantomWide] Enter new side gain (e.g., 1.0 for no change, 1.5 to widen, 0.8 to narrow), or type 'q' to quit: ";
-            }
-            if (!std::getline(std::cin, line))
-                break;
-            if (line == "q" || line == "Q") {
-                running.store(false);
-                break;
-            }
-            std::istringstream iss(line);
-            float new_side_gain;
-            if (!(iss >> new_side_gain)) {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomWide] Invalid input. Please try again." << std::endl;
-                continue;
-            }
-            side_gain.store(new_side_gain);
-            {
-                std::lock_guard<std::mutex> lock(print_mutex);
-                std::cout << "[PhantomWide] Updated side gain: " << new_side_gain << std::endl;
-            }
-        }
+    void printPrompt() override {
+        std::cout << "\n[PhantomWide] Enter new side gain (e.g., 1.0 for no change, 1.5 to widen, 0.8 to narrow), or type 'q' to quit: ";
     }
 
-public:
-    PhantomWide(const char* client_name = "PhantomWide")
-        : client(nullptr),
-        input_port_left(nullptr), input_port_right(nullptr),
-        output_port_left(nullptr), output_port_right(nullptr),
-        running(true), side_gain(1.0f) {
-        jack_status_t status;
-        client = jack_client_open(client_name, JackNullOption, &status);
-        if (!client) {
-            throw std::runtime_error("PhantomWide: Failed to open JACK client");
-        }
-        sample_rate = jack_get_sample_rate(client);
-
-        // Register stereo input ports
-        input_port_left = jack_port_register(client, "input_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        input_port_right = jack_port_register(client, "input_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
-        // Register stereo output ports
-        output_port_left = jack_port_register(client, "output_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        output_port_right = jack_port_register(client, "output_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-        if (!input_port_left || !input_port_right || !output_port_left || !output_port_right) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomWide: Failed to register JACK ports");
+    bool handleCommand(const std::string& line) override {
+        std::istringstream iss(line);
+        float new_side_gain;
+        if (!(iss >> new_side_gain))
+            return false;
+        side_gain.store(new_side_gain);
+        {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "[PhantomWide] Updated side gain: " << new_side_gain << std::endl;
         }
+        return true;
+    }
 
-        if (jack_set_process_callback(client, process_callback, this) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomWide: Failed to set process callback");
+public:
+    PhantomWide(int channels = 2, const char* client_name = "PhantomWide")
+        : phantom::Plugin(client_name), num_channels(channels), side_gain(1.0f) {
+        if (channels < 2 || channels > MAX_CHANNELS || channels % 2 != 0) {
+            throw std::runtime_error("PhantomWide: Channel count must be 2, 4, 6 or 8");
         }
-
-        if (jack_activate(client) != 0) {
-            jack_client_close(client);
-            throw std::runtime_error("PhantomWide: Failed to activate JACK client");
+        phantom::stereoPairs(num_channels, pair_left, pair_right, singles);
+        in_bufs.assign(num_channels, nullptr);
+        out_bufs.assign(num_channels, nullptr);
+
+        // Register one input and one output port per channel
+        for (int c = 0; c < num_channels; c++) {
+            jack_port_t* in = registerInput(phantom::channelPortName("input", c, num_channels));
+            jack_port_t* out = registerOutput(phantom::channelPortName("output", c, num_channels));
+            input_ports.push_back(in);
+            output_ports.push_back(out);
         }
 
-        // Start the control thread for real-time parameter adjustment.
-        control_thread = std::thread(&PhantomWide::control_loop, this);
+        // Activate JACK processing and start the control thread.
+        activate();
 
         {
             std::lock_guard<std::mutex> lock(print_mutex);
-            std::cout << "[PhantomWide] Initialized. Sample rate: " << sample_rate << " Hz" << std::endl;
+            std::cout << "[PhantomWide] Initialized. Sample rate: " << sample_rate << " Hz, channels: "
+                << num_channels << std::endl;
             std::cout << "[PhantomWide] Default side gain: " << side_gain.load() << std::endl;
         }
     }
-
-    ~PhantomWide() {
-        running.store(false);
-        if (control_thread.joinable()) {
-            control_thread.join();
-        }
-        if (client) {
-            jack_client_close(client);
-        }
-    }
-
-    void run() {
-        std::cout << "[PhantomWide] Running. Type 'q' in the control console to quit." << std::endl;
-        while (running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
-        std::cout << "[PhantomWide] Shutting down." << std::endl;
-    }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        PhantomWide wide;
+        int channels = (argc > 1) ? std::atoi(argv[1]) : 2;
+        PhantomWide wide(channels);
         wide.run();
     }
     catch (const std::exception& e) {
@@ -45,6 +45,7 @@
 #include <numeric>
 #include <random>
 #include <ctime>
+#include <chrono>
 
 // ---------------------- ChunkPos Definition and Hash Specialization ----------------------
 struct ChunkPos {
@@ -82,6 +83,7 @@ float cameraRoll = 0.0f; // New roll angle (in degrees)
 // Flight simulator physics
 glm::vec3 cameraVelocity = glm::vec3(0.0f);
 float cameraThrottle = 0.0f;
+float cameraThrottleRate = 0.0f; // throttle change per second from the current input
 const float cameraAcceleration = 50.0f; // How quickly throttle increases
 const float cameraDeceleration = 30.0f; // How quickly throttle decreases
 const float cameraMaxSpeed = 200.0f;
@@ -891,27 +893,182 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
     bigMapDirty = true;
 }
 
-// ---------------------- Chunk Update ----------------------
+// ---------------------- Chunk Streaming ----------------------
+// At full throttle the camera crosses a chunk every 0.08 s, faster than the
+// square around it can be regenerated on the render thread. So the camera's
+// path is extrapolated a couple of seconds ahead, missing chunks are ranked by
+// how soon they will come into view along it, and each frame generates only
+// as many of them as CHUNK_BUDGET_MS allows.
+const float PREFETCH_SECONDS = 2.0f;        // how far ahead the flight path is extrapolated
+const float PREFETCH_STEP_SECONDS = 0.25f;  // spacing of the path samples
+const double CHUNK_BUDGET_MS = 5.0;         // chunk generation per frame
+const float VIEW_CONE_COS = 0.5f;           // 60 degrees: the 45 degree frustum plus room for turning
+const int VIEW_CONE_NEAR_CHUNKS = 2;        // always counted as in view (pitched or rolled views)
+const double STALL_MS = 1000.0 / 30.0;      // chunk work alone pushes the frame under 30 fps
+
+struct StreamingStats {
+    long long frames = 0;
+    long long framesMissingInView = 0;  // frames with any visible chunk not generated yet
+    long long missingInView = 0;        // summed over frames
+    int maxMissingInView = 0;
+    long long stalls = 0;               // frames whose chunk work exceeded STALL_MS
+    double maxChunkMs = 0.0;            // worst chunk work in one frame
+    long long generated = 0;
+    double generateMs = 0.0;
+};
+StreamingStats streamingStats;
+
+// The direction the camera looks, from the same rotation the view matrix uses.
+glm::vec3 cameraViewDirection(float yawDegrees, float pitchDegrees, float rollDegrees) {
+    glm::mat4 transform = glm::yawPitchRoll(glm::radians(yawDegrees), glm::radians(pitchDegrees), glm::radians(rollDegrees));
+    return glm::vec3(transform * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f));
+}
+
+struct PathSample {
+    float time;
+    ChunkPos chunk;
+    glm::vec2 position;  // x/z in blocks
+    glm::vec2 view;      // horizontal view direction, normalized (zero when looking straight down)
+};
+
+// Samples the flight path over the next PREFETCH_SECONDS as processInput would
+// fly it with the controls held as they are: the throttle keeps changing at
+// its current rate and the roll keeps turning the heading.
+std::vector<PathSample> predictFlightPath() {
+    std::vector<PathSample> path;
+    glm::vec3 position = cameraPos;
+    float throttle = cameraThrottle;
+    float sampleYaw = yaw;
+    for (float t = 0.0f; t <= PREFETCH_SECONDS + 0.001f; t += PREFETCH_STEP_SECONDS) {
+        if (t > 0.0f) {
+            throttle = std::min(std::max(throttle + cameraThrottleRate * PREFETCH_STEP_SECONDS, 0.0f), cameraMaxSpeed);
+            sampleYaw += cameraRoll * turnFactor * PREFETCH_STEP_SECONDS;
+            glm::vec3 forward(cos(glm::radians(sampleYaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)),
+                              sin(glm::radians(sampleYaw)) * cos(glm::radians(pitch)));
+            position += glm::normalize(forward) * throttle * PREFETCH_STEP_SECONDS;
+        }
+        glm::vec3 view = cameraViewDirection(sampleYaw, pitch, cameraRoll);
+        glm::vec2 flatView(view.x, view.z);
+        float flatLength = glm::length(flatView);
+        PathSample sample;
+        sample.time = t;
+        sample.chunk = ChunkPos(static_cast<int>(std::floor(position.x / CHUNK_SIZE)), static_cast<int>(std::floor(position.z / CHUNK_SIZE)));
+        sample.position = glm::vec2(position.x, position.z);
+        sample.view = flatLength > 0.2f ? flatView / flatLength : glm::vec2(0.0f);
+        path.push_back(sample);
+    }
+    return path;
+}
+
+bool chunkInViewCone(const PathSample& sample, const ChunkPos& pos) {
+    int renderDistance = static_cast<int>(RENDER_DISTANCE);
+    int dx = pos.x - sample.chunk.x, dz = pos.z - sample.chunk.z;
+    if (std::abs(dx) > renderDistance || std::abs(dz) > renderDistance)
+        return false;
+    if (std::abs(dx) <= VIEW_CONE_NEAR_CHUNKS && std::abs(dz) <= VIEW_CONE_NEAR_CHUNKS)
+        return true;
+    if (sample.view == glm::vec2(0.0f))
+        return true;
+    glm::vec2 toChunk = glm::vec2((pos.x + 0.5f) * CHUNK_SIZE, (pos.z + 0.5f) * CHUNK_SIZE) - sample.position;
+    return glm::dot(glm::normalize(toChunk), sample.view) >= VIEW_CONE_COS;
+}
+
 void updateChunks() {
-    int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
-    int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
     int renderDistance = static_cast<int>(RENDER_DISTANCE);
+    std::vector<PathSample> path = predictFlightPath();
+    auto nearPath = [&](const ChunkPos& pos) {
+        for (const PathSample& sample : path)
+            if (std::abs(pos.x - sample.chunk.x) <= renderDistance && std::abs(pos.z - sample.chunk.z) <= renderDistance)
+                return true;
+        return false;
+    };
     for (auto it = chunks.begin(); it != chunks.end();) {
-        int dx = std::abs(it->first.x - playerChunkX);
-        int dz = std::abs(it->first.z - playerChunkZ);
-        if (dx > renderDistance || dz > renderDistance)
+        if (!nearPath(it->first))
             it = chunks.erase(it);
         else
             ++it;
     }
+
+    // Rank every missing chunk by the first path sample that sees it. Chunks
+    // around the camera that are not in view come last; chunks ahead that the
+    // path never looks at are not fetched at all.
+    std::unordered_map<ChunkPos, float> candidates;
+    for (const PathSample& sample : path) {
+        for (int x = sample.chunk.x - renderDistance; x <= sample.chunk.x + renderDistance; x++) {
+            for (int z = sample.chunk.z - renderDistance; z <= sample.chunk.z + renderDistance; z++) {
+                ChunkPos pos{ x, z };
+                bool inView = chunkInViewCone(sample, pos);
+                if ((!inView && sample.time > 0.0f) || chunks.find(pos) != chunks.end())
+                    continue;
+                float distance = std::sqrt(static_cast<float>((x - sample.chunk.x) * (x - sample.chunk.x) + (z - sample.chunk.z) * (z - sample.chunk.z)));
+                float priority = inView ? sample.time + distance * 0.001f : PREFETCH_SECONDS + 1.0f + distance;
+                auto found = candidates.find(pos);
+                if (found == candidates.end() || priority < found->second)
+                    candidates[pos] = priority;
+            }
+        }
+    }
+    std::vector<std::pair<float, ChunkPos>> queue;
+    queue.reserve(candidates.size());
+    for (const auto& entry : candidates)
+        queue.push_back(std::make_pair(entry.second, entry.first));
+    std::sort(queue.begin(), queue.end(), [](const std::pair<float, ChunkPos>& a, const std::pair<float, ChunkPos>& b) {
+        return a.first < b.first;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    double elapsedMs = 0.0;
+    for (const auto& entry : queue) {
+        if (elapsedMs >= CHUNK_BUDGET_MS)
+            break;
+        const ChunkPos& pos = entry.second;
+        generateChunkMesh(chunks[pos], pos.x, pos.z);
+        streamingStats.generated++;
+        elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    streamingStats.generateMs += elapsedMs;
+    streamingStats.maxChunkMs = std::max(streamingStats.maxChunkMs, frameMs);
+    if (frameMs > STALL_MS)
+        streamingStats.stalls++;
+}
+
+// Chunks inside the render square and the view frustum that have not been
+// generated yet, i.e. holes on screen this frame.
+int countChunksMissingInView(const std::vector<Plane>& frustum) {
+    int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
+    int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
+    int renderDistance = static_cast<int>(RENDER_DISTANCE);
+    int missing = 0;
     for (int x = playerChunkX - renderDistance; x <= playerChunkX + renderDistance; x++) {
         for (int z = playerChunkZ - renderDistance; z <= playerChunkZ + renderDistance; z++) {
-            ChunkPos pos{ x, z };
-            if (chunks.find(pos) == chunks.end())
-                chunks[pos] = Chunk();
-            generateChunkMesh(chunks[pos], x, z);
+            if (chunks.find(ChunkPos(x, z)) != chunks.end())
+                continue;
+            glm::vec3 chunkMin(x * CHUNK_SIZE, MIN_Y, z * CHUNK_SIZE);
+            glm::vec3 chunkMax((x + 1) * CHUNK_SIZE, 150.0f, (z + 1) * CHUNK_SIZE);
+            if (aabbInFrustum(frustum, chunkMin, chunkMax))
+                missing++;
         }
     }
+    return missing;
+}
+
+void recordStreamingFrame(int missingInView) {
+    streamingStats.frames++;
+    streamingStats.missingInView += missingInView;
+    streamingStats.maxMissingInView = std::max(streamingStats.maxMissingInView, missingInView);
+    if (missingInView > 0)
+        streamingStats.framesMissingInView++;
+}
+
+void printStreamingStats() {
+    const StreamingStats& s = streamingStats;
+    double frames = static_cast<double>(std::max(s.frames, 1LL));
+    std::cout << "Streaming: " << chunks.size() << " chunks loaded, " << s.generated << " generated ("
+              << (s.generated ? s.generateMs / s.generated : 0.0) << " ms each)\n"
+              << "  frames with chunks missing in view: " << s.framesMissingInView << " / " << s.frames
+              << ", average " << s.missingInView / frames << ", worst " << s.maxMissingInView << "\n"
+              << "  generation stalls (> " << STALL_MS << " ms): " << s.stalls << ", worst frame " << s.maxChunkMs << " ms\n";
 }
 
 // ---------------------- Input Handling ----------------------
@@ -930,10 +1087,12 @@ void processInput(GLFWwindow* window) {
     }
     // --- Flight Simulator Controls ---
     // Throttle: Increase with W, decrease with S.
+    cameraThrottleRate = 0.0f;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        cameraThrottle += cameraAcceleration * deltaTime;
+        cameraThrottleRate += cameraAcceleration;
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        cameraThrottle -= cameraAcceleration * deltaTime;
+        cameraThrottleRate -= cameraAcceleration;
+    cameraThrottle += cameraThrottleRate * deltaTime;
     if (cameraThrottle < 0) cameraThrottle = 0;
     if (cameraThrottle > cameraMaxSpeed) cameraThrottle = cameraMaxSpeed;
 
@@ -973,6 +1132,18 @@ void processInput(GLFWwindow* window) {
     // Update position.
     cameraPos += cameraVelocity * deltaTime;
 
+    // Print streaming statistics with F3.
+    static bool f3WasPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!f3WasPressed) {
+            printStreamingStats();
+            f3WasPressed = true;
+        }
+    }
+    else {
+        f3WasPressed = false;
+    }
+
     // Exit key.
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
@@ -1667,7 +1838,9 @@ int main() {
             if (pos.x >= qtMinX && pos.x <= qtMaxX && pos.z >= qtMinZ && pos.z <= qtMaxZ)
                 qt.insert(pos, &entry.second);
         }
-        std::vector<Chunk*> visibleChunks = qt.query(extractFrustumPlanes(projection * view));
+        std::vector<Plane> frustum = extractFrustumPlanes(projection * view);
+        std::vector<Chunk*> visibleChunks = qt.query(frustum);
+        recordStreamingFrame(countChunksMissingInView(frustum));
 
         std::vector<glm::vec3> globalGrassInstances;
         std::vector<glm::vec3> globalSandInstances;
@@ -11,10 +11,11 @@
 #include <ctime>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <thread>
 
 const int SCRW = 1280, SCRH = 720;
-// reduce render radius to reduce block count
-const int RADIUS = 32;
+const int RADIUS = 128;
 const int maxHeight = 40; // max height cap for blocks
 
 struct Plate {
@@ -25,6 +26,7 @@ struct Plate {
 };
 
 std::vector<Plate> plates;
+unsigned plateEpoch = 0; // bumped by rebuildPlateGrid(); cached columns from older epochs are stale
 
 float hash(int x, int z) {
     int n = x * 73856093 ^ z * 19349663;
@@ -53,17 +55,75 @@ float fbm(float x, float z) {
 }
 
 #define NBLEND 2 // fewer blends == faster
-void nearestPlates(glm::vec2 p, int* ids, float* ds) {
+
+// Equal distances go to the lower plate index, so the result doesn't depend on visiting order.
+void insertNearest(int id, float d, int* ids, float* ds) {
+    for (int j = 0; j < NBLEND; j++) {
+        if (ids[j] < 0 || d < ds[j] || (d == ds[j] && id < ids[j])) {
+            for (int k = NBLEND - 1; k > j; k--) { ids[k] = ids[k - 1]; ds[k] = ds[k - 1]; }
+            ids[j] = id; ds[j] = d; return;
+        }
+    }
+}
+
+void nearestPlatesLinear(glm::vec2 p, int* ids, float* ds) {
     for (int i = 0; i < NBLEND; i++) { ids[i] = -1; ds[i] = 1e9; }
-    for (size_t i = 0; i < plates.size(); i++) {
-        float d = glm::distance(p, plates[i].seed);
-        for (int j = 0; j < NBLEND; j++) {
-            if (d < ds[j]) {
-                for (int k = NBLEND - 1; k > j; k--) { ids[k] = ids[k - 1]; ds[k] = ds[k - 1]; }
-                ids[j] = int(i); ds[j] = d; break;
-            }
+    for (size_t i = 0; i < plates.size(); i++)
+        insertNearest(int(i), glm::distance(p, plates[i].seed), ids, ds);
+}
+
+// Uniform grid over the plates' area, a quarter of the mean seed spacing per
+// cell, listing for each cell every plate that can be among the NBLEND nearest
+// to some point in it: those within (NBLEND-th nearest distance from the
+// centre) + 2 * (half diagonal) of the centre. A lookup scans only that short
+// list; points off the grid fall back to scanning every plate.
+struct PlateGrid {
+    glm::vec2 origin;
+    float cell = 1;
+    int w = 0, h = 0;
+    std::vector<int> cellStart;  // w * h + 1 offsets into candidates
+    std::vector<int> candidates; // plate indices, grouped by cell
+};
+PlateGrid plateGrid;
+
+// Call whenever plates are added or move.
+void rebuildPlateGrid() {
+    PlateGrid& g = plateGrid;
+    glm::vec2 lo(1e9f), hi(-1e9f);
+    for (auto& P : plates) { lo = glm::min(lo, P.seed); hi = glm::max(hi, P.seed); }
+    float spacing = std::max(std::sqrt(std::max((hi.x - lo.x) * (hi.y - lo.y), 1.f) / std::max<size_t>(plates.size(), 1)), 4.f);
+    float pad = 8 * spacing; // the grid reaches well past the outermost seeds
+    g.cell = spacing / 4;
+    g.origin = lo - glm::vec2(pad);
+    g.w = int((hi.x - lo.x + 2 * pad) / g.cell) + 1;
+    g.h = int((hi.y - lo.y + 2 * pad) / g.cell) + 1;
+    g.cellStart.assign(1, 0);
+    g.candidates.clear();
+    float reach = g.cell * 1.4143f + 1e-3f; // 2 * half diagonal, plus rounding slack
+    for (int z = 0; z < g.h; z++)
+        for (int x = 0; x < g.w; x++) {
+            glm::vec2 centre = g.origin + (glm::vec2(x, z) + glm::vec2(0.5f)) * g.cell;
+            int ids[NBLEND]; float ds[NBLEND];
+            nearestPlatesLinear(centre, ids, ds);
+            for (size_t i = 0; i < plates.size(); i++)
+                if (glm::distance(centre, plates[i].seed) <= ds[NBLEND - 1] + reach) g.candidates.push_back(int(i));
+            g.cellStart.push_back(int(g.candidates.size()));
         }
+    plateEpoch++;
+}
+
+void nearestPlates(glm::vec2 p, int* ids, float* ds) {
+    const PlateGrid& g = plateGrid;
+    glm::vec2 rel = (p - g.origin) / g.cell;
+    int cx = int(std::floor(rel.x)), cz = int(std::floor(rel.y));
+    if (g.cellStart.size() < 2 || cx < 0 || cz < 0 || cx >= g.w || cz >= g.h) {
+        nearestPlatesLinear(p, ids, ds);
+        return;
     }
+    for (int i = 0; i < NBLEND; i++) { ids[i] = -1; ds[i] = 1e9; }
+    int c = cz * g.w + cx;
+    for (int k = g.cellStart[c]; k < g.cellStart[c + 1]; k++)
+        insertNearest(g.candidates[k], glm::distance(p, plates[g.candidates[k]].seed), ids, ds);
 }
 
 float terrainHeightWithStress(float x, float z, float& stress, glm::vec3& col) {
@@ -74,6 +134,18 @@ float terrainHeightWithStress(float x, float z, float& stress, glm::vec3& col) {
     float maxAmp = 0;
     glm::vec3 colorSum(0);
     float n = fbm(x * 0.05, z * 0.05);
+    // The plate under each of the 8 neighbouring columns, shared by every blended
+    // plate. Neighbours are at most sqrt(2) away, so when the nearest plate wins
+    // by more than twice that it is the nearest for all of them too.
+    const int DX[8] = { -1,-1,0,1,1,1,0,-1 }, DZ[8] = { 0,1,1,1,0,-1,-1,-1 };
+    int nbPlate[8];
+    bool inside = NBLEND > 1 && ids[1] >= 0 && ds[1] - ds[0] > 2.f * 1.4143f;
+    for (int k = 0; k < 8; k++) {
+        if (inside) { nbPlate[k] = ids[0]; continue; }
+        int nids[NBLEND]; float nds[NBLEND];
+        nearestPlates(p + glm::vec2(DX[k], DZ[k]), nids, nds);
+        nbPlate[k] = nids[0];
+    }
     for (int j = 0; j < NBLEND; j++) {
         if (ids[j] < 0) continue;
         Plate& P = plates[ids[j]];
@@ -85,12 +157,9 @@ float terrainHeightWithStress(float x, float z, float& stress, glm::vec3& col) {
         float dome = 5 * pow(1 - glm::clamp(r / 64.f, 0.f, 1.f), 2);
 
         float amp = 0;
-        const int DX[8] = { -1,-1,0,1,1,1,0,-1 }, DZ[8] = { 0,1,1,1,0,-1,-1,-1 };
         for (int k = 0; k < 8; k++) {
             glm::vec2 q = p + glm::vec2(DX[k], DZ[k]);
-            int nids[NBLEND]; float nds[NBLEND];
-            nearestPlates(q, nids, nds);
-            int nbid = nids[0]; if (nbid == ids[j]) continue;
+            int nbid = nbPlate[k]; if (nbid == ids[j]) continue;
             glm::vec2 dir = glm::normalize(q - p);
             Plate& N = plates[nbid];
             glm::vec2 rel = P.velocity - N.velocity;
@@ -107,6 +176,77 @@ float terrainHeightWithStress(float x, float z, float& stress, glm::vec3& col) {
     return h / wsum;
 }
 
+// Height and shaded colour of each column in view, in a window that wraps
+// around as the camera moves (slot = column mod FIELD): a step evaluates only
+// the strip of columns it brings in, and nothing is recomputed until the
+// plates change.
+const int FIELD = 2 * RADIUS + 1;
+struct Column {
+    int x, z;
+    unsigned epoch; // 0: never filled
+    int height;
+    glm::vec3 color;
+};
+std::vector<Column> columns(FIELD * FIELD, Column{ 0, 0, 0, 0, glm::vec3(0) });
+
+Column& columnSlot(int x, int z) {
+    int i = ((x % FIELD) + FIELD) % FIELD, k = ((z % FIELD) + FIELD) % FIELD;
+    return columns[k * FIELD + i];
+}
+
+void evaluateColumn(Column& c, int x, int z) {
+    float stress; glm::vec3 col;
+    int h = int(terrainHeightWithStress(x, z, stress, col));
+    if (h > maxHeight) h = maxHeight; // limit height cap
+    float s = glm::clamp(fabs(stress) / 2.f, 0.f, 1.f);
+    c = Column{ x, z, plateEpoch, h, glm::mix(col, glm::vec3(1, 0.3, 0), s) };
+}
+
+// Brings the window around (cx, cz) up to date. A step only brings in a strip
+// or two of columns, cheaper to evaluate here than to start threads for; a
+// plate change or a jump refills the window on every core, threads taking
+// every n-th stale column.
+const size_t SERIAL_COLUMNS = 4 * FIELD;
+void updateColumns(int cx, int cz) {
+    static std::vector<glm::ivec2> stale;
+    stale.clear();
+    for (int z = cz - RADIUS; z <= cz + RADIUS; z++)
+        for (int x = cx - RADIUS; x <= cx + RADIUS; x++) {
+            const Column& c = columnSlot(x, z);
+            if (c.epoch != plateEpoch || c.x != x || c.z != z) stale.push_back(glm::ivec2(x, z));
+        }
+    int threads = stale.size() <= SERIAL_COLUMNS ? 1 : std::max(1, int(std::thread::hardware_concurrency()));
+    auto work = [&](int t) {
+        for (size_t i = t; i < stale.size(); i += threads)
+            evaluateColumn(columnSlot(stale[i].x, stale[i].y), stale[i].x, stale[i].y);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(work, t);
+    work(0);
+    for (auto& t : pool) t.join();
+}
+
+struct Instance { glm::vec3 pos, col; };
+
+// One cube per visible block: the top of each column and the blocks whose
+// sides rise above a neighbour. Columns outside the window count as empty,
+// as they aren't drawn.
+void buildInstances(int cx, int cz, std::vector<Instance>& data) {
+    data.clear();
+    auto heightAt = [&](int x, int z) {
+        if (std::abs(x - cx) > RADIUS || std::abs(z - cz) > RADIUS) return -1;
+        return columnSlot(x, z).height;
+    };
+    for (int x = cx - RADIUS; x <= cx + RADIUS; x++) {
+        for (int z = cz - RADIUS; z <= cz + RADIUS; z++) {
+            const Column& c = columnSlot(x, z);
+            int lowest = std::min({ heightAt(x - 1, z), heightAt(x + 1, z), heightAt(x, z - 1), heightAt(x, z + 1) });
+            for (int y = std::max(0, std::min(c.height, lowest + 1)); y <= c.height; y++)
+                data.push_back({ glm::vec3(x, y, z), c.color });
+        }
+    }
+}
+
 glm::vec3 camPos(0, 30, 0), vel(0);
 float yaw = -90, pitch = 0, dt = 0, lastTime = 0;
 bool onGround = false, firstMouse = true; float lastX = SCRW / 2, lastY = SCRH / 2;
@@ -218,6 +358,10 @@ int main() {
         glm::vec2 v((rand() % 200 - 100) / 100.f, (rand() % 200 - 100) / 100.f);
         plates.emplace_back(s, c, v);
     }
+    rebuildPlateGrid();
+
+    std::vector<Instance> data;
+    int builtX = 0, builtZ = 0; unsigned builtEpoch = 0;
 
     while (!glfwWindowShouldClose(win)) {
         float now = glfwGetTime(); dt = now - lastTime; lastTime = now;
@@ -225,23 +369,15 @@ int main() {
         if (!onGround)vel.y -= 9.8f * dt;
         camPos += vel * dt; collision();
 
-        struct D { glm::vec3 pos, col; };
-        std::vector<D> data; data.reserve(100000); // help avoid realloc
+        // Rebuilt only when the camera crosses into another column or the plates change.
         int cx = int(camPos.x), cz = int(camPos.z);
-        for (int x = cx - RADIUS; x <= cx + RADIUS; x++) {
-            for (int z = cz - RADIUS; z <= cz + RADIUS; z++) {
-                float stress; glm::vec3 col;
-                int h = int(terrainHeightWithStress(x, z, stress, col));
-                if (h > maxHeight) h = maxHeight; // limit height cap
-                float s = glm::clamp(fabs(stress) / 2.f, 0.f, 1.f);
-                glm::vec3 blend = glm::mix(col, glm::vec3(1, 0.3, 0), s);
-                for (int y = 0; y <= h; y++) {
-                    data.push_back({ glm::vec3(x,y,z), blend });
-                }
-            }
+        if (cx != builtX || cz != builtZ || builtEpoch != plateEpoch) {
+            updateColumns(cx, cz);
+            buildInstances(cx, cz, data);
+            glBindBuffer(GL_ARRAY_BUFFER, instvbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * data.size(), data.data(), GL_DYNAMIC_DRAW);
+            builtX = cx; builtZ = cz; builtEpoch = plateEpoch;
         }
-        glBindBuffer(GL_ARRAY_BUFFER, instvbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(D) * data.size(), data.data(), GL_DYNAMIC_DRAW);
 
         glClearColor(0.5, 0.7, 0.9, 1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -21,20 +21,61 @@
 #include <numeric>
 #include <random>
 #include <ctime>
-#include <cstdlib>  // Make sure this is included for rand()
+#include <cstdlib>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <list>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PRISMALS_NOISE_AVX2 1
+#define PRISMALS_NOISE_LANES "AVX2"
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PRISMALS_NOISE_SSE2 1
+#define PRISMALS_NOISE_LANES "SSE2"
+#else
+#define PRISMALS_NOISE_LANES "scalar"
+#endif
 
 // Number of stars and distance from the camera (adjust as needed)
 const int numStars = 1000;
 const float starDistance = 1000.0f;
+const unsigned int STAR_SEED = 7; // the sky is the same every run
 
 std::vector<glm::vec3> generateStarPositions(int count) {
     std::vector<glm::vec3> stars;
     stars.reserve(count);
+    std::mt19937 rng(STAR_SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
     for (int i = 0; i < count; i++) {
         // Generate random spherical coordinates
-        float theta = static_cast<float>(rand()) / RAND_MAX * 2.0f * 3.14159f;
+        float theta = unit(rng) * 2.0f * 3.14159f;
         // Limit phi to the upper hemisphere so stars appear above
-        float phi = static_cast<float>(rand()) / RAND_MAX * 3.14159f * 0.5f;
+        float phi = unit(rng) * 3.14159f * 0.5f;
         // Convert spherical to Cartesian coordinates
         float x = sin(phi) * cos(theta);
         float y = cos(phi);
@@ -101,8 +142,7 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 bool fullscreenMap = false;
 std::unordered_set<ChunkPos> visitedChunks;
-bool bigMapDirty = true;
-std::vector<float> bigMapInterleaved;
+std::vector<ChunkPos> mapDirtyChunks; // chunks whose world map colour changed since the last frame
 float bigMapPanX = 0.0f;
 float bigMapPanZ = 0.0f;
 bool minimapEnabled = true;
@@ -266,8 +306,12 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void processInput(GLFWwindow* window);
 glm::ivec3 raycastForBlock(bool place);
+bool setBlockAt(int x, int y, int z, uint8_t type);
 
 // ---------------------- Perlin Noise Class ----------------------
+// Total noise samples taken (scalar and batched), shown in the F3 stats.
+std::atomic<uint64_t> noiseEvaluations(0);
+
 class PerlinNoise {
 private:
     std::vector<int> p;
@@ -288,7 +332,8 @@ public:
         for (int i = 0; i < 256; i++)
             p[256 + i] = p[i];
     }
-    double noise(double x, double y, double z) {
+    double noise(double x, double y, double z) const {
+        noiseEvaluations.fetch_add(1, std::memory_order_relaxed);
         int X = static_cast<int>(std::floor(x)) & 255;
         int Y = static_cast<int>(std::floor(y)) & 255;
         int Z = static_cast<int>(std::floor(z)) & 255;
@@ -308,7 +353,171 @@ public:
                 lerp(u, grad(p[AB + 1], x, y - 1, z - 1),
                     grad(p[BB + 1], x - 1, y - 1, z - 1))));
     }
+    // Samples the noise on a sizeX*sizeY*sizeZ lattice: point (i, j, k) is
+    // ((x0 + i) * scale, (y0 + j) * scale, (z0 + k) * scale) and lands in
+    // out[(j * sizeX + i) * sizeZ + k]. Lattice cells are split off in double so
+    // only the fractional part is evaluated in float lanes.
+    void noiseBlock(double x0, double y0, double z0, double scale,
+                    int sizeX, int sizeY, int sizeZ, float* out) const;
+};
+
+// ---------------------- Batched Noise Lanes ----------------------
+// Float lane wrappers for PerlinNoise::noiseBlock. AVX2 evaluates 8 points per
+// step with hardware gathers, SSE2 evaluates 4 and gathers through memory.
+#if PRISMALS_NOISE_AVX2
+struct NoiseLanes {
+    typedef __m256 F;
+    typedef __m256i I;
+    static const int N = 8;
+    static F load(const float* v) { return _mm256_loadu_ps(v); }
+    static I loadi(const int* v) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v)); }
+    static void store(float* v, F a) { _mm256_storeu_ps(v, a); }
+    static F set(float v) { return _mm256_set1_ps(v); }
+    static I seti(int v) { return _mm256_set1_epi32(v); }
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F orf(F a, F b) { return _mm256_or_ps(a, b); }
+    static F select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+    static F flipSign(F a, I signBits) { return _mm256_xor_ps(a, _mm256_castsi256_ps(signBits)); }
+    static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+    static I ishl30(I a) { return _mm256_slli_epi32(a, 30); }
+    static I ishl31(I a) { return _mm256_slli_epi32(a, 31); }
+    static F ilt(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a)); }
+    static F ieq(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    static I gather(const int* table, I idx) { return _mm256_i32gather_epi32(table, idx, 4); }
+};
+#elif PRISMALS_NOISE_SSE2
+struct NoiseLanes {
+    typedef __m128 F;
+    typedef __m128i I;
+    static const int N = 4;
+    static F load(const float* v) { return _mm_loadu_ps(v); }
+    static I loadi(const int* v) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(v)); }
+    static void store(float* v, F a) { _mm_storeu_ps(v, a); }
+    static F set(float v) { return _mm_set1_ps(v); }
+    static I seti(int v) { return _mm_set1_epi32(v); }
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F orf(F a, F b) { return _mm_or_ps(a, b); }
+    static F select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static F flipSign(F a, I signBits) { return _mm_xor_ps(a, _mm_castsi128_ps(signBits)); }
+    static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+    static I iand(I a, I b) { return _mm_and_si128(a, b); }
+    static I ishl30(I a) { return _mm_slli_epi32(a, 30); }
+    static I ishl31(I a) { return _mm_slli_epi32(a, 31); }
+    static F ilt(I a, I b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a, b)); }
+    static F ieq(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static I gather(const int* table, I idx) {
+        alignas(16) int i[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(i), idx);
+        return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+    }
 };
+#endif
+
+#if PRISMALS_NOISE_AVX2 || PRISMALS_NOISE_SSE2
+static inline NoiseLanes::F fadeLanes(NoiseLanes::F t) {
+    typedef NoiseLanes L;
+    L::F inner = L::add(L::mul(t, L::sub(L::mul(t, L::set(6.0f)), L::set(15.0f))), L::set(10.0f));
+    return L::mul(L::mul(L::mul(t, t), t), inner);
+}
+
+static inline NoiseLanes::F lerpLanes(NoiseLanes::F t, NoiseLanes::F a, NoiseLanes::F b) {
+    typedef NoiseLanes L;
+    return L::add(a, L::mul(t, L::sub(b, a)));
+}
+
+// Same gradient selection as PerlinNoise::grad, done with lane masks.
+static inline NoiseLanes::F gradLanes(NoiseLanes::I hash, NoiseLanes::F x, NoiseLanes::F y, NoiseLanes::F z) {
+    typedef NoiseLanes L;
+    L::I h = L::iand(hash, L::seti(15));
+    L::F u = L::select(L::ilt(h, L::seti(8)), x, y);
+    L::F xz = L::select(L::orf(L::ieq(h, L::seti(12)), L::ieq(h, L::seti(14))), x, z);
+    L::F v = L::select(L::ilt(h, L::seti(4)), y, xz);
+    u = L::flipSign(u, L::ishl31(L::iand(h, L::seti(1))));
+    v = L::flipSign(v, L::ishl30(L::iand(h, L::seti(2))));
+    return L::add(u, v);
+}
+
+// One row of NoiseLanes::N points sharing the lattice cell (X, Y) and offsets
+// (x, y); only z varies per lane, so the first two hash levels stay scalar.
+// cz holds cells already wrapped to 0..255 and fz the offsets inside them.
+static inline void noiseRow(const int* p, int X, int Y, float x, float y,
+                            const int* cz, const float* fz, float* out) {
+    typedef NoiseLanes L;
+    int A = p[X] + Y, B = p[X + 1] + Y;
+    L::I Z = L::loadi(cz), ione = L::seti(1);
+    L::I AA = L::iadd(L::seti(p[A]), Z), AB = L::iadd(L::seti(p[A + 1]), Z);
+    L::I BA = L::iadd(L::seti(p[B]), Z), BB = L::iadd(L::seti(p[B + 1]), Z);
+    L::F z = L::load(fz), z1 = L::sub(z, L::set(1.0f));
+    L::F x0 = L::set(x), x1 = L::set(x - 1.0f), y0 = L::set(y), y1 = L::set(y - 1.0f);
+    L::F u = fadeLanes(x0), v = fadeLanes(y0), w = fadeLanes(z);
+    L::F near = lerpLanes(v,
+        lerpLanes(u, gradLanes(L::gather(p, AA), x0, y0, z),
+                     gradLanes(L::gather(p, BA), x1, y0, z)),
+        lerpLanes(u, gradLanes(L::gather(p, AB), x0, y1, z),
+                     gradLanes(L::gather(p, BB), x1, y1, z)));
+    L::F far = lerpLanes(v,
+        lerpLanes(u, gradLanes(L::gather(p, L::iadd(AA, ione)), x0, y0, z1),
+                     gradLanes(L::gather(p, L::iadd(BA, ione)), x1, y0, z1)),
+        lerpLanes(u, gradLanes(L::gather(p, L::iadd(AB, ione)), x0, y1, z1),
+                     gradLanes(L::gather(p, L::iadd(BB, ione)), x1, y1, z1)));
+    L::store(out, lerpLanes(w, near, far));
+}
+#endif
+
+void PerlinNoise::noiseBlock(double x0, double y0, double z0, double scale,
+                             int sizeX, int sizeY, int sizeZ, float* out) const {
+    noiseEvaluations.fetch_add(static_cast<uint64_t>(sizeX) * sizeY * sizeZ, std::memory_order_relaxed);
+#if PRISMALS_NOISE_AVX2 || PRISMALS_NOISE_SSE2
+    const int N = NoiseLanes::N;
+    const int paddedZ = (sizeZ + N - 1) / N * N;
+    // Per-axis cell/fraction tables; the z table is padded to whole lane steps.
+    thread_local std::vector<int> cell;
+    thread_local std::vector<float> frac;
+    cell.assign(sizeX + sizeY + paddedZ, 0);
+    frac.assign(sizeX + sizeY + paddedZ, 0.0f);
+    auto fillAxis = [&](int first, double origin, int size) {
+        for (int i = 0; i < size; i++) {
+            double c = (origin + i) * scale;
+            double f = std::floor(c);
+            cell[first + i] = static_cast<int>(f) & 255;
+            frac[first + i] = static_cast<float>(c - f);
+        }
+    };
+    fillAxis(0, x0, sizeX);
+    fillAxis(sizeX, y0, sizeY);
+    fillAxis(sizeX + sizeY, z0, sizeZ);
+    const int* cellY = cell.data() + sizeX;
+    const int* cellZ = cellY + sizeY;
+    const float* fracY = frac.data() + sizeX;
+    const float* fracZ = fracY + sizeY;
+
+    alignas(32) float tail[N];
+    for (int j = 0; j < sizeY; j++) {
+        for (int i = 0; i < sizeX; i++) {
+            float* row = out + (j * sizeX + i) * sizeZ;
+            for (int k = 0; k < paddedZ; k += N) {
+                if (k + N <= sizeZ) {
+                    noiseRow(p.data(), cell[i], cellY[j], frac[i], fracY[j], cellZ + k, fracZ + k, row + k);
+                }
+                else {
+                    noiseRow(p.data(), cell[i], cellY[j], frac[i], fracY[j], cellZ + k, fracZ + k, tail);
+                    std::copy(tail, tail + (sizeZ - k), row + k);
+                }
+            }
+        }
+    }
+#else
+    for (int j = 0; j < sizeY; j++)
+        for (int i = 0; i < sizeX; i++)
+            for (int k = 0; k < sizeZ; k++)
+                *out++ = static_cast<float>(noise((x0 + i) * scale, (y0 + j) * scale, (z0 + k) * scale));
+#endif
+}
 
 PerlinNoise continentalNoise(1);
 PerlinNoise elevationNoise(2);
@@ -349,21 +558,42 @@ GLuint compileShaderProgram(const char* vShaderSrc, const char* fShaderSrc) {
     return program;
 }
 
+// Uniform locations of the block and terrain programs, looked up once after
+// linking. Names a program doesn't declare come back as -1, which GL ignores.
+struct SceneUniforms {
+    GLint model, view, projection, cameraPos, time;
+    GLint lightDir, ambientLight, diffuseLight, blockColors, chunkOrigin;
+};
+
+SceneUniforms locateSceneUniforms(GLuint program) {
+    SceneUniforms u;
+    u.model = glGetUniformLocation(program, "model");
+    u.view = glGetUniformLocation(program, "view");
+    u.projection = glGetUniformLocation(program, "projection");
+    u.cameraPos = glGetUniformLocation(program, "cameraPos");
+    u.time = glGetUniformLocation(program, "time");
+    u.lightDir = glGetUniformLocation(program, "lightDir");
+    u.ambientLight = glGetUniformLocation(program, "ambientLight");
+    u.diffuseLight = glGetUniformLocation(program, "diffuseLight");
+    u.blockColors = glGetUniformLocation(program, "blockColors");
+    u.chunkOrigin = glGetUniformLocation(program, "chunkOrigin");
+    return u;
+}
+
 // ---------------------- Terrain Generation ----------------------
 struct TerrainPoint { double height; bool isLand; };
 
-TerrainPoint getTerrainHeight(double x, double z) {
-    const double CONTINENTAL_SCALE = 100.0;
-    const double ELEVATION_SCALE = 50.0;
-    const double RIDGE_SCALE = 25.0;
-    double continental = continentalNoise.noise(x / CONTINENTAL_SCALE, 0, z / CONTINENTAL_SCALE);
+const double CONTINENTAL_SCALE = 100.0;
+const double ELEVATION_SCALE = 50.0;
+const double RIDGE_SCALE = 25.0;
+
+// Applies the biome rules to already-sampled noise values for column (x, z).
+TerrainPoint shapeTerrain(double x, double z, double continental, double elevation, double ridge) {
     continental = (continental + 1.0) / 2.0;
     bool isLand = continental > 0.48;
     if (!isLand)
         return { -4.0, false };
-    double elevation = elevationNoise.noise(x / ELEVATION_SCALE, 0, z / ELEVATION_SCALE);
     elevation = (elevation + 1.0) / 2.0;
-    double ridge = ridgeNoise.noise(x / RIDGE_SCALE, 0, z / RIDGE_SCALE);
     double height = elevation * 8.0 + ridge * 12.0;
     int chunkX = static_cast<int>(std::floor(x / (double)CHUNK_SIZE));
     int chunkZ = static_cast<int>(std::floor(z / (double)CHUNK_SIZE));
@@ -376,6 +606,36 @@ TerrainPoint getTerrainHeight(double x, double z) {
     return { height, true };
 }
 
+TerrainPoint getTerrainHeight(double x, double z) {
+    double continental = continentalNoise.noise(x / CONTINENTAL_SCALE, 0, z / CONTINENTAL_SCALE);
+    if ((continental + 1.0) / 2.0 <= 0.48)
+        return { -4.0, false };
+    double elevation = elevationNoise.noise(x / ELEVATION_SCALE, 0, z / ELEVATION_SCALE);
+    double ridge = ridgeNoise.noise(x / RIDGE_SCALE, 0, z / RIDGE_SCALE);
+    return shapeTerrain(x, z, continental, elevation, ridge);
+}
+
+// Batched getTerrainHeight for a size*size block of integer columns starting at
+// (x0, z0) and `step` columns apart; out[i * size + k] is column
+// (x0 + i * step, z0 + k * step). x0 and z0 must be multiples of step.
+void getTerrainHeightGrid(int x0, int z0, int size, TerrainPoint* out, int step = 1) {
+    const int count = size * size;
+    std::vector<float> continental(count), elevation(count), ridge(count);
+    continentalNoise.noiseBlock(x0 / step, 0, z0 / step, step / CONTINENTAL_SCALE, size, 1, size, continental.data());
+    // Open ocean needs no elevation/ridge, same as the scalar early-out.
+    if (std::none_of(continental.begin(), continental.end(), [](float c) { return (c + 1.0f) / 2.0f > 0.48f; })) {
+        std::fill(out, out + count, TerrainPoint{ -4.0, false });
+        return;
+    }
+    elevationNoise.noiseBlock(x0 / step, 0, z0 / step, step / ELEVATION_SCALE, size, 1, size, elevation.data());
+    ridgeNoise.noiseBlock(x0 / step, 0, z0 / step, step / RIDGE_SCALE, size, 1, size, ridge.data());
+    for (int i = 0; i < size; i++)
+        for (int k = 0; k < size; k++) {
+            int idx = i * size + k;
+            out[idx] = shapeTerrain(x0 + i * step, z0 + k * step, continental[idx], elevation[idx], ridge[idx]);
+        }
+}
+
 int getChunkTopBlock(int cx, int cz) {
     double samples[5][2];
     samples[0][0] = cx * CHUNK_SIZE + CHUNK_SIZE / 2.0;
@@ -403,38 +663,828 @@ int getChunkTopBlock(int cx, int cz) {
     return 0;
 }
 
+// ---------------------- Terrain Cache ----------------------
+// Least-recently-used map. find() refreshes an entry; put() evicts the oldest
+// entry once the capacity is reached. Not thread-safe on its own.
+template <typename K, typename V>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+    const V* find(const K& key) {
+        auto it = index.find(key);
+        if (it == index.end())
+            return nullptr;
+        order.splice(order.begin(), order, it->second);
+        return &it->second->second;
+    }
+    void put(const K& key, const V& value) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = value;
+            order.splice(order.begin(), order, it->second);
+            return;
+        }
+        if (order.size() >= capacity) {
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+        order.emplace_front(key, value);
+        index[key] = order.begin();
+    }
+    size_t size() const { return order.size(); }
+    void clear() {
+        index.clear();
+        order.clear();
+    }
+private:
+    size_t capacity;
+    std::list<std::pair<K, V>> order;
+    std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> index;
+};
+
+// Column heights of one chunk as getTerrainHeight reports them.
+struct ChunkHeightmap {
+    double height[CHUNK_SIZE * CHUNK_SIZE];
+    uint64_t landMask[CHUNK_SIZE * CHUNK_SIZE / 64];
+    void set(int x, int z, const TerrainPoint& tp) {
+        int i = x * CHUNK_SIZE + z;
+        height[i] = tp.height;
+        if (tp.isLand) landMask[i >> 6] |= uint64_t(1) << (i & 63);
+        else landMask[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+    TerrainPoint get(int x, int z) const {
+        int i = x * CHUNK_SIZE + z;
+        return { height[i], ((landMask[i >> 6] >> (i & 63)) & 1) != 0 };
+    }
+};
+
+// Heightmaps outlive chunk unloads (about 2 KB each, capacity covers the
+// loaded area twice over); the per-chunk map colour is one byte and sized for
+// the full 400x400 chunk world map.
+const size_t HEIGHTMAP_CACHE_CHUNKS = 2048;
+const size_t TOP_BLOCK_CACHE_CHUNKS = 1 << 18;
+std::mutex terrainCacheMutex;
+LruCache<ChunkPos, ChunkHeightmap> heightmapCache(HEIGHTMAP_CACHE_CHUNKS);
+LruCache<ChunkPos, uint8_t> topBlockCache(TOP_BLOCK_CACHE_CHUNKS);
+size_t terrainCacheHits = 0, terrainCacheMisses = 0;
+
+void storeChunkHeightmap(int chunkX, int chunkZ, const ChunkHeightmap& heightmap) {
+    std::lock_guard<std::mutex> lock(terrainCacheMutex);
+    heightmapCache.put(ChunkPos(chunkX, chunkZ), heightmap);
+}
+
+// Heightmap of a whole chunk, from the cache or, on a miss, sampled once in a
+// batch and cached.
+ChunkHeightmap getChunkHeightmap(int chunkX, int chunkZ) {
+    {
+        std::lock_guard<std::mutex> lock(terrainCacheMutex);
+        if (const ChunkHeightmap* cached = heightmapCache.find(ChunkPos(chunkX, chunkZ))) {
+            terrainCacheHits++;
+            return *cached;
+        }
+        terrainCacheMisses++;
+    }
+    TerrainPoint grid[CHUNK_SIZE * CHUNK_SIZE];
+    getTerrainHeightGrid(chunkX * CHUNK_SIZE, chunkZ * CHUNK_SIZE, CHUNK_SIZE, grid);
+    ChunkHeightmap heightmap;
+    for (int i = 0; i < CHUNK_SIZE; i++)
+        for (int k = 0; k < CHUNK_SIZE; k++)
+            heightmap.set(i, k, grid[i * CHUNK_SIZE + k]);
+    storeChunkHeightmap(chunkX, chunkZ, heightmap);
+    return heightmap;
+}
+
+// Terrain for the block column at integer (x, z), served from the chunk's
+// cached heightmap.
+TerrainPoint getTerrainColumn(int x, int z) {
+    int chunkX = static_cast<int>(std::floor(x / (double)CHUNK_SIZE));
+    int chunkZ = static_cast<int>(std::floor(z / (double)CHUNK_SIZE));
+    int localX = x - chunkX * CHUNK_SIZE, localZ = z - chunkZ * CHUNK_SIZE;
+    {
+        std::lock_guard<std::mutex> lock(terrainCacheMutex);
+        if (const ChunkHeightmap* cached = heightmapCache.find(ChunkPos(chunkX, chunkZ))) {
+            terrainCacheHits++;
+            return cached->get(localX, localZ);
+        }
+    }
+    return getChunkHeightmap(chunkX, chunkZ).get(localX, localZ);
+}
+
+// Terrain under a world position; blocks are centred on integer coordinates,
+// so this is the column the position falls in.
+TerrainPoint getTerrainAt(double x, double z) {
+    return getTerrainColumn(static_cast<int>(std::floor(x + 0.5)), static_cast<int>(std::floor(z + 0.5)));
+}
+
+int getCachedChunkTopBlock(int cx, int cz) {
+    {
+        std::lock_guard<std::mutex> lock(terrainCacheMutex);
+        if (const uint8_t* cached = topBlockCache.find(ChunkPos(cx, cz)))
+            return *cached;
+    }
+    int topBlock = getChunkTopBlock(cx, cz);
+    std::lock_guard<std::mutex> lock(terrainCacheMutex);
+    topBlockCache.put(ChunkPos(cx, cz), static_cast<uint8_t>(topBlock));
+    return topBlock;
+}
+
+// ---------------------- Benchmark Recording ----------------------
+// Samples collected while --bench runs (see "Benchmark Mode"). Chunk samples
+// arrive from the worker threads.
+struct BenchRecorder {
+    std::mutex mutex;
+    std::vector<float> generateMs, meshMs, instanceBuildMs; // per chunk
+    std::vector<float> frameMs, instances, quads, drawCalls; // per frame
+    std::vector<int> frameSegment;
+    size_t peakBlockBytes = 0, peakRenderBytes = 0;
+};
+bool benchmarkMode = false;
+BenchRecorder benchRecorder;
+
+void recordBenchSample(std::vector<float>& samples, std::chrono::steady_clock::time_point start) {
+    if (!benchmarkMode)
+        return;
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(benchRecorder.mutex);
+    samples.push_back(ms);
+}
+
+// ---------------------- Block Storage ----------------------
+// Block ids double as the shaders' per-instance block type index into blockColors[].
+enum BlockType : uint8_t {
+    BLOCK_GRASS = 0,
+    BLOCK_WATER = 1,
+    BLOCK_TREE_TRUNK = 2,
+    BLOCK_PINE_LEAF = 3,
+    BLOCK_WATER_LILY = 5,
+    BLOCK_FALLEN_TRUNK = 6,
+    BLOCK_FIR_LEAF = 7,
+    BLOCK_OAK_TRUNK = 8,
+    BLOCK_OAK_LEAF = 9,
+    BLOCK_LEAF_PILE = 10,
+    BLOCK_BUSH_SMALL = 11,
+    BLOCK_BUSH_MEDIUM = 12,
+    BLOCK_BUSH_LARGE = 13,
+    BLOCK_DIRT = 15,
+    BLOCK_ANCIENT_TRUNK = 16,
+    BLOCK_ANCIENT_LEAF = 17,
+    BLOCK_ANCIENT_BRANCH = 18,
+    BLOCK_AURORA = 19,
+    BLOCK_DEEP_STONE = 20,
+    BLOCK_LAVA = 21,
+    BLOCK_SAND = 22,
+    BLOCK_SNOW = 23,
+    BLOCK_ICE = 24,
+    BLOCK_TYPE_COUNT = 25,
+    BLOCK_AIR = 255
+};
+
+// Blocks the player collides with.
+inline bool isSolidBlock(uint8_t type) {
+    switch (type) {
+    case BLOCK_GRASS: case BLOCK_SAND: case BLOCK_SNOW: case BLOCK_DIRT:
+    case BLOCK_TREE_TRUNK: case BLOCK_OAK_TRUNK: case BLOCK_ANCIENT_TRUNK:
+    case BLOCK_WATER_LILY: case BLOCK_DEEP_STONE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Blocks the crosshair raycast can hit.
+inline bool isSelectableBlock(uint8_t type) {
+    switch (type) {
+    case BLOCK_AIR: case BLOCK_AURORA: case BLOCK_ICE:
+    case BLOCK_ANCIENT_TRUNK: case BLOCK_ANCIENT_LEAF: case BLOCK_ANCIENT_BRANCH:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Lilies sit in the cell above the water surface but are drawn floating on it.
+inline glm::vec3 blockRenderOffset(uint8_t type) {
+    return type == BLOCK_WATER_LILY ? glm::vec3(0.0f, -0.8f, 0.0f) : glm::vec3(0.0f);
+}
+
+// Plain opaque cubes without per-instance vertex animation. These are merged
+// into the chunk's greedy mesh; everything else stays instanced.
+inline bool isMeshedBlock(uint8_t type) {
+    switch (type) {
+    case BLOCK_AIR: case BLOCK_WATER: case BLOCK_WATER_LILY: case BLOCK_AURORA:
+    case BLOCK_PINE_LEAF: case BLOCK_FIR_LEAF: case BLOCK_OAK_LEAF: case BLOCK_ANCIENT_LEAF:
+        return false;
+    default:
+        return true;
+    }
+}
+
+inline int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+const int SECTION_SIZE = 16;
+const int SECTION_VOLUME = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+const int CHUNK_MIN_Y = -128;
+const int CHUNK_MAX_Y = 512;
+const int SECTION_COUNT = (CHUNK_MAX_Y - CHUNK_MIN_Y) / SECTION_SIZE;
+
+// A 16x16x16 slice of a chunk. Cells hold indices into a small palette of block
+// types, bit-packed at 0, 1, 2, 4 or 8 bits per cell depending on the palette
+// size, so an all-air or all-stone section costs no index storage at all.
+struct ChunkSection {
+    std::vector<uint8_t> palette;
+    std::vector<uint64_t> data;
+    uint8_t bitsPerBlock;
+    uint16_t blockCount;
+    ChunkSection() : palette(1, BLOCK_AIR), bitsPerBlock(0), blockCount(0) {}
+    ChunkSection(std::vector<uint8_t> palette, std::vector<uint64_t> data, uint8_t bitsPerBlock, uint16_t blockCount)
+        : palette(std::move(palette)), data(std::move(data)), bitsPerBlock(bitsPerBlock), blockCount(blockCount) {}
+
+    static int index(int x, int y, int z) { return (y * SECTION_SIZE + z) * SECTION_SIZE + x; }
+
+    uint8_t get(int i) const {
+        if (bitsPerBlock == 0)
+            return palette[0];
+        int perWord = 64 / bitsPerBlock;
+        uint64_t mask = (1ull << bitsPerBlock) - 1;
+        return palette[(data[i / perWord] >> ((i % perWord) * bitsPerBlock)) & mask];
+    }
+
+    void set(int i, uint8_t type) {
+        uint8_t old = get(i);
+        if (old == type)
+            return;
+        int p = static_cast<int>(std::find(palette.begin(), palette.end(), type) - palette.begin());
+        if (p == static_cast<int>(palette.size())) {
+            palette.push_back(type);
+            if (palette.size() > (1u << bitsPerBlock))
+                resize(bitsPerBlock == 0 ? 1 : bitsPerBlock * 2);
+        }
+        int perWord = 64 / bitsPerBlock;
+        int shift = (i % perWord) * bitsPerBlock;
+        uint64_t mask = (1ull << bitsPerBlock) - 1;
+        data[i / perWord] = (data[i / perWord] & ~(mask << shift)) | (static_cast<uint64_t>(p) << shift);
+        if (old == BLOCK_AIR) blockCount++;
+        else if (type == BLOCK_AIR) blockCount--;
+    }
+
+    void resize(uint8_t bits) {
+        std::vector<uint64_t> packed(SECTION_VOLUME / (64 / bits), 0);
+        int perWord = 64 / bits;
+        for (int i = 0; i < SECTION_VOLUME; i++) {
+            uint64_t p = 0;
+            if (bitsPerBlock != 0) {
+                int oldPerWord = 64 / bitsPerBlock;
+                p = (data[i / oldPerWord] >> ((i % oldPerWord) * bitsPerBlock)) & ((1ull << bitsPerBlock) - 1);
+            }
+            packed[i / perWord] |= p << ((i % perWord) * bits);
+        }
+        data.swap(packed);
+        bitsPerBlock = bits;
+    }
+
+    size_t memoryUsage() const {
+        return sizeof(ChunkSection) + palette.capacity() + data.capacity() * sizeof(uint64_t);
+    }
+};
+
+// Packs a world-space block coordinate into 56 bits (20 per horizontal axis, 16 vertical),
+// leaving the low byte of an overflow entry for the block type.
+inline uint64_t packBlockKey(int x, int y, int z) {
+    return (static_cast<uint64_t>(x & 0xFFFFF) << 36) | (static_cast<uint64_t>(z & 0xFFFFF) << 16) | static_cast<uint64_t>(y & 0xFFFF);
+}
+
+inline glm::ivec3 unpackBlockKey(uint64_t key) {
+    auto signExtend = [](uint64_t v, int bits) { return static_cast<int>(static_cast<int64_t>(v << (64 - bits)) >> (64 - bits)); };
+    return glm::ivec3(signExtend((key >> 36) & 0xFFFFF, 20), signExtend(key & 0xFFFF, 16), signExtend((key >> 16) & 0xFFFFF, 20));
+}
+
+// Instanced blocks are split into draws by how they blend: opaque blocks,
+// pine canopies (drawn only south of chunk row 40) and the translucent water
+// and aurora, which go last.
+enum InstanceRunKind { RUN_OPAQUE, RUN_PINE, RUN_TRANSLUCENT, INSTANCE_RUN_COUNT };
+
+inline int instanceRunOf(uint8_t type) {
+    if (type == BLOCK_WATER || type == BLOCK_AURORA)
+        return RUN_TRANSLUCENT;
+    return type == BLOCK_PINE_LEAF ? RUN_PINE : RUN_OPAQUE;
+}
+
+inline bool instanceRunDrawn(int run, int playerChunkZ) {
+    return run != RUN_PINE || playerChunkZ < 40;
+}
+
+// Offsets into the chunk's instance buffer: the run's blocks in section s and
+// above, spill-over included, are [sectionStart[s], end).
+struct InstanceRun {
+    GLint sectionStart[SECTION_COUNT];
+    GLint end;
+};
+
+// Face pairs of a section, bit (a * 6 + b), faces in the greedy mesher's
+// order (+x -x +y -y +z -z).
+const uint64_t ALL_FACES_CONNECTED = (1ull << 36) - 1;
+
+inline bool facesConnected(uint64_t connectivity, int a, int b) {
+    return ((connectivity >> (a * 6 + b)) & 1) != 0;
+}
+
 // ---------------------- Chunk Structure ----------------------
 struct Chunk {
-    std::vector<glm::vec3> waterPositions;
-    std::vector<glm::vec3> grassPositions;
-    std::vector<glm::vec3> sandPositions;
-    std::vector<glm::vec3> snowPositions;
-    std::vector<glm::vec3> dirtPositions;
-    std::vector<glm::vec3> deepStonePositions;
-    std::vector<glm::vec3> lavaPositions;
-    std::vector<glm::vec3> treeTrunkPositions;
-    std::vector<glm::vec3> treeLeafPositions;
-    std::vector<glm::vec3> firLeafPositions;
-    std::vector<glm::vec3> waterLilyPositions;
-    std::vector<glm::vec3> fallenTreeTrunkPositions;
-    std::vector<glm::vec3> oakTrunkPositions;
-    std::vector<glm::vec3> oakLeafPositions;
-    std::vector<glm::vec3> leafPilePositions;
-    std::vector<glm::vec3> bushSmallPositions;
-    std::vector<glm::vec3> bushMediumPositions;
-    std::vector<glm::vec3> bushLargePositions;
+    int chunkX, chunkZ;
+    // Dense block storage for this chunk's 16x16 columns, bottom section first.
+    // Only grown as far up as something has been placed.
+    std::vector<ChunkSection> sections;
+    // Blocks this chunk generated outside its own columns or height range
+    // (tree canopies and fallen trunks reaching into neighbours), kept sorted
+    // as (packBlockKey << 8 | type) so lookups are a binary search.
+    std::vector<uint64_t> overflow;
+    // Rotated ground branches are decorations, not grid blocks.
     std::vector<glm::vec4> branchPositions;
-    std::vector<glm::vec3> ancientTrunkPositions;
-    std::vector<glm::vec3> ancientLeafPositions;
-    std::vector<glm::vec3> ancientBranchPositions;
-    std::vector<glm::vec3> auroraPositions;
-    std::vector<glm::vec3> icePositions;
+    // Instances as (offset, block type), derived from the block storage when
+    // meshing and released again once uploaded to instanceBuffer. They form
+    // one run per InstanceRunKind, each section-major with the spill-over
+    // blocks last, so any "section s and up" slice of a run is one draw.
+    std::vector<glm::vec4> instanceData;
+    InstanceRun instanceRuns[INSTANCE_RUN_COUNT];
+    // Greedy mesh of the chunk's opaque cubes, one packed vertex per quad
+    // corner (see packTerrainVertex); released once uploaded to meshBuffer.
+    // Section s owns quads [sectionQuadStart[s], sectionQuadStart[s + 1]).
+    std::vector<uint32_t> meshData;
+    GLsizei meshQuadCount;
+    GLint sectionQuadStart[SECTION_COUNT + 1];
+    // Per section, which faces see each other through non-opaque cells (see
+    // computeSectionConnectivity), and the sections the last visibility walk reached.
+    uint64_t sectionConnectivity[SECTION_COUNT];
+    uint64_t visibleSections;
+    // Persistent GPU copies, rewritten only when the chunk is remeshed.
+    GLuint instanceBuffer;
+    GLuint branchBuffer;
+    GLuint meshBuffer;
+    bool generated;
     bool needsMeshUpdate;
-    Chunk() : needsMeshUpdate(true) {}
+    bool needsUpload;
+    bool needsSave; // blocks differ from the copy in the region file (or there is none)
+    Chunk() : chunkX(0), chunkZ(0), meshQuadCount(0), visibleSections(0), instanceBuffer(0), branchBuffer(0), meshBuffer(0),
+              generated(false), needsMeshUpdate(true), needsUpload(false), needsSave(false) {
+        for (int r = 0; r < INSTANCE_RUN_COUNT; r++) {
+            std::fill(instanceRuns[r].sectionStart, instanceRuns[r].sectionStart + SECTION_COUNT, 0);
+            instanceRuns[r].end = 0;
+        }
+        std::fill(sectionQuadStart, sectionQuadStart + SECTION_COUNT + 1, 0);
+        std::fill(sectionConnectivity, sectionConnectivity + SECTION_COUNT, ALL_FACES_CONNECTED);
+    }
+
+    uint8_t getLocal(int x, int y, int z) const {
+        int s = floorDiv(y - CHUNK_MIN_Y, SECTION_SIZE);
+        if (s < 0 || s >= static_cast<int>(sections.size()))
+            return BLOCK_AIR;
+        return sections[s].get(ChunkSection::index(x, (y - CHUNK_MIN_Y) % SECTION_SIZE, z));
+    }
+
+    void setLocal(int x, int y, int z, uint8_t type) {
+        int s = (y - CHUNK_MIN_Y) / SECTION_SIZE;
+        if (s >= static_cast<int>(sections.size()))
+            sections.resize(s + 1);
+        sections[s].set(ChunkSection::index(x, (y - CHUNK_MIN_Y) % SECTION_SIZE, z), type);
+    }
+
+    void setWorld(int x, int y, int z, uint8_t type) {
+        int lx = x - chunkX * CHUNK_SIZE;
+        int lz = z - chunkZ * CHUNK_SIZE;
+        if (lx >= 0 && lx < CHUNK_SIZE && lz >= 0 && lz < CHUNK_SIZE && y >= CHUNK_MIN_Y && y < CHUNK_MAX_Y)
+            setLocal(lx, y, lz, type);
+        else
+            setOverflow(packBlockKey(x, y, z), type);
+    }
+
+    void setOverflow(uint64_t key, uint8_t type) {
+        auto it = std::lower_bound(overflow.begin(), overflow.end(), key << 8);
+        if (it != overflow.end() && (*it >> 8) == key)
+            *it = (key << 8) | type;
+        else
+            overflow.insert(it, (key << 8) | type);
+    }
+
+    uint8_t getOverflow(uint64_t key) const {
+        auto it = std::lower_bound(overflow.begin(), overflow.end(), key << 8);
+        return (it != overflow.end() && (*it >> 8) == key) ? static_cast<uint8_t>(*it & 0xFF) : static_cast<uint8_t>(BLOCK_AIR);
+    }
+
+    // Generation works in floating point; blocks snap to the cell containing the position.
+    void place(const glm::vec3& pos, uint8_t type) {
+        setWorld(static_cast<int>(std::floor(pos.x)), static_cast<int>(std::floor(pos.y)), static_cast<int>(std::floor(pos.z)), type);
+    }
+
+    uint8_t getWorld(int x, int y, int z) const {
+        int lx = x - chunkX * CHUNK_SIZE;
+        int lz = z - chunkZ * CHUNK_SIZE;
+        if (lx >= 0 && lx < CHUNK_SIZE && lz >= 0 && lz < CHUNK_SIZE && y >= CHUNK_MIN_Y && y < CHUNK_MAX_Y)
+            return getLocal(lx, y, lz);
+        return getOverflow(packBlockKey(x, y, z));
+    }
+
+    void clearBlocks() {
+        sections.clear();
+        overflow.clear();
+        branchPositions.clear();
+    }
+
+    size_t memoryUsage() const {
+        size_t bytes = sizeof(Chunk) + sections.capacity() * sizeof(ChunkSection);
+        for (const auto& s : sections)
+            bytes += s.memoryUsage() - sizeof(ChunkSection);
+        bytes += overflow.capacity() * sizeof(uint64_t);
+        bytes += branchPositions.capacity() * sizeof(glm::vec4);
+        return bytes;
+    }
+
+    size_t instanceMemoryUsage() const {
+        return instanceData.capacity() * sizeof(glm::vec4) + meshData.capacity() * sizeof(uint32_t);
+    }
+
+    size_t gpuMemoryUsage() const {
+        size_t count = instanceRuns[INSTANCE_RUN_COUNT - 1].end;
+        return count * sizeof(glm::vec4) + branchPositions.size() * sizeof(glm::vec4) + meshQuadCount * 4 * sizeof(uint32_t);
+    }
 };
 
 std::unordered_map<ChunkPos, Chunk> chunks;
 
+// Block lookup by world coordinate. Checks the owning chunk's dense storage
+// first and falls back to blocks neighbouring chunks spilled over the border.
+uint8_t getBlockAt(int x, int y, int z) {
+    int cx = floorDiv(x, CHUNK_SIZE);
+    int cz = floorDiv(z, CHUNK_SIZE);
+    auto it = chunks.find(ChunkPos(cx, cz));
+    if (it != chunks.end()) {
+        uint8_t type = it->second.getLocal(x - cx * CHUNK_SIZE, y, z - cz * CHUNK_SIZE);
+        if (type != BLOCK_AIR)
+            return type;
+    }
+    uint64_t key = packBlockKey(x, y, z);
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dz = -1; dz <= 1; dz++) {
+            auto n = chunks.find(ChunkPos(cx + dx, cz + dz));
+            if (n == chunks.end() || n->second.overflow.empty())
+                continue;
+            uint8_t type = n->second.getOverflow(key);
+            if (type != BLOCK_AIR)
+                return type;
+        }
+    }
+    return BLOCK_AIR;
+}
+
+// Packs a terrain mesh vertex into 28 bits: quad corner within the chunk
+// (x and z 0..16, y 0..640 above CHUNK_MIN_Y), face direction (+x -x +y -y +z -z)
+// and block type. The terrain vertex shader unpacks it.
+inline uint32_t packTerrainVertex(int x, int y, int z, int face, int type) {
+    return static_cast<uint32_t>(x) | (static_cast<uint32_t>(z) << 5) | (static_cast<uint32_t>(y) << 10) |
+           (static_cast<uint32_t>(face) << 20) | (static_cast<uint32_t>(type) << 23);
+}
+
+// Greedy-meshes the chunk's opaque cubes section by section. Faces between two
+// opaque cubes are dropped, and coplanar faces of the same type are merged into
+// one quad. Cubes outside the chunk's columns count as empty, so border faces are kept.
+void buildGreedyMesh(const Chunk& chunk, std::vector<uint32_t>& out, GLint* sectionQuadStart) {
+    const int P = SECTION_SIZE + 2;
+    static thread_local uint8_t cells[P * P * P];
+    uint8_t mask[SECTION_SIZE * SECTION_SIZE];
+    auto cell = [&](int x, int y, int z) -> uint8_t& { return cells[((y + 1) * P + (z + 1)) * P + (x + 1)]; };
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        sectionQuadStart[s] = static_cast<GLint>(out.size() / 4);
+        if (s >= static_cast<int>(chunk.sections.size()) || chunk.sections[s].blockCount == 0)
+            continue;
+        // Decode the section plus a one-block apron.
+        int baseY = CHUNK_MIN_Y + s * SECTION_SIZE;
+        for (int y = -1; y <= SECTION_SIZE; y++)
+            for (int z = -1; z <= SECTION_SIZE; z++)
+                for (int x = -1; x <= SECTION_SIZE; x++) {
+                    bool inside = x >= 0 && x < SECTION_SIZE && z >= 0 && z < SECTION_SIZE;
+                    cell(x, y, z) = inside ? chunk.getLocal(x, baseY + y, z) : static_cast<uint8_t>(BLOCK_AIR);
+                }
+        for (int face = 0; face < 6; face++) {
+            int d = face / 2;                  // axis the face looks along
+            int dir = (face % 2 == 0) ? 1 : -1;
+            int u = (d + 1) % 3, v = (d + 2) % 3;
+            for (int i = 0; i < SECTION_SIZE; i++) {
+                for (int b = 0; b < SECTION_SIZE; b++) {
+                    for (int a = 0; a < SECTION_SIZE; a++) {
+                        int p[3];
+                        p[d] = i; p[u] = a; p[v] = b;
+                        uint8_t type = cell(p[0], p[1], p[2]);
+                        p[d] += dir;
+                        uint8_t neighbour = cell(p[0], p[1], p[2]);
+                        mask[b * SECTION_SIZE + a] = (isMeshedBlock(type) && !isMeshedBlock(neighbour)) ? type : static_cast<uint8_t>(BLOCK_AIR);
+                    }
+                }
+                int plane = i + (dir > 0 ? 1 : 0);
+                for (int b = 0; b < SECTION_SIZE; b++) {
+                    for (int a = 0; a < SECTION_SIZE;) {
+                        uint8_t type = mask[b * SECTION_SIZE + a];
+                        if (type == BLOCK_AIR) {
+                            a++;
+                            continue;
+                        }
+                        int w = 1;
+                        while (a + w < SECTION_SIZE && mask[b * SECTION_SIZE + a + w] == type)
+                            w++;
+                        int h = 1;
+                        for (; b + h < SECTION_SIZE; h++) {
+                            bool rowMatches = true;
+                            for (int k = 0; k < w && rowMatches; k++)
+                                rowMatches = mask[(b + h) * SECTION_SIZE + a + k] == type;
+                            if (!rowMatches)
+                                break;
+                        }
+                        for (int hh = 0; hh < h; hh++)
+                            for (int k = 0; k < w; k++)
+                                mask[(b + hh) * SECTION_SIZE + a + k] = BLOCK_AIR;
+                        int corners[4][2] = { { a, b }, { a + w, b }, { a + w, b + h }, { a, b + h } };
+                        for (int c = 0; c < 4; c++) {
+                            // Wind counter-clockwise as seen from the side the face points to.
+                            const int* uv = corners[dir > 0 ? c : 3 - c];
+                            int q[3];
+                            q[d] = plane; q[u] = uv[0]; q[v] = uv[1];
+                            out.push_back(packTerrainVertex(q[0], q[1] + s * SECTION_SIZE, q[2], face, type));
+                        }
+                        a += w;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Which faces of the section see each other through cells that are not opaque
+// cubes (the cave-culling flood fill): each open pocket is filled once and
+// every pair of faces it touches is connected. Bit layout as in facesConnected.
+uint64_t computeSectionConnectivity(const ChunkSection& section) {
+    if (section.blockCount == 0)
+        return ALL_FACES_CONNECTED;
+    static thread_local uint64_t open[SECTION_VOLUME / 64];
+    static thread_local uint16_t stack[SECTION_VOLUME];
+    int openCount = 0;
+    for (int w = 0; w < SECTION_VOLUME / 64; w++)
+        open[w] = 0;
+    for (int i = 0; i < SECTION_VOLUME; i++) {
+        if (!isMeshedBlock(section.get(i))) {
+            open[i >> 6] |= uint64_t(1) << (i & 63);
+            openCount++;
+        }
+    }
+    if (openCount == SECTION_VOLUME)
+        return ALL_FACES_CONNECTED;
+    const int last = SECTION_SIZE - 1;
+    uint64_t connectivity = 0;
+    for (int start = 0; start < SECTION_VOLUME; start++) {
+        if (!((open[start >> 6] >> (start & 63)) & 1))
+            continue;
+        int top = 0;
+        stack[top++] = static_cast<uint16_t>(start);
+        open[start >> 6] &= ~(uint64_t(1) << (start & 63));
+        int faces = 0;
+        while (top > 0) {
+            int i = stack[--top];
+            int x = i & last, z = (i >> 4) & last, y = i >> 8;
+            auto visit = [&](int n) {
+                if ((open[n >> 6] >> (n & 63)) & 1) {
+                    open[n >> 6] &= ~(uint64_t(1) << (n & 63));
+                    stack[top++] = static_cast<uint16_t>(n);
+                }
+                };
+            if (x == last) faces |= 1 << 0; else visit(i + 1);
+            if (x == 0) faces |= 1 << 1; else visit(i - 1);
+            if (y == last) faces |= 1 << 2; else visit(i + SECTION_SIZE * SECTION_SIZE);
+            if (y == 0) faces |= 1 << 3; else visit(i - SECTION_SIZE * SECTION_SIZE);
+            if (z == last) faces |= 1 << 4; else visit(i + SECTION_SIZE);
+            if (z == 0) faces |= 1 << 5; else visit(i - SECTION_SIZE);
+        }
+        for (int a = 0; a < 6; a++)
+            if (faces & (1 << a))
+                for (int b = 0; b < 6; b++)
+                    if (faces & (1 << b))
+                        connectivity |= uint64_t(1) << (a * 6 + b);
+        if (connectivity == ALL_FACES_CONNECTED)
+            break;
+    }
+    return connectivity;
+}
+
+// Rebuilds the chunk's render data from its block storage: the greedy mesh for
+// opaque cubes, typed instance data for everything else, and the sections'
+// face connectivity for the visibility walk.
+void buildChunkMesh(Chunk& chunk) {
+    auto instanceStart = std::chrono::steady_clock::now();
+    static thread_local std::vector<glm::vec4> runs[INSTANCE_RUN_COUNT];
+    for (int r = 0; r < INSTANCE_RUN_COUNT; r++)
+        runs[r].clear();
+    int baseX = chunk.chunkX * CHUNK_SIZE;
+    int baseZ = chunk.chunkZ * CHUNK_SIZE;
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        for (int r = 0; r < INSTANCE_RUN_COUNT; r++)
+            chunk.instanceRuns[r].sectionStart[s] = static_cast<GLint>(runs[r].size());
+        if (s >= static_cast<int>(chunk.sections.size())) {
+            chunk.sectionConnectivity[s] = ALL_FACES_CONNECTED;
+            continue;
+        }
+        const ChunkSection& section = chunk.sections[s];
+        chunk.sectionConnectivity[s] = computeSectionConnectivity(section);
+        if (section.blockCount == 0)
+            continue;
+        int baseY = CHUNK_MIN_Y + s * SECTION_SIZE;
+        for (int i = 0; i < SECTION_VOLUME; i++) {
+            uint8_t type = section.get(i);
+            if (type == BLOCK_AIR || isMeshedBlock(type))
+                continue;
+            int x = i % SECTION_SIZE;
+            int z = (i / SECTION_SIZE) % SECTION_SIZE;
+            int y = i / (SECTION_SIZE * SECTION_SIZE);
+            glm::vec3 offset = glm::vec3(baseX + x, baseY + y, baseZ + z) + blockRenderOffset(type);
+            runs[instanceRunOf(type)].push_back(glm::vec4(offset, static_cast<float>(type)));
+        }
+    }
+    // Spill-over blocks sit outside the mesh grid and are always instanced;
+    // they close each run, so they are drawn whenever any section is.
+    for (uint64_t entry : chunk.overflow) {
+        uint8_t type = static_cast<uint8_t>(entry & 0xFF);
+        if (type == BLOCK_AIR)
+            continue;
+        glm::vec3 offset = glm::vec3(unpackBlockKey(entry >> 8)) + blockRenderOffset(type);
+        runs[instanceRunOf(type)].push_back(glm::vec4(offset, static_cast<float>(type)));
+    }
+    size_t instanceCount = 0;
+    for (int r = 0; r < INSTANCE_RUN_COUNT; r++)
+        instanceCount += runs[r].size();
+    std::vector<glm::vec4>().swap(chunk.instanceData);
+    chunk.instanceData.reserve(instanceCount);
+    for (int r = 0; r < INSTANCE_RUN_COUNT; r++) {
+        GLint base = static_cast<GLint>(chunk.instanceData.size());
+        for (int s = 0; s < SECTION_COUNT; s++)
+            chunk.instanceRuns[r].sectionStart[s] += base;
+        chunk.instanceData.insert(chunk.instanceData.end(), runs[r].begin(), runs[r].end());
+        chunk.instanceRuns[r].end = static_cast<GLint>(chunk.instanceData.size());
+    }
+    recordBenchSample(benchRecorder.instanceBuildMs, instanceStart);
+    auto meshStart = std::chrono::steady_clock::now();
+    static thread_local std::vector<uint32_t> mesh;
+    mesh.clear();
+    buildGreedyMesh(chunk, mesh, chunk.sectionQuadStart);
+    chunk.meshData = std::vector<uint32_t>(mesh.begin(), mesh.end());
+    chunk.meshQuadCount = static_cast<GLsizei>(chunk.meshData.size() / 4);
+    chunk.sectionQuadStart[SECTION_COUNT] = chunk.meshQuadCount;
+    recordBenchSample(benchRecorder.meshMs, meshStart);
+    chunk.needsMeshUpdate = false;
+    chunk.needsUpload = true;
+}
+
+// Shared element buffer for the terrain meshes: quad k is drawn as triangles
+// (4k, 4k+1, 4k+2) and (4k+2, 4k+3, 4k). Bound once into terrainVAO.
+GLuint terrainVAO = 0;
+GLuint quadIndexBuffer = 0;
+size_t quadIndexCapacity = 0;
+
+void ensureQuadIndexCapacity(size_t quads) {
+    if (quads <= quadIndexCapacity)
+        return;
+    size_t capacity = std::max(quads, quadIndexCapacity * 2);
+    std::vector<uint32_t> indices;
+    indices.reserve(capacity * 6);
+    for (size_t q = 0; q < capacity; q++) {
+        uint32_t base = static_cast<uint32_t>(q * 4);
+        uint32_t quad[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+    glBindVertexArray(terrainVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    quadIndexCapacity = capacity;
+}
+
+// Copies the chunk's render data into its own buffers and drops the CPU copies.
+void uploadChunkMesh(Chunk& chunk) {
+    if (chunk.instanceBuffer == 0)
+        glGenBuffers(1, &chunk.instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, chunk.instanceData.size() * sizeof(glm::vec4), chunk.instanceData.data(), GL_STATIC_DRAW);
+    if (!chunk.branchPositions.empty()) {
+        if (chunk.branchBuffer == 0)
+            glGenBuffers(1, &chunk.branchBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.branchBuffer);
+        glBufferData(GL_ARRAY_BUFFER, chunk.branchPositions.size() * sizeof(glm::vec4), chunk.branchPositions.data(), GL_STATIC_DRAW);
+    }
+    if (chunk.meshQuadCount > 0) {
+        if (chunk.meshBuffer == 0)
+            glGenBuffers(1, &chunk.meshBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.meshBuffer);
+        glBufferData(GL_ARRAY_BUFFER, chunk.meshData.size() * sizeof(uint32_t), chunk.meshData.data(), GL_STATIC_DRAW);
+        ensureQuadIndexCapacity(chunk.meshQuadCount);
+    }
+    std::vector<glm::vec4>().swap(chunk.instanceData);
+    std::vector<uint32_t>().swap(chunk.meshData);
+    chunk.needsUpload = false;
+}
+
+void releaseChunkBuffers(Chunk& chunk) {
+    if (chunk.instanceBuffer != 0)
+        glDeleteBuffers(1, &chunk.instanceBuffer);
+    if (chunk.branchBuffer != 0)
+        glDeleteBuffers(1, &chunk.branchBuffer);
+    if (chunk.meshBuffer != 0)
+        glDeleteBuffers(1, &chunk.meshBuffer);
+    chunk.instanceBuffer = 0;
+    chunk.branchBuffer = 0;
+    chunk.meshBuffer = 0;
+}
+
+// ---------------------- Cave Culling ----------------------
+static_assert(SECTION_COUNT <= 64, "visibleSections holds one bit per section");
+bool caveCullingEnabled = true;
+
+// Breadth-first walk over chunk sections from the one holding the eye, as in
+// the usual cave-culling search: a step leaves a section through face f only
+// if f connects to the face it came in by, never heads back against a
+// direction already taken, and stays within the frustum-visible chunks.
+// Sets visibleSections on every chunk in `visible`.
+void walkVisibleSections(const std::vector<Chunk*>& visible, const glm::vec3& eye) {
+    const uint64_t allSections = (1ull << SECTION_COUNT) - 1;
+    if (visible.empty())
+        return;
+    int minX = visible[0]->chunkX, maxX = minX, minZ = visible[0]->chunkZ, maxZ = minZ;
+    for (Chunk* chunk : visible) {
+        minX = std::min(minX, chunk->chunkX); maxX = std::max(maxX, chunk->chunkX);
+        minZ = std::min(minZ, chunk->chunkZ); maxZ = std::max(maxZ, chunk->chunkZ);
+    }
+    int width = maxX - minX + 1, depth = maxZ - minZ + 1;
+    static std::vector<Chunk*> grid;
+    grid.assign(static_cast<size_t>(width) * depth, nullptr);
+    for (Chunk* chunk : visible) {
+        chunk->visibleSections = caveCullingEnabled ? 0 : allSections;
+        grid[(chunk->chunkZ - minZ) * width + (chunk->chunkX - minX)] = chunk;
+    }
+    if (!caveCullingEnabled)
+        return;
+    auto chunkAt = [&](int cx, int cz) -> Chunk* {
+        if (cx < minX || cx > maxX || cz < minZ || cz > maxZ)
+            return nullptr;
+        return grid[(cz - minZ) * width + (cx - minX)];
+    };
+    int eyeX = static_cast<int>(std::floor(eye.x + 0.5f));
+    int eyeY = static_cast<int>(std::floor(eye.y + 0.5f));
+    int eyeZ = static_cast<int>(std::floor(eye.z + 0.5f));
+    int startX = floorDiv(eyeX, CHUNK_SIZE), startZ = floorDiv(eyeZ, CHUNK_SIZE);
+    int startS = floorDiv(eyeY - CHUNK_MIN_Y, SECTION_SIZE);
+    Chunk* start = chunkAt(startX, startZ);
+    if (start == nullptr || startS < 0 || startS >= SECTION_COUNT) {
+        // No section to start from (above the build limit, or the camera's
+        // chunk is still waiting for its mesh): draw everything.
+        for (Chunk* chunk : visible)
+            chunk->visibleSections = allSections;
+        return;
+    }
+    struct Step { Chunk* chunk; int cx, cz, s, entry, directions; };
+    static std::vector<Step> queue;
+    queue.clear();
+    start->visibleSections |= 1ull << startS;
+    queue.push_back({ start, startX, startZ, startS, -1, 0 });
+    for (size_t head = 0; head < queue.size(); head++) {
+        Step step = queue[head];
+        uint64_t connectivity = step.chunk->sectionConnectivity[step.s];
+        for (int f = 0; f < 6; f++) {
+            if (step.directions & (1 << (f ^ 1)))
+                continue;
+            if (step.entry >= 0 && !facesConnected(connectivity, step.entry, f))
+                continue;
+            int s = step.s + (f == 2) - (f == 3);
+            if (s < 0 || s >= SECTION_COUNT)
+                continue;
+            int cx = step.cx + (f == 0) - (f == 1);
+            int cz = step.cz + (f == 4) - (f == 5);
+            Chunk* next = (cx == step.cx && cz == step.cz) ? step.chunk : chunkAt(cx, cz);
+            if (next == nullptr || ((next->visibleSections >> s) & 1))
+                continue;
+            next->visibleSections |= 1ull << s;
+            queue.push_back({ next, cx, cz, s, f ^ 1, step.directions | (1 << f) });
+        }
+    }
+}
+
+// Instances of a run from the chunk's lowest visible section up (the runs are
+// section-major): their count, with the first one in `first`.
+GLsizei visibleRunRange(const Chunk& chunk, int run, GLint& first) {
+    first = 0;
+    if (chunk.visibleSections == 0)
+        return 0;
+    int lowest = 0;
+    while (!((chunk.visibleSections >> lowest) & 1))
+        lowest++;
+    first = chunk.instanceRuns[run].sectionStart[lowest];
+    return chunk.instanceRuns[run].end - first;
+}
+
 // ---------------------- Quadtree Structures ----------------------
 struct Plane { glm::vec3 normal; float d; };
 
@@ -484,11 +1534,199 @@ bool aabbInFrustum(const std::vector<Plane>& planes, const glm::vec3& min, const
     return true;
 }
 
+// ---------------------- Generation Scratch ----------------------
+// Bump allocator for the short-lived buffers of generating one chunk. Every
+// worker owns one and rewinds it once the chunk is packed, so after the first
+// few chunks generation takes no scratch memory from the heap at all. Blocks
+// are only added when a chunk needs more than any before it.
+class ScratchArena {
+public:
+    ScratchArena() : current(0), used(0) {}
+
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is released without destructors");
+        size_t bytes = count * sizeof(T);
+        size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        while (current < blocks.size() && offset + bytes > blocks[current].size) {
+            current++;
+            offset = 0;
+        }
+        if (current == blocks.size())
+            blocks.push_back(Block{ std::unique_ptr<unsigned char[]>(new unsigned char[std::max(bytes, BLOCK_BYTES)]), std::max(bytes, BLOCK_BYTES) });
+        used = offset + bytes;
+        return reinterpret_cast<T*>(blocks[current].memory.get() + offset);
+    }
+
+    void reset() {
+        current = 0;
+        used = 0;
+    }
+
+    size_t capacity() const {
+        size_t bytes = 0;
+        for (const Block& block : blocks)
+            bytes += block.size;
+        return bytes;
+    }
+
+private:
+    static constexpr size_t BLOCK_BYTES = 256 * 1024;
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t current, used;
+};
+
+// Growable array in a ScratchArena; outgrown storage is abandoned until the
+// arena is reset.
+template <typename T>
+struct ArenaList {
+    ScratchArena& arena;
+    T* items;
+    size_t count, capacity;
+    explicit ArenaList(ScratchArena& arena) : arena(arena), items(nullptr), count(0), capacity(0) {}
+
+    void push_back(const T& value) {
+        if (count == capacity) {
+            capacity = std::max<size_t>(capacity * 2, 64);
+            T* grown = arena.allocate<T>(capacity);
+            if (count)
+                std::memcpy(grown, items, count * sizeof(T));
+            items = grown;
+        }
+        items[count++] = value;
+    }
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+};
+
+// What generateChunkBlocks places into: the chunk's columns as one byte per
+// cell, section by section, plus the spill-over and ground branches in
+// placement order, all in the arena. finish() packs them into the chunk's
+// storage once, with every palette, word array and list exactly sized,
+// instead of growing sections and re-sorting the spill-over block by block.
+struct ChunkBuilder {
+    int chunkX, chunkZ;
+    uint8_t* cells;            // SECTION_COUNT * SECTION_VOLUME, ChunkSection::index order
+    uint64_t touchedSections;  // sections whose cells have been cleared to air
+    ArenaList<uint64_t> overflow; // (packBlockKey << 8 | type), later entries win
+    ArenaList<glm::vec4> branches;
+
+    ChunkBuilder(ScratchArena& arena, int chunkX, int chunkZ)
+        : chunkX(chunkX), chunkZ(chunkZ), cells(arena.allocate<uint8_t>(SECTION_COUNT * SECTION_VOLUME)),
+          touchedSections(0), overflow(arena), branches(arena) {}
+
+    uint8_t* cellAt(int lx, int y, int lz) {
+        int s = (y - CHUNK_MIN_Y) / SECTION_SIZE;
+        uint8_t* section = cells + s * SECTION_VOLUME;
+        if (!((touchedSections >> s) & 1)) {
+            std::memset(section, BLOCK_AIR, SECTION_VOLUME);
+            touchedSections |= uint64_t(1) << s;
+        }
+        return section + ChunkSection::index(lx, (y - CHUNK_MIN_Y) % SECTION_SIZE, lz);
+    }
+
+    // Same snapping and ownership rules as Chunk::place.
+    void place(const glm::vec3& pos, uint8_t type) {
+        int x = static_cast<int>(std::floor(pos.x));
+        int y = static_cast<int>(std::floor(pos.y));
+        int z = static_cast<int>(std::floor(pos.z));
+        int lx = x - chunkX * CHUNK_SIZE;
+        int lz = z - chunkZ * CHUNK_SIZE;
+        if (lx >= 0 && lx < CHUNK_SIZE && lz >= 0 && lz < CHUNK_SIZE && y >= CHUNK_MIN_Y && y < CHUNK_MAX_Y)
+            *cellAt(lx, y, lz) = type;
+        else
+            overflow.push_back((packBlockKey(x, y, z) << 8) | type);
+    }
+
+    uint8_t getWorld(int x, int y, int z) const {
+        int lx = x - chunkX * CHUNK_SIZE;
+        int lz = z - chunkZ * CHUNK_SIZE;
+        if (lx >= 0 && lx < CHUNK_SIZE && lz >= 0 && lz < CHUNK_SIZE && y >= CHUNK_MIN_Y && y < CHUNK_MAX_Y) {
+            int s = (y - CHUNK_MIN_Y) / SECTION_SIZE;
+            if (!((touchedSections >> s) & 1))
+                return BLOCK_AIR;
+            return cells[s * SECTION_VOLUME + ChunkSection::index(lx, (y - CHUNK_MIN_Y) % SECTION_SIZE, lz)];
+        }
+        uint64_t key = packBlockKey(x, y, z);
+        for (size_t i = overflow.count; i-- > 0;)
+            if ((overflow.items[i] >> 8) == key)
+                return static_cast<uint8_t>(overflow.items[i] & 0xFF);
+        return BLOCK_AIR;
+    }
+
+    void finish(Chunk& chunk) {
+        int top = 0;
+        for (int s = 0; s < SECTION_COUNT; s++)
+            if ((touchedSections >> s) & 1)
+                top = s + 1;
+        std::vector<ChunkSection> sections;
+        sections.reserve(top);
+        for (int s = 0; s < top; s++) {
+            if (!((touchedSections >> s) & 1)) {
+                sections.emplace_back();
+                continue;
+            }
+            const uint8_t* section = cells + s * SECTION_VOLUME;
+            uint16_t counts[256] = {};
+            for (int i = 0; i < SECTION_VOLUME; i++)
+                counts[section[i]]++;
+            uint8_t slot[256];
+            std::vector<uint8_t> palette;
+            for (int type = 0; type < 256; type++)
+                if (counts[type]) {
+                    slot[type] = static_cast<uint8_t>(palette.size());
+                    palette.push_back(static_cast<uint8_t>(type));
+                }
+            uint8_t bits = palette.size() <= 1 ? 0 : palette.size() <= 2 ? 1 : palette.size() <= 4 ? 2 : palette.size() <= 16 ? 4 : 8;
+            std::vector<uint64_t> data(bits ? SECTION_VOLUME / (64 / bits) : 0, 0);
+            if (bits) {
+                int perWord = 64 / bits;
+                for (int i = 0; i < SECTION_VOLUME; i++)
+                    data[i / perWord] |= static_cast<uint64_t>(slot[section[i]]) << ((i % perWord) * bits);
+            }
+            sections.emplace_back(std::move(palette), std::move(data), bits, static_cast<uint16_t>(SECTION_VOLUME - counts[BLOCK_AIR]));
+        }
+        chunk.sections = std::move(sections);
+
+        // Sort the spill-over by key, keeping placement order among equal keys
+        // so the last block placed in a cell is the one that stays.
+        struct Entry { uint64_t key; uint32_t order; uint8_t type; };
+        Entry* entries = overflow.arena.allocate<Entry>(overflow.count);
+        for (size_t i = 0; i < overflow.count; i++)
+            entries[i] = Entry{ overflow.items[i] >> 8, static_cast<uint32_t>(i), static_cast<uint8_t>(overflow.items[i] & 0xFF) };
+        std::sort(entries, entries + overflow.count, [](const Entry& a, const Entry& b) {
+            return a.key != b.key ? a.key < b.key : a.order < b.order;
+        });
+        size_t unique = 0;
+        for (size_t i = 0; i < overflow.count; i++) {
+            if (unique > 0 && entries[unique - 1].key == entries[i].key)
+                entries[unique - 1] = entries[i];
+            else
+                entries[unique++] = entries[i];
+        }
+        std::vector<uint64_t> packedOverflow(unique);
+        for (size_t i = 0; i < unique; i++)
+            packedOverflow[i] = (entries[i].key << 8) | entries[i].type;
+        chunk.overflow = std::move(packedOverflow);
+        chunk.branchPositions = std::vector<glm::vec4>(branches.begin(), branches.end());
+    }
+};
+
 // ---------------------- Helper: Tree Collision Check ----------------------
-bool treeCollision(const std::vector<glm::vec3>& trunkArray, const glm::vec3& base) {
-    for (const auto& p : trunkArray)
-        if (glm::distance(p, base) < 3.0f)
-            return true;
+// True if a trunk block of the given type already sits within 3 blocks of base.
+bool treeCollision(const ChunkBuilder& chunk, uint8_t trunkType, const glm::vec3& base) {
+    int bx = static_cast<int>(std::floor(base.x));
+    int by = static_cast<int>(std::floor(base.y));
+    int bz = static_cast<int>(std::floor(base.z));
+    for (int dy = -2; dy <= 2; dy++)
+        for (int dx = -2; dx <= 2; dx++)
+            for (int dz = -2; dz <= 2; dz++)
+                if (dx * dx + dy * dy + dz * dz < 9 && chunk.getWorld(bx + dx, by + dy, bz + dz) == trunkType)
+                    return true;
     return false;
 }
 
@@ -497,8 +1735,7 @@ bool treeCollision(const std::vector<glm::vec3>& trunkArray, const glm::vec3& ba
 
 // --- Pine Canopy Generation Function ---
 // Uses an "effective" trunk height (base trunk + extra trunk logs) to position the canopy.
-std::vector<glm::vec3> generatePineCanopy(int groundHeight, int effectiveTrunkHeight, int trunkThickness, double worldX, double worldZ) {
-    std::vector<glm::vec3> leafPositions;
+void generatePineCanopy(ChunkBuilder& chunk, int groundHeight, int effectiveTrunkHeight, int trunkThickness, double worldX, double worldZ) {
     int canopyOffset = 70;       // How far below the effective trunk top the canopy starts
     int canopyLayers = 80;       // Number of canopy layers
     int canopyBase = groundHeight + effectiveTrunkHeight - canopyOffset;
@@ -516,23 +1753,21 @@ std::vector<glm::vec3> generatePineCanopy(int groundHeight, int effectiveTrunkHe
                 float dist = std::sqrt(dx * dx + dz * dz);
                 // Fill the entire circle for this layer.
                 if (dist <= currentRadius) {
-                    leafPositions.push_back(glm::vec3(worldX + centerOffset + dx, yPos, worldZ + centerOffset + dz));
+                    chunk.place(glm::vec3(worldX + centerOffset + dx, yPos, worldZ + centerOffset + dz), BLOCK_PINE_LEAF);
                 }
             }
         }
     }
-    return leafPositions;
 }
 
 // --- Pine Tree Generation Function (Trunk + Extra Logs + Canopy) ---
 // "trunkHeight" is the base trunk height, and "extraTrunkLogs" is how many extra trunk blocks to add on top.
-void generatePineTree(Chunk& chunk, int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ, int extraTrunkLogs) {
+void generatePineTree(ChunkBuilder& chunk, int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ, int extraTrunkLogs) {
     // --- Generate Main Trunk Logs (base trunk) ---
     for (int i = 1; i <= trunkHeight; i++) {
         for (int tx = 0; tx < trunkThickness; tx++) {
             for (int tz = 0; tz < trunkThickness; tz++) {
-                glm::vec3 pos(worldX + tx, groundHeight + i, worldZ + tz);
-                chunk.treeTrunkPositions.push_back(pos);
+                chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
             }
         }
     }
@@ -541,23 +1776,20 @@ void generatePineTree(Chunk& chunk, int groundHeight, int trunkHeight, int trunk
     for (int i = trunkHeight + 1; i <= trunkHeight + extraTrunkLogs; i++) {
         for (int tx = 0; tx < trunkThickness; tx++) {
             for (int tz = 0; tz < trunkThickness; tz++) {
-                glm::vec3 pos(worldX + tx, groundHeight + i, worldZ + tz);
-                chunk.treeTrunkPositions.push_back(pos);
+                chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
             }
         }
     }
 
     // --- Generate Canopy Using the Effective Trunk Height ---
     int effectiveTrunkHeight = trunkHeight + extraTrunkLogs;
-    std::vector<glm::vec3> canopy = generatePineCanopy(groundHeight, effectiveTrunkHeight, trunkThickness, worldX, worldZ);
-    chunk.treeLeafPositions.insert(chunk.treeLeafPositions.end(), canopy.begin(), canopy.end());
+    generatePineCanopy(chunk, groundHeight, effectiveTrunkHeight, trunkThickness, worldX, worldZ);
 }
 
 
 
 
-std::vector<glm::vec3> generateFirCanopy(int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ) {
-    std::vector<glm::vec3> leafPositions;
+void generateFirCanopy(ChunkBuilder& chunk, int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ) {
     int centerY = groundHeight + trunkHeight;
     float radius = 7.0f;
     for (int dy = -static_cast<int>(radius); dy <= static_cast<int>(radius); dy++) {
@@ -565,16 +1797,14 @@ std::vector<glm::vec3> generateFirCanopy(int groundHeight, int trunkHeight, int
             for (int dz = -static_cast<int>(radius); dz <= static_cast<int>(radius); dz++) {
                 float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
                 if (dist < radius) {
-                    leafPositions.push_back(glm::vec3(worldX + trunkThickness / 2.0f + dx, centerY + dy, worldZ + trunkThickness / 2.0f + dz));
+                    chunk.place(glm::vec3(worldX + trunkThickness / 2.0f + dx, centerY + dy, worldZ + trunkThickness / 2.0f + dz), BLOCK_FIR_LEAF);
                 }
             }
         }
     }
-    return leafPositions;
 }
 
-std::vector<glm::vec3> generateOakCanopy(int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ) {
-    std::vector<glm::vec3> leaves;
+void generateOakCanopy(ChunkBuilder& chunk, int groundHeight, int trunkHeight, int trunkThickness, double worldX, double worldZ) {
     int centerY = groundHeight + trunkHeight + 2;
     float radius = 4.0f;
     float centerOffset = trunkThickness / 2.0f;
@@ -583,68 +1813,82 @@ std::vector<glm::vec3> generateOakCanopy(int groundHeight, int trunkHeight, int
             for (int dz = -static_cast<int>(radius); dz <= static_cast<int>(radius); dz++) {
                 float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
                 if (dist < radius) {
-                    leaves.push_back(glm::vec3(worldX + centerOffset + dx, centerY + dy, worldZ + centerOffset + dz));
+                    chunk.place(glm::vec3(worldX + centerOffset + dx, centerY + dy, worldZ + centerOffset + dz), BLOCK_OAK_LEAF);
                 }
             }
         }
     }
-    return leaves;
 }
 
 // ---------------------- Raycasting ----------------------
-glm::ivec3 raycastForBlock(bool place) {
-    float t = 0.0f;
-    while (t < 5.0f) {
-        glm::vec3 front;
-        front.x = cos(glm::radians(cameraYaw)) * cos(glm::radians(pitch));
-        front.y = sin(glm::radians(pitch));
-        front.z = sin(glm::radians(cameraYaw)) * cos(glm::radians(pitch));
-        front = glm::normalize(front);
-        glm::vec3 p = cameraPos + t * front;
-        glm::ivec3 candidate = glm::ivec3(std::round(p.x), std::round(p.y), std::round(p.z));
-        bool exists = false;
-        int chunkX = static_cast<int>(std::floor(candidate.x / static_cast<float>(CHUNK_SIZE)));
-        int chunkZ = static_cast<int>(std::floor(candidate.z / static_cast<float>(CHUNK_SIZE)));
-        ChunkPos cp2{ chunkX, chunkZ };
-        if (chunks.find(cp2) != chunks.end()) {
-            Chunk& ch = chunks[cp2];
-            for (const auto& vec : { ch.waterPositions, ch.grassPositions, ch.dirtPositions,
-                                      ch.deepStonePositions, ch.lavaPositions, ch.treeTrunkPositions,
-                                      ch.treeLeafPositions, ch.firLeafPositions, ch.waterLilyPositions,
-                                      ch.fallenTreeTrunkPositions, ch.oakTrunkPositions, ch.oakLeafPositions,
-                                      ch.leafPilePositions, ch.bushSmallPositions, ch.bushMediumPositions,
-                                      ch.bushLargePositions, ch.sandPositions, ch.snowPositions })
-            {
-                for (const auto& pos : vec) {
-                    if (glm::all(glm::epsilonEqual(pos, glm::vec3(candidate), 0.5f))) {
-                        exists = true;
-                        break;
-                    }
-                }
-                if (exists)
-                    break;
-            }
+struct VoxelHit {
+    glm::ivec3 cell;    // block that was hit
+    glm::ivec3 normal;  // face the ray entered through; zero if it started inside
+    float distance;     // along the normalized ray
+    uint8_t type;
+};
+
+// Grid traversal after Amanatides & Woo: visits every cell the ray crosses, in
+// order, and stops at the first selectable block. Blocks are drawn centred on
+// their integer position, so block p spans p - 0.5 .. p + 0.5 here. Lookups go
+// through getBlockAt and so cross chunk borders (and spill-over) transparently.
+bool raycastVoxels(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, VoxelHit& hit) {
+    glm::vec3 dir = glm::normalize(direction);
+    glm::vec3 start = origin + glm::vec3(0.5f);
+    glm::ivec3 cell = glm::ivec3(glm::floor(start));
+    glm::ivec3 step(0);
+    glm::vec3 tMax(std::numeric_limits<float>::infinity());
+    glm::vec3 tDelta(std::numeric_limits<float>::infinity());
+    for (int axis = 0; axis < 3; axis++) {
+        if (dir[axis] > 0.0f) {
+            step[axis] = 1;
+            tDelta[axis] = 1.0f / dir[axis];
+            tMax[axis] = (cell[axis] + 1 - start[axis]) * tDelta[axis];
         }
-        TerrainPoint terrain = getTerrainHeight(p.x, p.z);
-        if (!exists && terrain.isLand && candidate.y <= static_cast<int>(std::floor(terrain.height)))
-            exists = true;
-        if (exists) {
-            if (!place)
-                return candidate;
-            else {
-                glm::vec3 center = glm::vec3(candidate) + glm::vec3(0.5f);
-                glm::vec3 diff = p - center;
-                if (std::abs(diff.x) > std::abs(diff.y) && std::abs(diff.x) > std::abs(diff.z))
-                    return candidate + glm::ivec3((diff.x > 0) ? 1 : -1, 0, 0);
-                else if (std::abs(diff.y) > std::abs(diff.x) && std::abs(diff.y) > std::abs(diff.z))
-                    return candidate + glm::ivec3(0, (diff.y > 0) ? 1 : -1, 0);
-                else
-                    return candidate + glm::ivec3(0, 0, (diff.z > 0) ? 1 : -1);
-            }
+        else if (dir[axis] < 0.0f) {
+            step[axis] = -1;
+            tDelta[axis] = -1.0f / dir[axis];
+            tMax[axis] = (start[axis] - cell[axis]) * tDelta[axis];
+        }
+    }
+    glm::ivec3 normal(0);
+    float t = 0.0f;
+    for (;;) {
+        uint8_t type = getBlockAt(cell.x, cell.y, cell.z);
+        if (isSelectableBlock(type)) {
+            hit.cell = cell;
+            hit.normal = normal;
+            hit.distance = t;
+            hit.type = type;
+            return true;
         }
-        t += 0.1f;
+        int axis = (tMax.x < tMax.y) ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+        t = tMax[axis];
+        if (t > maxDistance)
+            return false;
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
     }
-    return glm::ivec3(-10000, -10000, -10000);
+}
+
+// Block the player is looking at (or, with place, the empty cell in front of
+// the face that was hit); (-10000, -10000, -10000) if nothing is in reach.
+glm::ivec3 raycastForBlock(bool place) {
+    const glm::ivec3 none(-10000, -10000, -10000);
+    glm::vec3 front;
+    front.x = cos(glm::radians(cameraYaw)) * cos(glm::radians(pitch));
+    front.y = sin(glm::radians(pitch));
+    front.z = sin(glm::radians(cameraYaw)) * cos(glm::radians(pitch));
+    VoxelHit hit;
+    if (!raycastVoxels(cameraPos, front, 5.0f, hit))
+        return none;
+    if (!place)
+        return hit.cell;
+    if (hit.normal == glm::ivec3(0))
+        return none;
+    return hit.cell + hit.normal;
 }
 
 // ---------------------- Mouse Button Callback ----------------------
@@ -652,19 +1896,17 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     if (action == GLFW_PRESS) {
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
             glm::ivec3 pos = raycastForBlock(false);
-            if (pos.x != -10000) {
-                // Removal logic (not implemented)
-            }
+            if (pos.x != -10000)
+                setBlockAt(pos.x, pos.y, pos.z, BLOCK_AIR);
         }
         else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
             glm::ivec3 hitBlock = raycastForBlock(false);
             if (hitBlock.x != -10000) {
-                int blockTypeToPlace = 0;
-                // Determine block type...
+                // Place another block of the type being looked at.
+                uint8_t blockTypeToPlace = getBlockAt(hitBlock.x, hitBlock.y, hitBlock.z);
                 glm::ivec3 pos = raycastForBlock(true);
-                if (pos.x != -10000) {
-                    // Place block (not implemented)
-                }
+                if (pos.x != -10000 && getBlockAt(pos.x, pos.y, pos.z) == BLOCK_AIR)
+                    setBlockAt(pos.x, pos.y, pos.z, blockTypeToPlace);
             }
         }
     }
@@ -757,139 +1999,182 @@ struct Quadtree {
     }
 };
 
-// ---------------------- Collision Handling ----------------------
-void handleCollision() {
-    // Get the player's current AABB.
-    glm::vec3 playerMin = cameraPos + getPlayerBoxMin();
-    glm::vec3 playerMax = cameraPos + getPlayerBoxMax();
-
-    // For each nearby chunk:
-    int chunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
-    int chunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
-    for (int cx = chunkX - 1; cx <= chunkX + 1; cx++) {
-        for (int cz = chunkZ - 1; cz <= chunkZ + 1; cz++) {
-            ChunkPos cp(cx, cz);
-            if (chunks.find(cp) != chunks.end()) {
-                Chunk& ch = chunks[cp];
-
-                auto resolveAABB = [&](const glm::vec3& boxMin, const glm::vec3& boxMax) {
-                    // Check if overlapping
-                    if (playerMax.x > boxMin.x && playerMin.x < boxMax.x &&
-                        playerMax.y > boxMin.y && playerMin.y < boxMax.y &&
-                        playerMax.z > boxMin.z && playerMin.z < boxMax.z) {
-
-                        // Calculate penetration depth along each axis
-                        float penX = std::min(playerMax.x - boxMin.x, boxMax.x - playerMin.x);
-                        float penY = std::min(playerMax.y - boxMin.y, boxMax.y - playerMin.y);
-                        float penZ = std::min(playerMax.z - boxMin.z, boxMax.z - playerMin.z);
-
-                        // Only resolve if penetration is significant
-                        const float threshold = 0.01f;
-                        if (penX < threshold && penY < threshold && penZ < threshold)
-                            return;
-
-                        // Resolve along the axis with the smallest penetration.
-                        if (penX <= penY && penX <= penZ)
-                        {
-                            if (cameraPos.x < boxMin.x)
-                                cameraPos.x -= penX;
-                            else
-                                cameraPos.x += penX;
-                        }
-                        else if (penY <= penX && penY <= penZ)
-                        {
-                            if (cameraPos.y < boxMin.y)
-                                cameraPos.y -= penY;
-                            else
-                                cameraPos.y += penY;
-                            // Also zero out vertical velocity if moving downward.
-                            if (velocity.y < 0)
-                                velocity.y = 0;
-                        }
-                        else
-                        {
-                            if (cameraPos.z < boxMin.z)
-                                cameraPos.z -= penZ;
-                            else
-                                cameraPos.z += penZ;
-                        }
+// ---------------------- Voxel Collision ----------------------
+// Boxes move through the block grid by sweeping: each axis is clipped in turn
+// (Y, then X, then Z) against the solid blocks in the cells the box passes
+// through, so only those cells are ever looked at and nothing is skipped at
+// high speed. A solid block at p collides as the unit box [p, p + 1), shifted
+// by its blockRenderOffset (water lilies sit lower than their cell).
+const float COLLISION_EPSILON = 1e-4f;
+
+struct SweepResult {
+    glm::vec3 moved;     // displacement actually applied
+    glm::bvec3 blocked;  // axes that were cut short by a block
+};
 
-                        // Recalculate player's AABB after adjustment.
-                        playerMin = cameraPos + getPlayerBoxMin();
-                        playerMax = cameraPos + getPlayerBoxMax();
-                    }
-                    };
-
-                // Check against each solid block in the chunk.
-                auto checkBlocks = [&](const std::vector<glm::vec3>& blocks) {
-                    for (const auto& pos : blocks) {
-                        glm::vec3 blockMin = pos;
-                        glm::vec3 blockMax = pos + glm::vec3(1.0f);
-                        resolveAABB(blockMin, blockMax);
-                    }
-                    };
-
-                checkBlocks(ch.grassPositions);
-                checkBlocks(ch.sandPositions);
-                checkBlocks(ch.snowPositions);
-                checkBlocks(ch.dirtPositions);
-                checkBlocks(ch.treeTrunkPositions);
-                checkBlocks(ch.oakTrunkPositions);
-                checkBlocks(ch.ancientTrunkPositions);
-                checkBlocks(ch.waterLilyPositions);
-                checkBlocks(ch.deepStonePositions);
-                // ... add other block arrays as needed.
+// Calls visit(blockMin, blockMax) for every solid block that may overlap the
+// region [regionMin, regionMax]. One extra cell is scanned below and above for
+// blocks that are offset out of their own cell.
+template <typename Visit>
+void forEachSolidBlock(const glm::vec3& regionMin, const glm::vec3& regionMax, Visit visit) {
+    glm::ivec3 cellMin = glm::ivec3(glm::floor(regionMin)) - glm::ivec3(0, 1, 0);
+    glm::ivec3 cellMax = glm::ivec3(glm::floor(regionMax)) + glm::ivec3(0, 1, 0);
+    for (int x = cellMin.x; x <= cellMax.x; x++) {
+        for (int z = cellMin.z; z <= cellMax.z; z++) {
+            // Same lookup as getBlockAt, with the chunk searches done once per column.
+            int cx = floorDiv(x, CHUNK_SIZE), cz = floorDiv(z, CHUNK_SIZE);
+            auto owner = chunks.find(ChunkPos(cx, cz));
+            const Chunk* column = owner != chunks.end() ? &owner->second : nullptr;
+            const Chunk* spill[9];
+            int spillCount = 0;
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dz = -1; dz <= 1; dz++) {
+                    auto n = chunks.find(ChunkPos(cx + dx, cz + dz));
+                    if (n != chunks.end() && !n->second.overflow.empty())
+                        spill[spillCount++] = &n->second;
+                }
+            for (int y = cellMin.y; y <= cellMax.y; y++) {
+                uint8_t type = column ? column->getLocal(x - cx * CHUNK_SIZE, y, z - cz * CHUNK_SIZE) : static_cast<uint8_t>(BLOCK_AIR);
+                if (type == BLOCK_AIR && spillCount > 0) {
+                    uint64_t key = packBlockKey(x, y, z);
+                    for (int i = 0; i < spillCount && type == BLOCK_AIR; i++)
+                        type = spill[i]->getOverflow(key);
+                }
+                if (!isSolidBlock(type))
+                    continue;
+                glm::vec3 blockMin = glm::vec3(x, y, z) + blockRenderOffset(type);
+                visit(blockMin, blockMin + glm::vec3(1.0f));
             }
         }
     }
+}
+
+// Moves the box [boxMin, boxMax] by delta, stopping each axis at the first
+// block in its way. Blocks the box already overlaps do not stop it (see
+// depenetrateAABB).
+SweepResult sweepAABB(glm::vec3 boxMin, glm::vec3 boxMax, const glm::vec3& delta) {
+    SweepResult result = { glm::vec3(0.0f), glm::bvec3(false) };
+    const int order[3] = { 1, 0, 2 };
+    for (int axis : order) {
+        float d = delta[axis];
+        if (d == 0.0f)
+            continue;
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        glm::vec3 regionMin = boxMin, regionMax = boxMax;
+        if (d > 0.0f) regionMax[axis] += d;
+        else regionMin[axis] += d;
+        float allowed = d;
+        forEachSolidBlock(regionMin, regionMax, [&](const glm::vec3& blockMin, const glm::vec3& blockMax) {
+            if (boxMax[u] <= blockMin[u] + COLLISION_EPSILON || boxMin[u] >= blockMax[u] - COLLISION_EPSILON ||
+                boxMax[v] <= blockMin[v] + COLLISION_EPSILON || boxMin[v] >= blockMax[v] - COLLISION_EPSILON)
+                return;
+            if (allowed > 0.0f && blockMin[axis] >= boxMax[axis] - COLLISION_EPSILON)
+                allowed = std::min(allowed, std::max(0.0f, blockMin[axis] - boxMax[axis]));
+            else if (allowed < 0.0f && blockMax[axis] <= boxMin[axis] + COLLISION_EPSILON)
+                allowed = std::max(allowed, std::min(0.0f, blockMax[axis] - boxMin[axis]));
+        });
+        if (allowed != d)
+            result.blocked[axis] = true;
+        boxMin[axis] += allowed;
+        boxMax[axis] += allowed;
+        result.moved[axis] = allowed;
+    }
+    return result;
+}
+
+// Pushes a box that ended up inside blocks (a block placed into it, a taller
+// stance, teleports) out along the axis of least penetration, one block at a
+// time. Returns true if it moved the box.
+bool depenetrateAABB(glm::vec3& position, const glm::vec3& minOffset, const glm::vec3& maxOffset) {
+    const float threshold = 0.01f;
+    bool moved = false;
+    glm::vec3 boxMin = position + minOffset, boxMax = position + maxOffset;
+    forEachSolidBlock(boxMin, boxMax, [&](const glm::vec3& blockMin, const glm::vec3& blockMax) {
+        if (!(boxMax.x > blockMin.x && boxMin.x < blockMax.x &&
+              boxMax.y > blockMin.y && boxMin.y < blockMax.y &&
+              boxMax.z > blockMin.z && boxMin.z < blockMax.z))
+            return;
+        glm::vec3 pen(std::min(boxMax.x - blockMin.x, blockMax.x - boxMin.x),
+                      std::min(boxMax.y - blockMin.y, blockMax.y - boxMin.y),
+                      std::min(boxMax.z - blockMin.z, blockMax.z - boxMin.z));
+        if (pen.x < threshold && pen.y < threshold && pen.z < threshold)
+            return;
+        int axis = (pen.x <= pen.y && pen.x <= pen.z) ? 0 : (pen.y <= pen.z ? 1 : 2);
+        float centre = (blockMin[axis] + blockMax[axis]) * 0.5f;
+        position[axis] += (position[axis] < centre) ? -pen[axis] : pen[axis];
+        boxMin = position + minOffset;
+        boxMax = position + maxOffset;
+        moved = true;
+    });
+    return moved;
+}
+
+// Entity-level helper: moves position by delta through the world and cancels
+// the velocity components that ran into a block. Returns the blocked axes.
+glm::bvec3 moveAndCollide(glm::vec3& position, glm::vec3& velocity, const glm::vec3& minOffset,
+                          const glm::vec3& maxOffset, const glm::vec3& delta) {
+    depenetrateAABB(position, minOffset, maxOffset);
+    SweepResult sweep = sweepAABB(position + minOffset, position + maxOffset, delta);
+    position += sweep.moved;
+    for (int axis = 0; axis < 3; axis++)
+        if (sweep.blocked[axis] && velocity[axis] * delta[axis] > 0.0f)
+            velocity[axis] = 0.0f;
+    return sweep.blocked;
+}
+
+// ---------------------- Collision Handling ----------------------
+// The movement modes integrate cameraPos freely; this replays the frame's
+// displacement from where the player started through the voxel grid.
+void handleCollision(const glm::vec3& previousPos) {
+    glm::vec3 delta = cameraPos - previousPos;
+    cameraPos = previousPos;
+    moveAndCollide(cameraPos, velocity, getPlayerBoxMin(), getPlayerBoxMax(), delta);
 
     // For water areas, only apply minimal sinking correction.
-    TerrainPoint tp = getTerrainHeight(cameraPos.x, cameraPos.z);
+    TerrainPoint tp = getTerrainAt(cameraPos.x, cameraPos.z);
     if (!tp.isLand && cameraPos.y < -1.0f)
         cameraPos.y = -1.0f;
 }
-// ---------------------- Chunk Mesh Generation ----------------------
-void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
-    if (!chunk.needsMeshUpdate)
-        return;
-    chunk.waterPositions.clear();
-    chunk.grassPositions.clear();
-    chunk.sandPositions.clear();
-    chunk.snowPositions.clear();
-    chunk.dirtPositions.clear();
-    chunk.deepStonePositions.clear();
-    chunk.lavaPositions.clear();
-    chunk.treeTrunkPositions.clear();
-    chunk.treeLeafPositions.clear();
-    chunk.firLeafPositions.clear();
-    chunk.waterLilyPositions.clear();
-    chunk.fallenTreeTrunkPositions.clear();
-    chunk.oakTrunkPositions.clear();
-    chunk.oakLeafPositions.clear();
-    chunk.leafPilePositions.clear();
-    chunk.bushSmallPositions.clear();
-    chunk.bushMediumPositions.clear();
-    chunk.bushLargePositions.clear();
-    chunk.branchPositions.clear();
-    chunk.ancientTrunkPositions.clear();
-    chunk.ancientLeafPositions.clear();
-    chunk.ancientBranchPositions.clear();
-    chunk.auroraPositions.clear();
-    chunk.icePositions.clear();
+// ---------------------- Chunk Generation ----------------------
+void generateChunkBlocks(Chunk& target, int chunkX, int chunkZ) {
+    static thread_local ScratchArena arena;
+    arena.reset();
+    target.chunkX = chunkX;
+    target.chunkZ = chunkZ;
+    ChunkBuilder chunk(arena, chunkX, chunkZ);
+    // Column heights with a one-block apron for the neighbour checks, and the
+    // cave/liquid noise for every underground layer, sampled in SIMD batches.
+    const int GRID = CHUNK_SIZE + 2;
+    const int CAVE_LAYERS = -MIN_Y;
+    const int originX = chunkX * CHUNK_SIZE, originZ = chunkZ * CHUNK_SIZE;
+    TerrainPoint terrainGrid[GRID * GRID];
+    getTerrainHeightGrid(originX - 1, originZ - 1, GRID, terrainGrid);
+    auto terrainAt = [&](int x, int z) -> const TerrainPoint& { return terrainGrid[(x + 1) * GRID + (z + 1)]; };
+    ChunkHeightmap heightmap;
+    for (int x = 0; x < CHUNK_SIZE; x++)
+        for (int z = 0; z < CHUNK_SIZE; z++)
+            heightmap.set(x, z, terrainAt(x, z));
+    storeChunkHeightmap(chunkX, chunkZ, heightmap);
+    float* oceanCave = arena.allocate<float>(CHUNK_SIZE * CHUNK_SIZE * CAVE_LAYERS);
+    float* landCave = arena.allocate<float>(CHUNK_SIZE * CHUNK_SIZE * CAVE_LAYERS);
+    float* liquidCave = arena.allocate<float>(CHUNK_SIZE * CHUNK_SIZE * CAVE_LAYERS);
+    caveNoise.noiseBlock(originX, MIN_Y, originZ, 0.04, CHUNK_SIZE, CAVE_LAYERS, CHUNK_SIZE, oceanCave);
+    caveNoise.noiseBlock(originX, MIN_Y, originZ, 0.1, CHUNK_SIZE, CAVE_LAYERS, CHUNK_SIZE, landCave);
+    lavaCaveNoise.noiseBlock(originX, MIN_Y, originZ, 0.02, CHUNK_SIZE, CAVE_LAYERS, CHUNK_SIZE, liquidCave);
+    auto caveIndex = [&](int x, int y, int z) { return ((y - MIN_Y) * CHUNK_SIZE + x) * CHUNK_SIZE + z; };
     for (int x = 0; x < CHUNK_SIZE; x++) {
         for (int z = 0; z < CHUNK_SIZE; z++) {
-            double worldX = chunkX * CHUNK_SIZE + x;
-            double worldZ = chunkZ * CHUNK_SIZE + z;
-            TerrainPoint terrain = getTerrainHeight(worldX, worldZ);
+            double worldX = originX + x;
+            double worldZ = originZ + z;
+            const TerrainPoint& terrain = terrainAt(x, z);
             if (!terrain.isLand) {
-                chunk.waterPositions.push_back(glm::vec3(worldX, 0.0f, worldZ));
+                chunk.place(glm::vec3(worldX, 0.0f, worldZ), BLOCK_WATER);
                 if (x > 3 && x < CHUNK_SIZE - 3 && z > 3 && z < CHUNK_SIZE - 3 &&
                     (x % 7 == 3) && (z % 7 == 3)) {
                     bool canPlaceLily = true;
                     for (int dx = -3; dx <= 3; dx++) {
                         for (int dz = -3; dz <= 3; dz++) {
-                            TerrainPoint neighbor = getTerrainHeight(worldX + dx, worldZ + dz);
-                            if (neighbor.isLand) { canPlaceLily = false; break; }
+                            if (terrainAt(x + dx, z + dz).isLand) { canPlaceLily = false; break; }
                         }
                         if (!canPlaceLily) break;
                     }
@@ -901,49 +2186,49 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                                     // Skip the 3-block corners
                                     if ((dx <= -5 || dx >= 4) && (dz <= -5 || dz >= 4))
                                         continue;
-                                    chunk.waterLilyPositions.push_back(glm::vec3(worldX + dx, 0.2f, worldZ + dz));
+                                    chunk.place(glm::vec3(worldX + dx, 1.0f, worldZ + dz), BLOCK_WATER_LILY);
                                 }
                             }
                         }
                     }
                 }
                 for (int y = -1; y >= MIN_Y; y--) {
-                    double caveVal = caveNoise.noise(worldX * 0.04, y * 0.04, worldZ * 0.04);
+                    double caveVal = oceanCave[caveIndex(x, y, z)];
                     if (caveVal < 0.6)
-                        chunk.deepStonePositions.push_back(glm::vec3(worldX, y, worldZ));
+                        chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_DEEP_STONE);
                     else {
                         if (y < 0)
-                            chunk.waterPositions.push_back(glm::vec3(worldX, y, worldZ));
+                            chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_WATER);
                     }
                 }
             }
             else {
                 int groundHeight = static_cast<int>(std::floor(terrain.height));
                 if (chunkX >= 160)
-                    chunk.sandPositions.push_back(glm::vec3(worldX, groundHeight, worldZ));
+                    chunk.place(glm::vec3(worldX, groundHeight, worldZ), BLOCK_SAND);
                 else if (chunkZ <= -160)
-                    chunk.snowPositions.push_back(glm::vec3(worldX, groundHeight, worldZ));
+                    chunk.place(glm::vec3(worldX, groundHeight, worldZ), BLOCK_SNOW);
                 else
-                    chunk.grassPositions.push_back(glm::vec3(worldX, groundHeight, worldZ));
-                chunk.dirtPositions.push_back(glm::vec3(worldX, groundHeight - 1, worldZ));
+                    chunk.place(glm::vec3(worldX, groundHeight, worldZ), BLOCK_GRASS);
+                chunk.place(glm::vec3(worldX, groundHeight - 1, worldZ), BLOCK_DIRT);
                 for (int y = groundHeight - 2; y >= MIN_Y; y--) {
                     if (y >= 0) {
-                        chunk.deepStonePositions.push_back(glm::vec3(worldX, y, worldZ));
+                        chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_DEEP_STONE);
                     }
                     else {
-                        double caveVal = caveNoise.noise(worldX * 0.1, y * 0.1, worldZ * 0.1);
+                        double caveVal = landCave[caveIndex(x, y, z)];
                         if (caveVal < -0.8)
-                            chunk.deepStonePositions.push_back(glm::vec3(worldX, y, worldZ));
+                            chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_DEEP_STONE);
                         else {
-                            double liquidVal = lavaCaveNoise.noise(worldX * 0.02, y * 0.02, worldZ * 0.02);
+                            double liquidVal = liquidCave[caveIndex(x, y, z)];
                             if (liquidVal < 0.3) {
                                 if (worldZ / CHUNK_SIZE <= -20)
-                                    chunk.icePositions.push_back(glm::vec3(worldX, y, worldZ));
+                                    chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_ICE);
                                 else
-                                    chunk.waterPositions.push_back(glm::vec3(worldX, y, worldZ));
+                                    chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_WATER);
                             }
                             else
-                                chunk.lavaPositions.push_back(glm::vec3(worldX, y, worldZ));
+                                chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_LAVA);
                         }
                     }
                 }
@@ -962,14 +2247,12 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                         // So we add trunk blocks from groundHeight + 1 up to groundHeight + trunkHeight
                         // and then add extra trunk blocks below ground (without affecting canopy).
                         glm::vec3 pineBase = glm::vec3(worldX, groundHeight + 1, worldZ);
-                        if (hashValPine % 2000 < 1 && !treeCollision(chunk.treeTrunkPositions, pineBase)) {
+                        if (hashValPine % 2000 < 1 && !treeCollision(chunk, BLOCK_TREE_TRUNK, pineBase)) {
                             // Draw main trunk (above ground)
                             for (int i = 1; i <= trunkHeight; i++) {
                                 for (int tx = 0; tx < trunkThickness; tx++) {
                                     for (int tz = 0; tz < trunkThickness; tz++) {
-                                        chunk.treeTrunkPositions.push_back(
-                                            glm::vec3(worldX + tx, groundHeight + i, worldZ + tz)
-                                        );
+                                        chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
                                     }
                                 }
                             }
@@ -977,9 +2260,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             for (int i = 0; i < extraBottom; i++) {
                                 for (int tx = 0; tx < trunkThickness; tx++) {
                                     for (int tz = 0; tz < trunkThickness; tz++) {
-                                        chunk.treeTrunkPositions.push_back(
-                                            glm::vec3(worldX + tx, groundHeight - i, worldZ + tz)
-                                        );
+                                        chunk.place(glm::vec3(worldX + tx, groundHeight - i, worldZ + tz), BLOCK_TREE_TRUNK);
                                     }
                                 }
                             }
@@ -987,15 +2268,12 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             for (int i = trunkHeight + 1; i <= trunkHeight + extraHeight; i++) {
                                 for (int tx = 0; tx < trunkThickness; tx++) {
                                     for (int tz = 0; tz < trunkThickness; tz++) {
-                                        chunk.treeTrunkPositions.push_back(
-                                            glm::vec3(worldX + tx, groundHeight + i, worldZ + tz)
-                                        );
+                                        chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
                                     }
                                 }
                             }
                             // Generate canopy at the original trunk height (unchanged)
-                            std::vector<glm::vec3> pineCanopy = generatePineCanopy(groundHeight, trunkHeight, trunkThickness, worldX, worldZ);
-                            chunk.treeLeafPositions.insert(chunk.treeLeafPositions.end(), pineCanopy.begin(), pineCanopy.end());
+                            generatePineCanopy(chunk, groundHeight, trunkHeight, trunkThickness, worldX, worldZ);
                         }
                     }
                     // ----- Pine Tree Branch for other areas -----
@@ -1003,14 +2281,12 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                         if (currentChunkZ < 40) {
                             int hashValPine = std::abs((intWorldX * 73856093) ^ (intWorldZ * 19349663));
                             glm::vec3 pineBase = glm::vec3(worldX, groundHeight + 1, worldZ);
-                            if (hashValPine % 2000 < 1 && !treeCollision(chunk.treeTrunkPositions, pineBase)) {
+                            if (hashValPine % 2000 < 1 && !treeCollision(chunk, BLOCK_TREE_TRUNK, pineBase)) {
                                 // Draw main trunk above ground
                                 for (int i = 1; i <= trunkHeight; i++) {
                                     for (int tx = 0; tx < trunkThickness; tx++) {
                                         for (int tz = 0; tz < trunkThickness; tz++) {
-                                            chunk.treeTrunkPositions.push_back(
-                                                glm::vec3(worldX + tx, groundHeight + i, worldZ + tz)
-                                            );
+                                            chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
                                         }
                                     }
                                 }
@@ -1018,9 +2294,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                                 for (int i = 0; i < extraBottom; i++) {
                                     for (int tx = 0; tx < trunkThickness; tx++) {
                                         for (int tz = 0; tz < trunkThickness; tz++) {
-                                            chunk.treeTrunkPositions.push_back(
-                                                glm::vec3(worldX + tx, groundHeight - i, worldZ + tz)
-                                            );
+                                            chunk.place(glm::vec3(worldX + tx, groundHeight - i, worldZ + tz), BLOCK_TREE_TRUNK);
                                         }
                                     }
                                 }
@@ -1031,55 +2305,52 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                                             glm::vec3 pos = glm::vec3(worldX + tx, groundHeight + i, worldZ + tz);
                                             // If this is one of the top 8 blocks, turn it into a leaf block.
                                             if (i > trunkHeight - 1)
-                                                chunk.treeLeafPositions.push_back(pos);
+                                                chunk.place(pos, BLOCK_PINE_LEAF);
                                             else
-                                                chunk.treeTrunkPositions.push_back(pos);
+                                                chunk.place(pos, BLOCK_TREE_TRUNK);
                                         }
                                     }
                                 }
 
-                                std::vector<glm::vec3> pineCanopy = generatePineCanopy(groundHeight, trunkHeight, trunkThickness, worldX, worldZ);
-                                chunk.treeLeafPositions.insert(chunk.treeLeafPositions.end(), pineCanopy.begin(), pineCanopy.end());
+                                generatePineCanopy(chunk, groundHeight, trunkHeight, trunkThickness, worldX, worldZ);
                             }
                         } {
                             int hashValFir = std::abs((intWorldX * 83492791) ^ (intWorldZ * 19349663));
                             glm::vec3 firBase = glm::vec3(worldX, groundHeight + 1, worldZ);
-                            if (hashValFir % 2000 < 1 && !treeCollision(chunk.treeTrunkPositions, firBase)) {
+                            if (hashValFir % 2000 < 1 && !treeCollision(chunk, BLOCK_TREE_TRUNK, firBase)) {
                                 int trunkHeightFir = 40, trunkThicknessFir = 3;
                                 for (int i = 1; i <= trunkHeightFir; i++) {
                                     for (int tx = 0; tx < trunkThicknessFir; tx++) {
                                         for (int tz = 0; tz < trunkThicknessFir; tz++) {
-                                            chunk.treeTrunkPositions.push_back(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz));
+                                            chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_TREE_TRUNK);
                                         }
                                     }
                                 }
-                                std::vector<glm::vec3> firCanopy = generateFirCanopy(groundHeight, trunkHeightFir, trunkThicknessFir, worldX, worldZ);
-                                chunk.firLeafPositions.insert(chunk.firLeafPositions.end(), firCanopy.begin(), firCanopy.end());
+                                generateFirCanopy(chunk, groundHeight, trunkHeightFir, trunkThicknessFir, worldX, worldZ);
                             }
                         } {
                             int hashValOak = std::abs((intWorldX * 92821) ^ (intWorldZ * 123457));
                             glm::vec3 oakBase = glm::vec3(worldX, groundHeight + 1, worldZ);
-                            if (hashValOak % 1000 < 1 && !treeCollision(chunk.oakTrunkPositions, oakBase)) {
+                            if (hashValOak % 1000 < 1 && !treeCollision(chunk, BLOCK_OAK_TRUNK, oakBase)) {
                                 int trunkHeightOak = 7, trunkThicknessOak = 2;
                                 for (int i = 1; i <= trunkHeightOak; i++) {
                                     for (int tx = 0; tx < trunkThicknessOak; tx++) {
                                         for (int tz = 0; tz < trunkThicknessOak; tz++) {
-                                            chunk.oakTrunkPositions.push_back(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz));
+                                            chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_OAK_TRUNK);
                                         }
                                     }
                                 }
-                                std::vector<glm::vec3> oakCanopy = generateOakCanopy(groundHeight, trunkHeightOak, trunkThicknessOak, worldX, worldZ);
-                                chunk.oakLeafPositions.insert(chunk.oakLeafPositions.end(), oakCanopy.begin(), oakCanopy.end());
+                                generateOakCanopy(chunk, groundHeight, trunkHeightOak, trunkThicknessOak, worldX, worldZ);
                             }
                         } {
                             int hashValAncient = std::abs((intWorldX * 112233) ^ (intWorldZ * 445566));
                             glm::vec3 ancientBase = glm::vec3(worldX, groundHeight + 1, worldZ);
-                            if (hashValAncient % 3000 < 1 && !treeCollision(chunk.ancientTrunkPositions, ancientBase)) {
+                            if (hashValAncient % 3000 < 1 && !treeCollision(chunk, BLOCK_ANCIENT_TRUNK, ancientBase)) {
                                 int trunkHeightAncient = 30, trunkThicknessAncient = 3;
                                 for (int i = 1; i <= trunkHeightAncient; i++) {
                                     for (int tx = 0; tx < trunkThicknessAncient; tx++) {
                                         for (int tz = 0; tz < trunkThicknessAncient; tz++) {
-                                            chunk.ancientTrunkPositions.push_back(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz));
+                                            chunk.place(glm::vec3(worldX + tx, groundHeight + i, worldZ + tz), BLOCK_ANCIENT_TRUNK);
                                         }
                                     }
                                 }
@@ -1090,29 +2361,32 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                                         for (int dz = -static_cast<int>(canopyRadius); dz <= static_cast<int>(canopyRadius); dz++) {
                                             float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
                                             if (dist < canopyRadius)
-                                                chunk.ancientLeafPositions.push_back(glm::vec3(worldX + trunkThicknessAncient / 2.0f + dx, centerY + dy, worldZ + trunkThicknessAncient / 2.0f + dz));
+                                                chunk.place(glm::vec3(worldX + trunkThicknessAncient / 2.0f + dx, centerY + dy, worldZ + trunkThicknessAncient / 2.0f + dz), BLOCK_ANCIENT_LEAF);
                                         }
                                     }
                                 }
                                 int branchBaseHeights[4] = { 7, 13, 19, 25 };
                                 for (int b = 0; b < 4; b++) {
-                                    int randomOffset = (rand() % 3) - 1;
+                                    // Jitter from the tree's position, so a chunk comes out the same
+                                    // whichever worker generates it and in whatever order.
+                                    int hashValBranch = std::abs((intWorldX * 19349663) ^ (intWorldZ * 83492791) ^ (b * 73856093));
+                                    int randomOffset = (hashValBranch % 3) - 1;
                                     int branchStart = branchBaseHeights[b] + randomOffset;
                                     float branchRot = (b * 90.0f) * (3.14159f / 180.0f);
                                     glm::vec3 branchStartPos = glm::vec3(worldX + trunkThicknessAncient / 2.0f, groundHeight + branchStart, worldZ + trunkThicknessAncient / 2.0f);
-                                    int branchLength = 10 + (rand() % 3);
+                                    int branchLength = 10 + ((hashValBranch / 3) % 3);
                                     for (int i = 1; i <= branchLength; i++) {
                                         float bx = cos(branchRot) * i;
                                         float bz = sin(branchRot) * i;
                                         glm::vec3 branchBlockPos = branchStartPos + glm::vec3(bx, 0, bz);
-                                        chunk.ancientBranchPositions.push_back(branchBlockPos);
+                                        chunk.place(branchBlockPos, BLOCK_ANCIENT_BRANCH);
                                     }
                                     glm::vec3 tip = branchStartPos + glm::vec3(cos(branchRot) * (branchLength + 1), 0, sin(branchRot) * (branchLength + 1));
                                     for (int dx = -1; dx <= 1; dx++) {
                                         for (int dy = -1; dy <= 1; dy++) {
                                             for (int dz = -1; dz <= 1; dz++) {
                                                 if (glm::length(glm::vec3(dx, dy, dz)) < 1.5f)
-                                                    chunk.ancientLeafPositions.push_back(tip + glm::vec3(dx, dy, dz));
+                                                    chunk.place(tip + glm::vec3(dx, dy, dz), BLOCK_ANCIENT_LEAF);
                                             }
                                         }
                                     }
@@ -1124,8 +2398,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                     bool nearWater = false;
                     for (int dx = -1; dx <= 1; dx++) {
                         for (int dz = -1; dz <= 1; dz++) {
-                            TerrainPoint neighbor = getTerrainHeight(worldX + dx, worldZ + dz);
-                            if (!neighbor.isLand) { nearWater = true; break; }
+                            if (!terrainAt(x + dx, z + dz).isLand) { nearWater = true; break; }
                         }
                         if (nearWater) break;
                     }
@@ -1157,7 +2430,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                                     for (int tz = 0; tz < thickness; tz++) {
                                         float localX = posX + tx - thickness / 2.0f;
                                         float localZ = posZ + tz - thickness / 2.0f;
-                                        chunk.fallenTreeTrunkPositions.push_back(glm::vec3(localX, groundHeight + 1, worldZ + tz));
+                                        chunk.place(glm::vec3(localX, groundHeight + 1, worldZ + tz), BLOCK_FALLEN_TRUNK);
                                     }
                                 }
                             }
@@ -1171,7 +2444,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             int pz = (hashValPile + i * 7) % 3 - 1;
                             float placeX = worldX + px;
                             float placeZ = worldZ + pz;
-                            chunk.leafPilePositions.push_back(glm::vec3(placeX, groundHeight + 1, worldZ + pz));
+                            chunk.place(glm::vec3(placeX, groundHeight + 1, worldZ + pz), BLOCK_LEAF_PILE);
                         }
                     }
                     {
@@ -1182,7 +2455,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             for (int dx = -1; dx <= 1; dx++) {
                                 for (int dz = -1; dz <= 1; dz++) {
                                     if (glm::length(glm::vec2(dx, dz)) <= radius)
-                                        chunk.bushSmallPositions.push_back(glm::vec3(worldX + dx, centerY, worldZ + dz));
+                                        chunk.place(glm::vec3(worldX + dx, centerY, worldZ + dz), BLOCK_BUSH_SMALL);
                                 }
                             }
                         }
@@ -1193,7 +2466,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             for (int dx = -2; dx <= 2; dx++) {
                                 for (int dz = -2; dz <= 2; dz++) {
                                     if (glm::length(glm::vec2(dx, dz)) <= radius)
-                                        chunk.bushMediumPositions.push_back(glm::vec3(worldX + dx, centerY, worldZ + dz));
+                                        chunk.place(glm::vec3(worldX + dx, centerY, worldZ + dz), BLOCK_BUSH_MEDIUM);
                                 }
                             }
                         }
@@ -1204,7 +2477,7 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                             for (int dx = -3; dx <= 3; dx++) {
                                 for (int dz = -3; dz <= 3; dz++) {
                                     if (glm::length(glm::vec2(dx, dz)) <= radius)
-                                        chunk.bushLargePositions.push_back(glm::vec3(worldX + dx, centerY, worldZ + dz));
+                                        chunk.place(glm::vec3(worldX + dx, centerY, worldZ + dz), BLOCK_BUSH_LARGE);
                                 }
                             }
                         }
@@ -1213,60 +2486,1314 @@ void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
                         int hashValBranch = std::abs((intWorldX * 12345) ^ (intWorldZ * 6789));
                         if (hashValBranch % 1000 < 1) {
                             float rot = (hashValBranch % 360) * (3.14159f / 180.0f);
-                            chunk.branchPositions.push_back(glm::vec4(worldX + 0.5f, groundHeight + 0.5f, worldZ + 0.5f, rot));
+                            chunk.branches.push_back(glm::vec4(worldX + 0.5f, groundHeight + 0.5f, worldZ + 0.5f, rot));
                         }
                     }
                 }
             }
         }
     }
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int z = 0; z < CHUNK_SIZE; z++) {
-            double worldX = chunkX * CHUNK_SIZE + x;
-            double worldZ = chunkZ * CHUNK_SIZE + z;
-            for (int y = 165; y <= 166; y++) {
-                double n = auroraNoise.noise(worldX * 0.1, y * 0.1, worldZ * 0.1);
-                if (n > 0.44)
-                    chunk.auroraPositions.push_back(glm::vec3(worldX, y, worldZ));
-            }
+    const int AURORA_LAYERS = 2;
+    float aurora[CHUNK_SIZE * CHUNK_SIZE * AURORA_LAYERS];
+    auroraNoise.noiseBlock(originX, 165, originZ, 0.1, CHUNK_SIZE, AURORA_LAYERS, CHUNK_SIZE, aurora);
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            double worldX = originX + x;
+            double worldZ = originZ + z;
+            for (int y = 165; y <= 166; y++) {
+                double n = aurora[((y - 165) * CHUNK_SIZE + x) * CHUNK_SIZE + z];
+                if (n > 0.44)
+                    chunk.place(glm::vec3(worldX, y, worldZ), BLOCK_AURORA);
+            }
+        }
+    }
+    chunk.finish(target);
+    target.generated = true;
+    target.needsMeshUpdate = true;
+    target.needsSave = true;
+}
+
+// ---------------------- Region Files ----------------------
+// Chunks are persisted in region files of 32x32 chunks under WORLD_DIRECTORY.
+// A file starts with a magic/version word pair and a 1024-entry offset table
+// (byte offset and size per chunk, 0 = not stored), followed by the chunk
+// payloads: the uncompressed size, then the RLE-compressed serialized chunk.
+// Reads go through a read-only memory mapping of the file; writes reuse a
+// chunk's old slot when the new payload fits and append otherwise.
+const char* WORLD_DIRECTORY = "world";
+const int REGION_SIZE = 32;
+const int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+const uint32_t REGION_MAGIC = 0x4E475250; // "PRGN"
+const uint32_t REGION_VERSION = 2;
+const size_t REGION_HEADER_BYTES = 2 * sizeof(uint32_t) + REGION_CHUNKS * 2 * sizeof(uint32_t);
+const size_t OPEN_REGION_FILES = 16;
+
+// PackBits-style RLE: a control byte c < 128 is followed by c + 1 literal
+// bytes, c >= 128 repeats the next byte c - 125 times (3..130).
+void rleCompress(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0, n = in.size();
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && in[i + run] == in[i])
+            run++;
+        if (run >= 3) {
+            out.push_back(static_cast<uint8_t>(run + 125));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i, count = 0;
+        while (i < n && count < 128) {
+            if (i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2])
+                break;
+            i++;
+            count++;
+        }
+        out.push_back(static_cast<uint8_t>(count - 1));
+        out.insert(out.end(), in.begin() + start, in.begin() + start + count);
+    }
+}
+
+bool rleDecompress(const uint8_t* in, size_t size, size_t expected, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(expected);
+    size_t i = 0;
+    while (i < size) {
+        uint8_t c = in[i++];
+        if (c < 128) {
+            size_t count = c + 1u;
+            if (i + count > size)
+                return false;
+            out.insert(out.end(), in + i, in + i + count);
+            i += count;
+        }
+        else {
+            if (i >= size)
+                return false;
+            out.insert(out.end(), static_cast<size_t>(c - 125), in[i++]);
+        }
+    }
+    return out.size() == expected;
+}
+
+// Raw chunk layout: section count, then per section bits/palette/block count
+// and packed words, then the overflow entries and branch decorations. The
+// palette size is 16 bits wide because an 8-bit section can hold 256 entries.
+void serializeChunk(const Chunk& chunk, std::vector<uint8_t>& out) {
+    out.clear();
+    auto put = [&](const void* data, size_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), p, p + bytes);
+    };
+    uint16_t sectionCount = static_cast<uint16_t>(chunk.sections.size());
+    put(&sectionCount, sizeof(sectionCount));
+    for (const ChunkSection& section : chunk.sections) {
+        uint16_t paletteSize = static_cast<uint16_t>(section.palette.size());
+        put(&section.bitsPerBlock, 1);
+        put(&paletteSize, sizeof(paletteSize));
+        put(&section.blockCount, sizeof(section.blockCount));
+        put(section.palette.data(), section.palette.size());
+        put(section.data.data(), section.data.size() * sizeof(uint64_t));
+    }
+    uint32_t overflowCount = static_cast<uint32_t>(chunk.overflow.size());
+    put(&overflowCount, sizeof(overflowCount));
+    put(chunk.overflow.data(), chunk.overflow.size() * sizeof(uint64_t));
+    uint32_t branchCount = static_cast<uint32_t>(chunk.branchPositions.size());
+    put(&branchCount, sizeof(branchCount));
+    put(chunk.branchPositions.data(), chunk.branchPositions.size() * sizeof(glm::vec4));
+}
+
+bool deserializeChunk(const std::vector<uint8_t>& in, Chunk& chunk) {
+    size_t pos = 0;
+    auto get = [&](void* data, size_t bytes) {
+        if (pos + bytes > in.size())
+            return false;
+        if (bytes)
+            std::memcpy(data, in.data() + pos, bytes);
+        pos += bytes;
+        return true;
+    };
+    chunk.clearBlocks();
+    uint16_t sectionCount;
+    if (!get(&sectionCount, sizeof(sectionCount)) || sectionCount > SECTION_COUNT)
+        return false;
+    chunk.sections.resize(sectionCount);
+    for (ChunkSection& section : chunk.sections) {
+        uint16_t paletteSize;
+        if (!get(&section.bitsPerBlock, 1) || !get(&paletteSize, sizeof(paletteSize)) || !get(&section.blockCount, sizeof(section.blockCount)))
+            return false;
+        uint8_t bits = section.bitsPerBlock;
+        if ((bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8) || paletteSize == 0 || paletteSize > (1u << bits))
+            return false;
+        section.palette.resize(paletteSize);
+        section.data.assign(bits ? SECTION_VOLUME / (64 / bits) : 0, 0);
+        if (!get(section.palette.data(), paletteSize) || !get(section.data.data(), section.data.size() * sizeof(uint64_t)))
+            return false;
+        // A full palette covers every index the bit width can encode;
+        // otherwise each packed index has to be checked before get() uses it.
+        if (paletteSize < (1u << bits)) {
+            uint64_t mask = (1ull << bits) - 1;
+            for (uint64_t word : section.data)
+                for (int shift = 0; shift < 64; shift += bits)
+                    if (((word >> shift) & mask) >= paletteSize)
+                        return false;
+        }
+    }
+    uint32_t overflowCount, branchCount;
+    if (!get(&overflowCount, sizeof(overflowCount)) || overflowCount > in.size())
+        return false;
+    chunk.overflow.resize(overflowCount);
+    if (!get(chunk.overflow.data(), overflowCount * sizeof(uint64_t)) || !get(&branchCount, sizeof(branchCount)) || branchCount > in.size())
+        return false;
+    chunk.branchPositions.resize(branchCount);
+    return get(chunk.branchPositions.data(), branchCount * sizeof(glm::vec4)) && pos == in.size();
+}
+
+// One open region file: its offset table plus a read-only mapping, which is
+// dropped before every write and re-created on the next read.
+struct RegionFile {
+    std::string path;
+    uint32_t table[REGION_CHUNKS * 2];
+    uint64_t fileSize;
+    const uint8_t* view;
+    size_t viewSize;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    RegionFile() : fileSize(0), view(nullptr), viewSize(0) {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        fd = -1;
+#endif
+        std::fill(table, table + REGION_CHUNKS * 2, 0u);
+    }
+    ~RegionFile() { unmap(); }
+
+    bool map() {
+        if (view)
+            return true;
+        if (fileSize == 0)
+            return false;
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+            view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        void* p = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        view = (p == MAP_FAILED) ? nullptr : static_cast<const uint8_t*>(p);
+#endif
+        if (!view) {
+            unmap();
+            return false;
+        }
+        viewSize = static_cast<size_t>(fileSize);
+        return true;
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (view) munmap(const_cast<uint8_t*>(view), viewSize);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        view = nullptr;
+        viewSize = 0;
+    }
+};
+
+class RegionStore {
+public:
+    explicit RegionStore(const std::string& directory) : directory(directory), openFiles(OPEN_REGION_FILES) {}
+
+    // Copies the stored payload of a chunk out of the mapped region file.
+    bool read(int chunkX, int chunkZ, std::vector<uint8_t>& payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<RegionFile> region = openRegion(chunkX, chunkZ, false);
+        if (!region)
+            return false;
+        int slot = regionSlot(chunkX, chunkZ);
+        uint32_t offset = region->table[slot * 2], size = region->table[slot * 2 + 1];
+        if (offset == 0 || !region->map() || static_cast<size_t>(offset) + size > region->viewSize)
+            return false;
+        payload.assign(region->view + offset, region->view + offset + size);
+        return true;
+    }
+
+    bool write(int chunkX, int chunkZ, const std::vector<uint8_t>& payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<RegionFile> region = openRegion(chunkX, chunkZ, true);
+        if (!region)
+            return false;
+        region->unmap();
+        FILE* f = std::fopen(region->path.c_str(), "r+b");
+        if (!f)
+            return false;
+        int slot = regionSlot(chunkX, chunkZ);
+        uint32_t offset = region->table[slot * 2];
+        uint32_t size = static_cast<uint32_t>(payload.size());
+        if (offset == 0 || size > region->table[slot * 2 + 1])
+            offset = static_cast<uint32_t>(region->fileSize);
+        bool ok = std::fseek(f, offset, SEEK_SET) == 0 &&
+                  std::fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+        if (ok) {
+            region->table[slot * 2] = offset;
+            region->table[slot * 2 + 1] = size;
+            ok = std::fseek(f, static_cast<long>(2 * sizeof(uint32_t) + slot * 2 * sizeof(uint32_t)), SEEK_SET) == 0 &&
+                 std::fwrite(&region->table[slot * 2], sizeof(uint32_t), 2, f) == 2;
+            region->fileSize = std::max<uint64_t>(region->fileSize, static_cast<uint64_t>(offset) + size);
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+    void closeAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        openFiles.clear();
+    }
+
+private:
+    std::string directory;
+    std::mutex mutex;
+    LruCache<ChunkPos, std::shared_ptr<RegionFile>> openFiles;
+
+    static int regionSlot(int chunkX, int chunkZ) {
+        return (chunkZ - floorDiv(chunkZ, REGION_SIZE) * REGION_SIZE) * REGION_SIZE +
+               (chunkX - floorDiv(chunkX, REGION_SIZE) * REGION_SIZE);
+    }
+
+    std::shared_ptr<RegionFile> openRegion(int chunkX, int chunkZ, bool create) {
+        ChunkPos key(floorDiv(chunkX, REGION_SIZE), floorDiv(chunkZ, REGION_SIZE));
+        if (const std::shared_ptr<RegionFile>* open = openFiles.find(key))
+            return *open;
+        auto region = std::make_shared<RegionFile>();
+        region->path = directory + "/r." + std::to_string(key.x) + "." + std::to_string(key.z) + ".prr";
+        bool valid = false;
+        if (FILE* f = std::fopen(region->path.c_str(), "rb")) {
+            uint32_t header[2] = { 0, 0 };
+            valid = std::fread(header, sizeof(uint32_t), 2, f) == 2 && header[0] == REGION_MAGIC && header[1] == REGION_VERSION &&
+                    std::fread(region->table, sizeof(uint32_t), REGION_CHUNKS * 2, f) == REGION_CHUNKS * 2;
+            std::fseek(f, 0, SEEK_END);
+            region->fileSize = static_cast<uint64_t>(std::ftell(f));
+            std::fclose(f);
+            if (!valid) {
+                std::cout << "Ignoring unreadable region file " << region->path << "\n";
+                std::fill(region->table, region->table + REGION_CHUNKS * 2, 0u);
+            }
+        }
+        if (!valid) {
+            if (!create)
+                return nullptr;
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+            FILE* f = std::fopen(region->path.c_str(), "wb");
+            if (!f) {
+                std::cout << "Could not create region file " << region->path << "\n";
+                return nullptr;
+            }
+            uint32_t header[2] = { REGION_MAGIC, REGION_VERSION };
+            std::fwrite(header, sizeof(uint32_t), 2, f);
+            std::fwrite(region->table, sizeof(uint32_t), REGION_CHUNKS * 2, f);
+            std::fclose(f);
+            region->fileSize = REGION_HEADER_BYTES;
+        }
+        openFiles.put(key, region);
+        return region;
+    }
+};
+
+RegionStore regionStore(WORLD_DIRECTORY);
+
+void encodeChunk(const Chunk& chunk, std::vector<uint8_t>& payload) {
+    static thread_local std::vector<uint8_t> raw, packed;
+    serializeChunk(chunk, raw);
+    rleCompress(raw, packed);
+    uint32_t rawSize = static_cast<uint32_t>(raw.size());
+    payload.resize(sizeof(rawSize));
+    std::memcpy(payload.data(), &rawSize, sizeof(rawSize));
+    payload.insert(payload.end(), packed.begin(), packed.end());
+}
+
+bool decodeChunk(const std::vector<uint8_t>& payload, Chunk& chunk) {
+    static thread_local std::vector<uint8_t> raw;
+    uint32_t rawSize;
+    if (payload.size() < sizeof(rawSize))
+        return false;
+    std::memcpy(&rawSize, payload.data(), sizeof(rawSize));
+    return rleDecompress(payload.data() + sizeof(rawSize), payload.size() - sizeof(rawSize), rawSize, raw) &&
+           deserializeChunk(raw, chunk);
+}
+
+bool saveChunk(RegionStore& store, Chunk& chunk) {
+    static thread_local std::vector<uint8_t> payload;
+    encodeChunk(chunk, payload);
+    if (!store.write(chunk.chunkX, chunk.chunkZ, payload))
+        return false;
+    chunk.needsSave = false;
+    return true;
+}
+
+// Fills the chunk from its region file; false if it was never saved (or the
+// stored copy is unreadable), in which case the caller generates it.
+bool loadChunk(RegionStore& store, Chunk& chunk, int chunkX, int chunkZ) {
+    static thread_local std::vector<uint8_t> payload;
+    if (!store.read(chunkX, chunkZ, payload))
+        return false;
+    chunk.chunkX = chunkX;
+    chunk.chunkZ = chunkZ;
+    if (!decodeChunk(payload, chunk)) {
+        std::cout << "Regenerating corrupt chunk (" << chunkX << ", " << chunkZ << ")\n";
+        chunk.clearBlocks();
+        return false;
+    }
+    chunk.generated = true;
+    chunk.needsMeshUpdate = true;
+    chunk.needsSave = false;
+    return true;
+}
+
+// Generation entry point for both the main thread and the workers: the saved
+// copy wins, noise generation only runs for chunks never stored before.
+// Reads the chunk from its region file, or generates it. Benchmarks always
+// generate, so every run does the same work.
+void loadOrGenerateChunk(Chunk& chunk, int chunkX, int chunkZ) {
+    if (!benchmarkMode && loadChunk(regionStore, chunk, chunkX, chunkZ))
+        return;
+    auto start = std::chrono::steady_clock::now();
+    generateChunkBlocks(chunk, chunkX, chunkZ);
+    recordBenchSample(benchRecorder.generateMs, start);
+}
+
+// Player edit of one world cell. Removing a block may hit a neighbour's
+// spill-over (e.g. a canopy reaching across the border), so that chunk is the
+// one changed. Edited chunks are remeshed and written through immediately.
+bool setBlockAt(int x, int y, int z, uint8_t type) {
+    int cx = floorDiv(x, CHUNK_SIZE);
+    int cz = floorDiv(z, CHUNK_SIZE);
+    auto it = chunks.find(ChunkPos(cx, cz));
+    if (it == chunks.end() || !it->second.generated || y < CHUNK_MIN_Y || y >= CHUNK_MAX_Y)
+        return false;
+    Chunk* edited = &it->second;
+    if (type == BLOCK_AIR && edited->getLocal(x - cx * CHUNK_SIZE, y, z - cz * CHUNK_SIZE) == BLOCK_AIR) {
+        uint64_t key = packBlockKey(x, y, z);
+        edited = nullptr;
+        for (int dx = -1; dx <= 1 && !edited; dx++) {
+            for (int dz = -1; dz <= 1 && !edited; dz++) {
+                auto n = chunks.find(ChunkPos(cx + dx, cz + dz));
+                if (n != chunks.end() && n->second.getOverflow(key) != BLOCK_AIR) {
+                    edited = &n->second;
+                    edited->setOverflow(key, BLOCK_AIR);
+                }
+            }
+        }
+        if (!edited)
+            return false;
+    }
+    else
+        edited->setWorld(x, y, z, type);
+    edited->needsMeshUpdate = true;
+    edited->needsSave = true;
+    saveChunk(regionStore, *edited);
+    return true;
+}
+
+// ---------------------- Chunk Mesh Generation ----------------------
+void generateChunkMesh(Chunk& chunk, int chunkX, int chunkZ) {
+    if (!chunk.generated) {
+        loadOrGenerateChunk(chunk, chunkX, chunkZ);
+        if (visitedChunks.insert(ChunkPos(chunkX, chunkZ)).second)
+            mapDirtyChunks.push_back(ChunkPos(chunkX, chunkZ));
+    }
+    if (chunk.needsMeshUpdate)
+        buildChunkMesh(chunk);
+}
+
+
+// ---------------------- Background Chunk Generation ----------------------
+// Worker threads generate and mesh chunks off the main thread. The main thread
+// keeps the queue ordered (nearest and in-view first), collects finished
+// chunks in updateChunks() and uploads a bounded number of them per frame.
+const int CHUNK_UPLOADS_PER_FRAME = 8;
+
+struct ChunkJob {
+    ChunkPos pos;
+    float priority; // lower is generated sooner
+};
+
+struct ChunkWorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;                   // signalled after each completed job
+    std::vector<ChunkJob> pending;                      // sorted, best job at the back
+    std::unordered_set<ChunkPos> inFlight;              // taken by a worker, not yet collected
+    std::vector<std::pair<ChunkPos, Chunk>> completed;  // finished, waiting for the main thread
+    bool stopping;
+    ChunkWorkerPool() : stopping(false) {}
+
+    void start() {
+        int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        for (int i = 0; i < count; i++)
+            threads.emplace_back(&ChunkWorkerPool::workerLoop, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads)
+            t.join();
+        threads.clear();
+    }
+
+    // Blocks until every queued job has been completed (benchmark mode only).
+    void waitUntilIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return pending.empty() && inFlight.size() == completed.size(); });
+    }
+
+    void workerLoop() {
+        for (;;) {
+            ChunkJob job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (stopping)
+                    return;
+                job = pending.back();
+                pending.pop_back();
+                inFlight.insert(job.pos);
+            }
+            Chunk chunk;
+            loadOrGenerateChunk(chunk, job.pos.x, job.pos.z);
+            buildChunkMesh(chunk);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                completed.emplace_back(job.pos, std::move(chunk));
+            }
+            finished.notify_all();
+        }
+    }
+};
+
+ChunkWorkerPool chunkWorkers;
+std::vector<Plane> chunkPriorityFrustum; // last frame's view frustum
+
+// ---------------------- Chunk Update ----------------------
+// Moves finished worker chunks that are still in range into chunks. Benchmarks
+// insert them in position order, so the map does not depend on worker timing.
+void collectFinishedChunks(int playerChunkX, int playerChunkZ, int renderDistanceSquared) {
+    std::vector<std::pair<ChunkPos, Chunk>> finished;
+    {
+        std::lock_guard<std::mutex> lock(chunkWorkers.mutex);
+        finished.swap(chunkWorkers.completed);
+        for (const auto& entry : finished)
+            chunkWorkers.inFlight.erase(entry.first);
+    }
+    if (benchmarkMode)
+        std::sort(finished.begin(), finished.end(), [](const auto& a, const auto& b) {
+            return a.first.x != b.first.x ? a.first.x < b.first.x : a.first.z < b.first.z;
+            });
+    for (auto& entry : finished) {
+        int dx = entry.first.x - playerChunkX;
+        int dz = entry.first.z - playerChunkZ;
+        if (dx * dx + dz * dz > renderDistanceSquared || chunks.find(entry.first) != chunks.end())
+            continue;
+        chunks[entry.first] = std::move(entry.second);
+        if (visitedChunks.insert(entry.first).second)
+            mapDirtyChunks.push_back(entry.first);
+    }
+}
+
+void updateChunks() {
+    int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
+    int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
+    int renderDistance = static_cast<int>(RENDER_DISTANCE);
+    int renderDistanceSquared = renderDistance * renderDistance;
+
+    if (chunkWorkers.threads.empty())
+        chunkWorkers.start();
+
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        int dx = it->first.x - playerChunkX;
+        int dz = it->first.z - playerChunkZ;
+        if (dx * dx + dz * dz > renderDistanceSquared) {
+            if (it->second.needsSave && !benchmarkMode)
+                saveChunk(regionStore, it->second);
+            releaseChunkBuffers(it->second);
+            it = chunks.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    collectFinishedChunks(playerChunkX, playerChunkZ, renderDistanceSquared);
+
+    // The chunks around the player are needed for collision right away.
+    for (int x = playerChunkX - 1; x <= playerChunkX + 1; x++) {
+        for (int z = playerChunkZ - 1; z <= playerChunkZ + 1; z++) {
+            ChunkPos pos{ x, z };
+            if (chunks.find(pos) == chunks.end())
+                chunks[pos] = Chunk();
+            generateChunkMesh(chunks[pos], x, z);
+        }
+    }
+
+    // Rebuild the work queue: nearest first, chunks inside the view frustum ahead of the rest.
+    std::vector<ChunkJob> jobs;
+    for (int x = playerChunkX - renderDistance; x <= playerChunkX + renderDistance; x++) {
+        for (int z = playerChunkZ - renderDistance; z <= playerChunkZ + renderDistance; z++) {
+            int dx = x - playerChunkX;
+            int dz = z - playerChunkZ;
+            if (dx * dx + dz * dz <= renderDistanceSquared) {
+                ChunkPos pos{ x, z };
+                auto it = chunks.find(pos);
+                if (it != chunks.end()) {
+                    generateChunkMesh(it->second, x, z);
+                    continue;
+                }
+                float priority = static_cast<float>(dx * dx + dz * dz);
+                glm::vec3 boxMin(x * CHUNK_SIZE, MIN_Y, z * CHUNK_SIZE);
+                glm::vec3 boxMax((x + 1) * CHUNK_SIZE, 150.0f, (z + 1) * CHUNK_SIZE);
+                if (!chunkPriorityFrustum.empty() && !aabbInFrustum(chunkPriorityFrustum, boxMin, boxMax))
+                    priority += renderDistanceSquared;
+                jobs.push_back({ pos, priority });
+            }
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(), [](const ChunkJob& a, const ChunkJob& b) { return a.priority > b.priority; });
+    {
+        std::lock_guard<std::mutex> lock(chunkWorkers.mutex);
+        jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const ChunkJob& job) {
+            return chunkWorkers.inFlight.count(job.pos) != 0;
+            }), jobs.end());
+        chunkWorkers.pending.swap(jobs);
+    }
+    chunkWorkers.wake.notify_all();
+
+    // Benchmarks stream the whole render distance every frame, so the chunk
+    // set a frame culls and draws is the same on every run and machine.
+    if (benchmarkMode) {
+        chunkWorkers.waitUntilIdle();
+        collectFinishedChunks(playerChunkX, playerChunkZ, renderDistanceSquared);
+    }
+}
+
+// ---------------------- Frame Visibility ----------------------
+// The chunks to draw this frame: those in the view frustum whose meshes are on
+// the GPU, with their visible sections walked from the eye. Freshly meshed
+// chunks are uploaded nearest first, a few per frame; the rest wait (and are
+// not drawn) until a later frame has budget for them. Without a GL context
+// (gpuUpload false) an upload only drops the CPU copies.
+std::vector<Chunk*> prepareVisibleChunks(const glm::mat4& viewProjection, const glm::vec3& eye, bool gpuUpload) {
+    int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
+    int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
+    int qtMinX = playerChunkX - static_cast<int>(RENDER_DISTANCE);
+    int qtMaxX = playerChunkX + static_cast<int>(RENDER_DISTANCE);
+    int qtMinZ = playerChunkZ - static_cast<int>(RENDER_DISTANCE);
+    int qtMaxZ = playerChunkZ + static_cast<int>(RENDER_DISTANCE);
+    Quadtree qt(qtMinX, qtMinZ, qtMaxX, qtMaxZ);
+    for (auto& entry : chunks) {
+        const ChunkPos& pos = entry.first;
+        if (pos.x >= qtMinX && pos.x <= qtMaxX && pos.z >= qtMinZ && pos.z <= qtMaxZ)
+            qt.insert(pos, &entry.second);
+    }
+    chunkPriorityFrustum = extractFrustumPlanes(viewProjection);
+    std::vector<Chunk*> visibleChunks = qt.query(chunkPriorityFrustum);
+
+    auto distanceToPlayer = [&](const Chunk* chunk) {
+        int dx = chunk->chunkX - playerChunkX;
+        int dz = chunk->chunkZ - playerChunkZ;
+        return dx * dx + dz * dz;
+    };
+    std::vector<Chunk*> uploads;
+    for (Chunk* chunk : visibleChunks)
+        if (chunk->needsUpload)
+            uploads.push_back(chunk);
+    std::sort(uploads.begin(), uploads.end(), [&](const Chunk* a, const Chunk* b) {
+        int da = distanceToPlayer(a), db = distanceToPlayer(b);
+        if (da != db)
+            return da < db;
+        return a->chunkX != b->chunkX ? a->chunkX < b->chunkX : a->chunkZ < b->chunkZ;
+        });
+    for (size_t i = 0; i < uploads.size() && i < static_cast<size_t>(CHUNK_UPLOADS_PER_FRAME); i++) {
+        if (gpuUpload) {
+            uploadChunkMesh(*uploads[i]);
+            continue;
+        }
+        std::vector<glm::vec4>().swap(uploads[i]->instanceData);
+        std::vector<uint32_t>().swap(uploads[i]->meshData);
+        uploads[i]->needsUpload = false;
+    }
+    visibleChunks.erase(std::remove_if(visibleChunks.begin(), visibleChunks.end(), [](const Chunk* chunk) {
+        return chunk->needsUpload;
+        }), visibleChunks.end());
+    walkVisibleSections(visibleChunks, eye);
+    return visibleChunks;
+}
+
+// ---------------------- Distant Terrain LOD ----------------------
+// Past the loaded chunks the terrain is drawn from heightmap meshes sampled
+// straight from the terrain noise, without trees, caves or block storage.
+// Tiles are LOD_TILE_CHUNKS chunks wide; level l merges (2 << l) columns per
+// cell and is used out to LOD_RANGE_CHUNKS[l]. Towards the end of its range a
+// level morphs its vertices onto the next level's surface, so a tile switching
+// level does not pop; skirts cover the cracks left where levels meet. Chunks
+// drawn in full detail are masked out per fragment (lodChunkMask).
+const int LOD_TILE_CHUNKS = 8;
+const int LOD_TILE_SIZE = LOD_TILE_CHUNKS * CHUNK_SIZE;
+const int LOD_LEVELS = 3;
+const int LOD_RANGE_CHUNKS[LOD_LEVELS] = { 36, 54, 72 };
+// A level only starts morphing a tile diagonal past the previous level's
+// range, so the edges it shares with the finer level never move.
+const int LOD_MORPH_START_CHUNKS[LOD_LEVELS] = { 30, 48, 72 };
+const int LOD_MASK_CHUNKS = 64;          // full-detail mask window, centred on the player
+const double LOD_BUILD_BUDGET_MS = 1.0;  // tile meshing per frame
+const int LOD_BENCH_TILES_PER_FRAME = 4; // replaces the time budget under --bench
+
+// Position at this level, with the next level's height at the same x/z in w.
+struct LodVertex {
+    float x, y, z, coarseY;
+    float nx, ny, nz;
+    float type;
+};
+
+struct LodTile {
+    GLuint buffer[LOD_LEVELS];
+    float minY[LOD_LEVELS], maxY[LOD_LEVELS];
+    LodTile() {
+        for (int l = 0; l < LOD_LEVELS; l++) {
+            buffer[l] = 0;
+            minY[l] = maxY[l] = 0.0f;
+        }
+    }
+};
+
+std::unordered_map<ChunkPos, LodTile> lodTiles; // keyed by tile coordinates
+GLuint lodVAO = 0;
+GLuint lodIndexBuffers[LOD_LEVELS] = {};
+GLsizei lodIndexCounts[LOD_LEVELS] = {};
+GLuint lodChunkMask = 0;
+bool lodEnabled = true;
+int lastFrameLodTiles = 0;
+int lastFrameLodTriangles = 0;
+
+inline int lodCellsPerSide(int level) { return LOD_TILE_SIZE / (2 << level); }
+
+// Grid of (n + 1)^2 vertices, x-major, then four skirts of n + 1 vertices
+// (z = 0, z = n, x = 0, x = n edges). Every cell is split along the same
+// diagonal, so each level refines the triangles of the next.
+void buildLodIndices(int level) {
+    const int n = lodCellsPerSide(level);
+    const uint32_t side = n + 1;
+    const uint32_t skirtBase = side * side;
+    std::vector<uint32_t> indices;
+    indices.reserve(n * n * 6 + 4 * n * 6);
+    for (int i = 0; i < n; i++)
+        for (int k = 0; k < n; k++) {
+            uint32_t v00 = i * side + k, v10 = v00 + side, v01 = v00 + 1, v11 = v10 + 1;
+            uint32_t cell[6] = { v00, v10, v11, v00, v11, v01 };
+            indices.insert(indices.end(), cell, cell + 6);
+        }
+    auto edgeVertex = [&](int edge, int t) -> uint32_t {
+        switch (edge) {
+        case 0: return t * side;
+        case 1: return t * side + n;
+        case 2: return t;
+        default: return n * side + t;
+        }
+    };
+    for (int edge = 0; edge < 4; edge++)
+        for (int t = 0; t < n; t++) {
+            uint32_t a = edgeVertex(edge, t), b = edgeVertex(edge, t + 1);
+            uint32_t sa = skirtBase + edge * side + t, sb = sa + 1;
+            uint32_t quad[6] = { a, b, sb, a, sb, sa };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lodIndexBuffers[level]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    lodIndexCounts[level] = static_cast<GLsizei>(indices.size());
+}
+
+void initLodTerrain() {
+    glGenVertexArrays(1, &lodVAO);
+    glGenBuffers(LOD_LEVELS, lodIndexBuffers);
+    glBindVertexArray(lodVAO);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    for (int l = 0; l < LOD_LEVELS; l++)
+        buildLodIndices(l);
+    glBindVertexArray(0);
+    glGenTextures(1, &lodChunkMask);
+    glBindTexture(GL_TEXTURE_2D, lodChunkMask);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, LOD_MASK_CHUNKS, LOD_MASK_CHUNKS, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void releaseLodTile(LodTile& tile) {
+    for (int l = 0; l < LOD_LEVELS; l++)
+        if (tile.buffer[l] != 0) {
+            glDeleteBuffers(1, &tile.buffer[l]);
+            tile.buffer[l] = 0;
+        }
+}
+
+void destroyLodTerrain() {
+    for (auto& entry : lodTiles)
+        releaseLodTile(entry.second);
+    lodTiles.clear();
+    glDeleteBuffers(LOD_LEVELS, lodIndexBuffers);
+    glDeleteVertexArrays(1, &lodVAO);
+    glDeleteTextures(1, &lodChunkMask);
+}
+
+// Samples one tile at the given level into `vertices` (layout as in
+// buildLodIndices) and returns its height range in minY/maxY. Heights are the
+// tops of the columns generateChunkBlocks would place; the sample grid has a
+// one-cell apron for the normals.
+void meshLodTile(int tileX, int tileZ, int level, std::vector<LodVertex>& vertices, float& minY, float& maxY) {
+    const int step = 2 << level;
+    const int n = lodCellsPerSide(level);
+    const int side = n + 1, grid = n + 3;
+    const int x0 = tileX * LOD_TILE_SIZE, z0 = tileZ * LOD_TILE_SIZE;
+    static std::vector<TerrainPoint> samples;
+    static std::vector<float> height;
+    samples.resize(grid * grid);
+    height.resize(grid * grid);
+    getTerrainHeightGrid(x0 - step, z0 - step, grid, samples.data(), step);
+    for (int i = 0; i < grid * grid; i++)
+        height[i] = samples[i].isLand ? static_cast<float>(std::floor(samples[i].height)) + 0.5f : 0.5f;
+    auto h = [&](int i, int k) { return height[(i + 1) * grid + (k + 1)]; };
+    // Height of the next level's surface at grid point (i, k), along the
+    // shared diagonal for cell centres.
+    auto coarse = [&](int i, int k) {
+        bool oddI = (i & 1) != 0, oddK = (k & 1) != 0;
+        if (oddI && oddK) return 0.5f * (h(i - 1, k - 1) + h(i + 1, k + 1));
+        if (oddI) return 0.5f * (h(i - 1, k) + h(i + 1, k));
+        if (oddK) return 0.5f * (h(i, k - 1) + h(i, k + 1));
+        return h(i, k);
+    };
+    vertices.clear();
+    vertices.reserve(side * side + 4 * side);
+    minY = 1e9f;
+    maxY = -1e9f;
+    for (int i = 0; i <= n; i++)
+        for (int k = 0; k <= n; k++) {
+            const TerrainPoint& tp = samples[(i + 1) * grid + (k + 1)];
+            int worldX = x0 + i * step, worldZ = z0 + k * step;
+            uint8_t type = BLOCK_WATER;
+            if (tp.isLand) {
+                if (floorDiv(worldX, CHUNK_SIZE) >= 160) type = BLOCK_SAND;
+                else if (floorDiv(worldZ, CHUNK_SIZE) <= -160) type = BLOCK_SNOW;
+                else type = BLOCK_GRASS;
+            }
+            glm::vec3 normal = glm::normalize(glm::vec3(h(i - 1, k) - h(i + 1, k), 2.0f * step, h(i, k - 1) - h(i, k + 1)));
+            float y = h(i, k);
+            float coarseY = (level + 1 < LOD_LEVELS) ? coarse(i, k) : y;
+            vertices.push_back({ float(worldX), y, float(worldZ), coarseY, normal.x, normal.y, normal.z, float(type) });
+            minY = std::min(minY, std::min(y, coarseY));
+            maxY = std::max(maxY, std::max(y, coarseY));
+        }
+    const float skirtDepth = 2.0f * step;
+    for (int edge = 0; edge < 4; edge++)
+        for (int t = 0; t <= n; t++) {
+            int i = (edge == 2) ? 0 : (edge == 3) ? n : t;
+            int k = (edge == 0) ? 0 : (edge == 1) ? n : t;
+            LodVertex v = vertices[i * side + k];
+            v.y -= skirtDepth;
+            v.coarseY -= skirtDepth;
+            vertices.push_back(v);
+        }
+    minY -= skirtDepth;
+}
+
+void buildLodTile(LodTile& tile, int tileX, int tileZ, int level) {
+    static std::vector<LodVertex> vertices;
+    meshLodTile(tileX, tileZ, level, vertices, tile.minY[level], tile.maxY[level]);
+    if (tile.buffer[level] == 0)
+        glGenBuffers(1, &tile.buffer[level]);
+    glBindBuffer(GL_ARRAY_BUFFER, tile.buffer[level]);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(LodVertex), vertices.data(), GL_STATIC_DRAW);
+}
+
+inline bool chunkDrawnInFullDetail(const Chunk& chunk) {
+    return chunk.generated && !chunk.needsMeshUpdate && !chunk.needsUpload;
+}
+
+// Picks each tile's level, meshes missing tiles nearest first within the frame
+// budget and draws them, falling back to another level a tile already has.
+// The LOD program must be bound with its scene uniforms set.
+void drawLodTerrain(GLuint lodShaderProgram, const glm::vec3& eye, const std::vector<Plane>& frustum,
+                    int playerChunkX, int playerChunkZ) {
+    static GLint morphRangeLoc = glGetUniformLocation(lodShaderProgram, "morphRange");
+    static GLint maskOriginLoc = glGetUniformLocation(lodShaderProgram, "maskOrigin");
+    static GLint chunkMaskLoc = glGetUniformLocation(lodShaderProgram, "chunkMask");
+    lastFrameLodTiles = 0;
+    lastFrameLodTriangles = 0;
+    if (!lodEnabled)
+        return;
+
+    // Mark the chunks drawn in full detail around the player.
+    static std::vector<uint8_t> mask(LOD_MASK_CHUNKS * LOD_MASK_CHUNKS);
+    std::fill(mask.begin(), mask.end(), 0);
+    const int maskX = playerChunkX - LOD_MASK_CHUNKS / 2, maskZ = playerChunkZ - LOD_MASK_CHUNKS / 2;
+    auto maskAt = [&](int cx, int cz) -> uint8_t* {
+        int mx = cx - maskX, mz = cz - maskZ;
+        if (mx < 0 || mz < 0 || mx >= LOD_MASK_CHUNKS || mz >= LOD_MASK_CHUNKS)
+            return nullptr;
+        return &mask[mz * LOD_MASK_CHUNKS + mx];
+    };
+    for (const auto& entry : chunks)
+        if (chunkDrawnInFullDetail(entry.second))
+            if (uint8_t* m = maskAt(entry.first.x, entry.first.z))
+                *m = 255;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lodChunkMask);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, LOD_MASK_CHUNKS, LOD_MASK_CHUNKS, GL_RED, GL_UNSIGNED_BYTE, mask.data());
+    glUniform1i(chunkMaskLoc, 0);
+    glUniform2i(maskOriginLoc, maskX, maskZ);
+
+    // Wanted level per tile in range, by horizontal distance to the tile.
+    const float farRange = static_cast<float>(LOD_RANGE_CHUNKS[LOD_LEVELS - 1] * CHUNK_SIZE);
+    const int minTileX = floorDiv(static_cast<int>(std::floor(eye.x - farRange)), LOD_TILE_SIZE);
+    const int maxTileX = floorDiv(static_cast<int>(std::floor(eye.x + farRange)), LOD_TILE_SIZE);
+    const int minTileZ = floorDiv(static_cast<int>(std::floor(eye.z - farRange)), LOD_TILE_SIZE);
+    const int maxTileZ = floorDiv(static_cast<int>(std::floor(eye.z + farRange)), LOD_TILE_SIZE);
+    struct Wanted { ChunkPos tile; int level; float distance; };
+    static std::vector<Wanted> wanted;
+    wanted.clear();
+    for (int tx = minTileX; tx <= maxTileX; tx++)
+        for (int tz = minTileZ; tz <= maxTileZ; tz++) {
+            float x0 = static_cast<float>(tx * LOD_TILE_SIZE), z0 = static_cast<float>(tz * LOD_TILE_SIZE);
+            float dx = std::max(std::max(x0 - eye.x, eye.x - (x0 + LOD_TILE_SIZE)), 0.0f);
+            float dz = std::max(std::max(z0 - eye.z, eye.z - (z0 + LOD_TILE_SIZE)), 0.0f);
+            float distance = std::sqrt(dx * dx + dz * dz);
+            int level = 0;
+            while (level < LOD_LEVELS && distance >= LOD_RANGE_CHUNKS[level] * CHUNK_SIZE)
+                level++;
+            if (level == LOD_LEVELS)
+                continue;
+            // Tiles entirely covered by full-detail chunks are not needed.
+            bool covered = true;
+            for (int cx = 0; cx < LOD_TILE_CHUNKS && covered; cx++)
+                for (int cz = 0; cz < LOD_TILE_CHUNKS && covered; cz++) {
+                    uint8_t* m = maskAt(tx * LOD_TILE_CHUNKS + cx, tz * LOD_TILE_CHUNKS + cz);
+                    covered = m != nullptr && *m != 0;
+                }
+            if (!covered)
+                wanted.push_back({ ChunkPos(tx, tz), level, distance });
+        }
+    std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.distance < b.distance; });
+
+    // Mesh missing tiles, nearest first, until the budget runs out. Benchmarks
+    // count tiles instead, so the frames do not depend on machine speed.
+    auto buildStart = std::chrono::steady_clock::now();
+    int tilesBuilt = 0;
+    for (const Wanted& w : wanted) {
+        LodTile& tile = lodTiles[w.tile];
+        if (tile.buffer[w.level] != 0)
+            continue;
+        if (benchmarkMode ? tilesBuilt >= LOD_BENCH_TILES_PER_FRAME
+                          : std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count() > LOD_BUILD_BUDGET_MS)
+            break;
+        buildLodTile(tile, w.tile.x, w.tile.z, w.level);
+        tilesBuilt++;
+    }
+
+    // Drop tiles out of range, and other levels once the wanted one is ready.
+    static std::unordered_map<ChunkPos, int> wantedLevel;
+    wantedLevel.clear();
+    for (const Wanted& w : wanted)
+        wantedLevel[w.tile] = w.level;
+    for (auto it = lodTiles.begin(); it != lodTiles.end();) {
+        auto want = wantedLevel.find(it->first);
+        if (want == wantedLevel.end()) {
+            releaseLodTile(it->second);
+            it = lodTiles.erase(it);
+            continue;
         }
+        if (it->second.buffer[want->second] != 0)
+            for (int l = 0; l < LOD_LEVELS; l++)
+                if (l != want->second && it->second.buffer[l] != 0) {
+                    glDeleteBuffers(1, &it->second.buffer[l]);
+                    it->second.buffer[l] = 0;
+                }
+        ++it;
     }
-    chunk.needsMeshUpdate = false;
-    visitedChunks.insert(ChunkPos(chunkX, chunkZ));
-    bigMapDirty = true;
+
+    glBindVertexArray(lodVAO);
+    for (const Wanted& w : wanted) {
+        auto found = lodTiles.find(w.tile);
+        if (found == lodTiles.end())
+            continue;
+        const LodTile& tile = found->second;
+        int level = w.level;
+        for (int offset = 1; tile.buffer[level] == 0 && offset < LOD_LEVELS; offset++) {
+            if (w.level + offset < LOD_LEVELS && tile.buffer[w.level + offset] != 0) level = w.level + offset;
+            else if (w.level - offset >= 0 && tile.buffer[w.level - offset] != 0) level = w.level - offset;
+        }
+        if (tile.buffer[level] == 0)
+            continue;
+        glm::vec3 boxMin(w.tile.x * LOD_TILE_SIZE, tile.minY[level], w.tile.z * LOD_TILE_SIZE);
+        glm::vec3 boxMax = boxMin + glm::vec3(LOD_TILE_SIZE, tile.maxY[level] - tile.minY[level], LOD_TILE_SIZE);
+        if (!aabbInFrustum(frustum, boxMin, boxMax))
+            continue;
+        float morphStart = LOD_MORPH_START_CHUNKS[level] * static_cast<float>(CHUNK_SIZE);
+        float morphEnd = LOD_RANGE_CHUNKS[level] * static_cast<float>(CHUNK_SIZE);
+        if (level + 1 == LOD_LEVELS) {
+            // The last level has nothing to morph to.
+            morphStart = 1e9f;
+            morphEnd = 2e9f;
+        }
+        glUniform2f(morphRangeLoc, morphStart, morphEnd);
+        glBindBuffer(GL_ARRAY_BUFFER, tile.buffer[level]);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)(4 * sizeof(float)));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)(7 * sizeof(float)));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lodIndexBuffers[level]);
+        glDrawElements(GL_TRIANGLES, lodIndexCounts[level], GL_UNSIGNED_INT, (void*)0);
+        lastFrameLodTiles++;
+        lastFrameLodTriangles += lodIndexCounts[level] / 3;
+    }
+    glBindVertexArray(0);
 }
 
 
-// ---------------------- Chunk Update ----------------------
-void updateChunks() {
-    int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
-    int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
-    int renderDistance = static_cast<int>(RENDER_DISTANCE);
-    int renderDistanceSquared = renderDistance * renderDistance;
+float averageFrameMs = 0.0f;
+float averageRenderCpuMs = 0.0f; // CPU time spent issuing the frame's GL calls
+float averageDrawCalls = 0.0f;   // chunk draws (terrain, instances, branches) per frame
+int lastFrameDrawCalls = 0;
+int lastFrameInstancesDrawn = 0;
+int lastFrameQuadsDrawn = 0;
+float averageNoisePerFrame = 0.0f;
+uint64_t lastFrameNoiseEvaluations = 0;
+
+void printChunkMemoryStats() {
+    size_t blockBytes = 0, instanceBytes = 0, gpuBytes = 0;
+    for (const auto& entry : chunks) {
+        blockBytes += entry.second.memoryUsage();
+        instanceBytes += entry.second.instanceMemoryUsage();
+        gpuBytes += entry.second.gpuMemoryUsage();
+    }
+    size_t count = std::max<size_t>(chunks.size(), 1);
+    std::cout << "Chunks: " << chunks.size()
+              << "  block storage: " << blockBytes / 1024 << " KB (" << blockBytes / count << " B/chunk)"
+              << "  pending instances: " << instanceBytes / 1024 << " KB"
+              << "  GPU instances: " << gpuBytes / 1024 << " KB"
+              << "  frame: " << averageFrameMs << " ms\n";
+    std::cout << "Render: " << lastFrameDrawCalls << " chunk draw calls (avg " << averageDrawCalls << ")"
+              << "  instances: " << lastFrameInstancesDrawn << "  terrain quads: " << lastFrameQuadsDrawn
+              << "  cave culling: " << (caveCullingEnabled ? "on" : "off")
+              << "  CPU submit: " << averageRenderCpuMs << " ms\n";
+    std::cout << "Distant terrain: " << (lodEnabled ? "on" : "off") << ", " << lastFrameLodTiles << " tiles drawn ("
+              << lastFrameLodTriangles << " triangles), " << lodTiles.size() << " meshed, out to "
+              << LOD_RANGE_CHUNKS[LOD_LEVELS - 1] << " chunks\n";
+    size_t heightmaps, lookups;
+    {
+        std::lock_guard<std::mutex> lock(terrainCacheMutex);
+        heightmaps = heightmapCache.size();
+        lookups = terrainCacheHits + terrainCacheMisses;
+    }
+    std::cout << "Terrain cache: " << heightmaps << " heightmaps, "
+              << (lookups ? 100.0 * terrainCacheHits / lookups : 0.0) << "% column hits"
+              << "  noise samples/frame: " << averageNoisePerFrame << "\n";
+}
 
-    for (auto it = chunks.begin(); it != chunks.end();) {
-        int dx = it->first.x - playerChunkX;
-        int dz = it->first.z - playerChunkZ;
-        if (dx * dx + dz * dz > renderDistanceSquared)
-            it = chunks.erase(it);
-        else
-            ++it;
+// Generation throughput on a fixed 16x16 chunk patch: terrain/cave noise alone
+// (scalar reference vs. batched lanes) and the full generateChunkBlocks pass.
+void benchmarkChunkGeneration() {
+    const int PATCH = 16;
+    const int CAVE_LAYERS = -MIN_Y;
+    const int chunkCount = PATCH * PATCH;
+    typedef std::chrono::steady_clock Clock;
+    auto chunksPerSecond = [&](Clock::time_point start) {
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return chunkCount / std::max(seconds, 1e-9);
+    };
+    double checksum = 0.0;
+
+    Clock::time_point start = Clock::now();
+    for (int cx = 0; cx < PATCH; cx++)
+        for (int cz = 0; cz < PATCH; cz++)
+            for (int x = 0; x < CHUNK_SIZE; x++)
+                for (int z = 0; z < CHUNK_SIZE; z++) {
+                    double worldX = cx * CHUNK_SIZE + x, worldZ = cz * CHUNK_SIZE + z;
+                    checksum += getTerrainHeight(worldX, worldZ).height;
+                    for (int y = MIN_Y; y < 0; y++)
+                        checksum += caveNoise.noise(worldX * 0.1, y * 0.1, worldZ * 0.1);
+                }
+    double scalarRate = chunksPerSecond(start);
+
+    start = Clock::now();
+    TerrainPoint grid[CHUNK_SIZE * CHUNK_SIZE];
+    std::vector<float> cave(CHUNK_SIZE * CHUNK_SIZE * CAVE_LAYERS);
+    for (int cx = 0; cx < PATCH; cx++)
+        for (int cz = 0; cz < PATCH; cz++) {
+            getTerrainHeightGrid(cx * CHUNK_SIZE, cz * CHUNK_SIZE, CHUNK_SIZE, grid);
+            caveNoise.noiseBlock(cx * CHUNK_SIZE, MIN_Y, cz * CHUNK_SIZE, 0.1, CHUNK_SIZE, CAVE_LAYERS, CHUNK_SIZE, cave.data());
+            for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++)
+                checksum += grid[i].height;
+            for (float c : cave)
+                checksum += c;
+        }
+    double batchedRate = chunksPerSecond(start);
+
+    start = Clock::now();
+    Chunk scratch;
+    for (int cx = 0; cx < PATCH; cx++)
+        for (int cz = 0; cz < PATCH; cz++)
+            generateChunkBlocks(scratch, cx, cz);
+    double generateRate = chunksPerSecond(start);
+
+    std::cout << "Generation (" << chunkCount << " chunks, " << PRISMALS_NOISE_LANES << "): "
+              << "noise scalar " << scalarRate << " chunks/s, batched " << batchedRate << " chunks/s ("
+              << batchedRate / std::max(scalarRate, 1e-9) << "x); generateChunkBlocks "
+              << generateRate << " chunks/s  [checksum " << checksum << "]\n";
+}
+
+// Region file round trip for the same 16x16 chunk patch, written to a scratch
+// store next to the world and removed afterwards.
+void benchmarkRegionStorage() {
+    const int PATCH = 16;
+    const int chunkCount = PATCH * PATCH;
+    typedef std::chrono::steady_clock Clock;
+    auto seconds = [](Clock::time_point start) {
+        return std::max(std::chrono::duration<double>(Clock::now() - start).count(), 1e-9);
+    };
+    std::vector<Chunk> generated(chunkCount);
+    for (int i = 0; i < chunkCount; i++)
+        generateChunkBlocks(generated[i], i / PATCH, i % PATCH);
+
+    std::string directory = std::string(WORLD_DIRECTORY) + "/bench";
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    size_t rawBytes = 0, storedBytes = 0;
+    {
+        RegionStore store(directory);
+        std::vector<uint8_t> raw;
+        for (const Chunk& chunk : generated) {
+            serializeChunk(chunk, raw);
+            rawBytes += raw.size();
+        }
+        Clock::time_point start = Clock::now();
+        for (Chunk& chunk : generated)
+            saveChunk(store, chunk);
+        store.closeAll();
+        double saveSeconds = seconds(start);
+
+        start = Clock::now();
+        int loaded = 0;
+        for (int i = 0; i < chunkCount; i++) {
+            Chunk chunk;
+            if (loadChunk(store, chunk, i / PATCH, i % PATCH))
+                loaded++;
+        }
+        double loadSeconds = seconds(start);
+        store.closeAll();
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+            storedBytes += static_cast<size_t>(entry.file_size());
+
+        start = Clock::now();
+        Chunk scratch;
+        for (int i = 0; i < chunkCount; i++)
+            generateChunkBlocks(scratch, i / PATCH, i % PATCH);
+        double generateSeconds = seconds(start);
+
+        std::cout << "Region files (" << chunkCount << " chunks, " << rawBytes / chunkCount << " B raw -> "
+                  << storedBytes / chunkCount << " B stored per chunk): save " << chunkCount / saveSeconds
+                  << " chunks/s, load " << loaded / loadSeconds << " chunks/s ("
+                  << loaded << " loaded), generate " << chunkCount / generateSeconds << " chunks/s\n";
     }
+    std::filesystem::remove_all(directory, ec);
+}
 
-    for (int x = playerChunkX - renderDistance; x <= playerChunkX + renderDistance; x++) {
-        for (int z = playerChunkZ - renderDistance; z <= playerChunkZ + renderDistance; z++) {
-            int dx = x - playerChunkX;
-            int dz = z - playerChunkZ;
-            if (dx * dx + dz * dz <= renderDistanceSquared) {
-                ChunkPos pos{ x, z };
-                if (chunks.find(pos) == chunks.end())
-                    chunks[pos] = Chunk();
-                generateChunkMesh(chunks[pos], x, z);
+// ---------------------- Benchmark Mode ----------------------
+// `--bench` flies a fixed camera path through the biomes and prints one JSON
+// object of measurements. Everything that feeds the frames is fixed: noise
+// seeds, tree placement and stars (all seed- or position-derived), the time of
+// day, and the world, which is generated fresh instead of loaded from or saved
+// to WORLD_DIRECTORY. The window stays hidden, with vsync off.
+// Chunk streaming is made deterministic too: each frame waits for its queued
+// chunks (see updateChunks), and distant terrain meshes a fixed number of tiles
+// per frame, so frame times include that work rather than varying the scene.
+// `--null-render` runs the same frames without any GL context: chunks are
+// streamed, meshed, culled and counted but never uploaded or drawn.
+// `--bench-out <file>` writes the JSON to a file instead of stdout.
+struct BenchSegment {
+    const char* biome;
+    float startX, startZ;
+    float yaw; // heading, as cameraYaw
+};
+const BenchSegment BENCH_PATH[] = {
+    { "plains", 8.0f, 8.0f, 0.0f },
+    { "mountains", -30.0f * CHUNK_SIZE, 8.0f, 90.0f },
+    { "desert", 170.0f * CHUNK_SIZE, 8.0f, 0.0f },
+    { "snow", 8.0f, -170.0f * CHUNK_SIZE, 180.0f },
+    { "ocean", 8.0f, 300.0f * CHUNK_SIZE, 0.0f },
+};
+const int BENCH_SEGMENTS = sizeof(BENCH_PATH) / sizeof(BENCH_PATH[0]);
+const int BENCH_FRAMES_PER_SEGMENT = 240;
+const float BENCH_BLOCKS_PER_FRAME = 1.0f;
+const float BENCH_HEIGHT_ABOVE_GROUND = 24.0f;
+const float BENCH_PITCH = -15.0f;
+
+// Places the camera for the given frame; false once the path is done.
+bool benchCameraForFrame(int frame) {
+    int segment = frame / BENCH_FRAMES_PER_SEGMENT;
+    if (segment >= BENCH_SEGMENTS)
+        return false;
+    const BenchSegment& path = BENCH_PATH[segment];
+    float travelled = (frame % BENCH_FRAMES_PER_SEGMENT) * BENCH_BLOCKS_PER_FRAME;
+    float x = path.startX + std::cos(glm::radians(path.yaw)) * travelled;
+    float z = path.startZ + std::sin(glm::radians(path.yaw)) * travelled;
+    TerrainPoint ground = getTerrainAt(x, z);
+    float groundY = ground.isLand ? static_cast<float>(std::floor(ground.height)) : WATER_SURFACE;
+    cameraPos = glm::vec3(x, std::max(groundY, WATER_SURFACE) + BENCH_HEIGHT_ABOVE_GROUND, z);
+    cameraYaw = path.yaw;
+    pitch = BENCH_PITCH;
+    playerMode = 0;
+    return true;
+}
+
+void recordBenchFrame(int frame, std::chrono::steady_clock::time_point frameStart, int instances, int quads, int drawCalls) {
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    size_t blockBytes = 0, renderBytes = 0;
+    for (const auto& entry : chunks) {
+        blockBytes += entry.second.memoryUsage();
+        renderBytes += entry.second.gpuMemoryUsage();
+    }
+    BenchRecorder& r = benchRecorder;
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.frameMs.push_back(ms);
+    r.frameSegment.push_back(frame / BENCH_FRAMES_PER_SEGMENT);
+    r.instances.push_back(static_cast<float>(instances));
+    r.quads.push_back(static_cast<float>(quads));
+    if (drawCalls >= 0)
+        r.drawCalls.push_back(static_cast<float>(drawCalls));
+    r.peakBlockBytes = std::max(r.peakBlockBytes, blockBytes);
+    r.peakRenderBytes = std::max(r.peakRenderBytes, renderBytes);
+}
+
+// Nearest-rank percentile of sorted samples.
+float benchPercentile(const std::vector<float>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0f;
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+// "name": {"count", "mean", "p50", "p90", "p99", "max"}
+void writeBenchStats(FILE* out, const char* name, std::vector<float> samples) {
+    std::sort(samples.begin(), samples.end());
+    double mean = samples.empty() ? 0.0 : std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    std::fprintf(out, "  \"%s\": {\"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+                 name, samples.size(), mean, benchPercentile(samples, 0.5), benchPercentile(samples, 0.9),
+                 benchPercentile(samples, 0.99), benchPercentile(samples, 1.0));
+}
+
+bool writeBenchReport(const char* mode, const char* outPath) {
+    FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (!out) {
+        std::cout << "Could not write benchmark report " << outPath << "\n";
+        return false;
+    }
+    BenchRecorder& r = benchRecorder;
+    std::lock_guard<std::mutex> lock(r.mutex);
+    size_t blockBytes = 0, renderBytes = 0;
+    for (const auto& entry : chunks) {
+        blockBytes += entry.second.memoryUsage();
+        renderBytes += entry.second.gpuMemoryUsage();
+    }
+    std::fprintf(out, "{\n  \"benchmark\": \"prismals_game\",\n  \"mode\": \"%s\",\n", mode);
+    std::fprintf(out, "  \"noise_lanes\": \"%s\",\n  \"worker_threads\": %zu,\n  \"frames\": %zu,\n",
+                 PRISMALS_NOISE_LANES, chunkWorkers.threads.size(), r.frameMs.size());
+    writeBenchStats(out, "frame_ms", r.frameMs);
+    writeBenchStats(out, "chunk_generate_ms", r.generateMs);
+    writeBenchStats(out, "chunk_mesh_ms", r.meshMs);
+    writeBenchStats(out, "instance_build_ms", r.instanceBuildMs);
+    writeBenchStats(out, "instances_per_frame", r.instances);
+    writeBenchStats(out, "terrain_quads_per_frame", r.quads);
+    if (!r.drawCalls.empty())
+        writeBenchStats(out, "draw_calls_per_frame", r.drawCalls);
+    std::fprintf(out, "  \"chunk_memory\": {\"chunks\": %zu, \"block_bytes\": %zu, \"render_bytes\": %zu, "
+                      "\"peak_block_bytes\": %zu, \"peak_render_bytes\": %zu},\n",
+                 chunks.size(), blockBytes, renderBytes, r.peakBlockBytes, r.peakRenderBytes);
+    std::fprintf(out, "  \"segments\": [\n");
+    for (int s = 0; s < BENCH_SEGMENTS; s++) {
+        std::vector<float> frameMs, instances;
+        for (size_t f = 0; f < r.frameMs.size(); f++)
+            if (r.frameSegment[f] == s) {
+                frameMs.push_back(r.frameMs[f]);
+                instances.push_back(r.instances[f]);
             }
-        }
+        std::sort(frameMs.begin(), frameMs.end());
+        double meanInstances = instances.empty() ? 0.0 : std::accumulate(instances.begin(), instances.end(), 0.0) / instances.size();
+        std::fprintf(out, "    {\"biome\": \"%s\", \"frames\": %zu, \"frame_ms_p50\": %.4f, \"frame_ms_p99\": %.4f, \"instances_mean\": %.1f}%s\n",
+                     BENCH_PATH[s].biome, frameMs.size(), benchPercentile(frameMs, 0.5), benchPercentile(frameMs, 0.99),
+                     meanInstances, s + 1 < BENCH_SEGMENTS ? "," : "");
     }
+    std::fprintf(out, "  ]\n}\n");
+    if (out != stdout)
+        std::fclose(out);
+    return true;
 }
 
+// The --null-render benchmark: the frame loop minus everything that needs GL.
+int runNullRenderBenchmark(const char* outPath) {
+    for (int frame = 0; benchCameraForFrame(frame); frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+        updateChunks();
+        glm::vec3 front(cos(glm::radians(cameraYaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)),
+                        sin(glm::radians(cameraYaw)) * cos(glm::radians(pitch)));
+        glm::vec3 eyePos = cameraPos + glm::vec3(0.0f, eyeLevelOffset, 0.0f);
+        glm::mat4 view = glm::lookAt(eyePos, eyePos + glm::normalize(front), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(103.0f),
+            static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT), 0.1f, 10000.0f);
+        std::vector<Chunk*> visibleChunks = prepareVisibleChunks(projection * view, eyePos, false);
+        // Count what the renderer would submit.
+        int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
+        int instances = 0, quads = 0;
+        for (Chunk* chunk : visibleChunks) {
+            GLint first;
+            for (int run = 0; run < INSTANCE_RUN_COUNT; run++)
+                if (instanceRunDrawn(run, playerChunkZ))
+                    instances += visibleRunRange(*chunk, run, first);
+            if (chunk->visibleSections == 0)
+                continue;
+            instances += static_cast<int>(chunk->branchPositions.size());
+            for (int s = 0; s < SECTION_COUNT; s++)
+                if ((chunk->visibleSections >> s) & 1)
+                    quads += chunk->sectionQuadStart[s + 1] - chunk->sectionQuadStart[s];
+        }
+        mapDirtyChunks.clear(); // no map to refresh
+        recordBenchFrame(frame, frameStart, instances, quads, -1);
+    }
+    bool written = writeBenchReport("null-render", outPath);
+    chunkWorkers.stop();
+    return written ? 0 : 1;
+}
 
 // ---------------------- Input Handling ----------------------
 
@@ -1282,11 +3809,62 @@ void processInput(GLFWwindow* window) {
         nWasPressed = false;
     }
 
+    // Print chunk memory usage with F3.
+    static bool f3WasPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!f3WasPressed) {
+            printChunkMemoryStats();
+            f3WasPressed = true;
+        }
+    }
+    else {
+        f3WasPressed = false;
+    }
+
+    // Toggle cave culling with F5 (compare the F3 numbers with it off).
+    static bool f5WasPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
+        if (!f5WasPressed) {
+            caveCullingEnabled = !caveCullingEnabled;
+            std::cout << "Cave culling " << (caveCullingEnabled ? "on" : "off") << "\n";
+            f5WasPressed = true;
+        }
+    }
+    else {
+        f5WasPressed = false;
+    }
+
+    // Toggle the distant terrain rings with F6.
+    static bool f6WasPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS) {
+        if (!f6WasPressed) {
+            lodEnabled = !lodEnabled;
+            std::cout << "Distant terrain " << (lodEnabled ? "on" : "off") << "\n";
+            f6WasPressed = true;
+        }
+    }
+    else {
+        f6WasPressed = false;
+    }
+
+    // Benchmark chunk generation and region file throughput with F4.
+    static bool f4WasPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS) {
+        if (!f4WasPressed) {
+            benchmarkChunkGeneration();
+            benchmarkRegionStorage();
+            f4WasPressed = true;
+        }
+    }
+    else {
+        f4WasPressed = false;
+    }
+
     // Toggle mode (prone / swim / paraglide) with P.
     static bool pWasPressed = false;
     if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
         if (!pWasPressed) {
-            TerrainPoint tp = getTerrainHeight(cameraPos.x, cameraPos.z);
+            TerrainPoint tp = getTerrainAt(cameraPos.x, cameraPos.z);
             float groundY = static_cast<float>(std::floor(tp.height)) + 1.0f;
             bool onGround = (cameraPos.y <= groundY + 0.1f);
             bool actuallyInWater = (!tp.isLand) && (cameraPos.y <= WATER_SURFACE + 0.1f);
@@ -1313,17 +3891,17 @@ void processInput(GLFWwindow* window) {
     // If fullscreen map is active, handle panning and return.
     if (fullscreenMap) {
         const float panSpeed = 500.0f * deltaTime;
-        bool panned = false;
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) { bigMapPanX -= panSpeed; panned = true; }
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) { bigMapPanX += panSpeed; panned = true; }
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) { bigMapPanZ -= panSpeed; panned = true; }
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) { bigMapPanZ += panSpeed; panned = true; }
-        if (panned) { bigMapDirty = true; }
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) bigMapPanX -= panSpeed;
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) bigMapPanX += panSpeed;
+        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) bigMapPanZ -= panSpeed;
+        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) bigMapPanZ += panSpeed;
         return;
     }
     const float waterJumpImpulse = 6.0f; // adjust as desired
 
-    // Handle movement based on current playerMode.
+    // Handle movement based on current playerMode; collision is applied to
+    // the resulting displacement afterwards.
+    glm::vec3 positionBeforeMove = cameraPos;
     switch (playerMode) {
 
     case 0: // Standing/Walking
@@ -1373,7 +3951,7 @@ void processInput(GLFWwindow* window) {
         // 3) Handle Jump Input and Double-Jump Mantle
         // -----------------------------------------------
         // Check if we're on the ground.
-        TerrainPoint tp = getTerrainHeight(cameraPos.x, cameraPos.z);
+        TerrainPoint tp = getTerrainAt(cameraPos.x, cameraPos.z);
         float groundY = floor(tp.height) + 1.0f;
         bool onGround = (cameraPos.y <= groundY + 0.1f);
         bool inWater = (!tp.isLand && cameraPos.y <= WATER_SURFACE + 0.1f);
@@ -1499,7 +4077,7 @@ void processInput(GLFWwindow* window) {
         cameraPos += moveDir * proneSpeed * deltaTime;
 
         // Immediately clamp vertical position to ground level.
-        TerrainPoint tp = getTerrainHeight(cameraPos.x, cameraPos.z);
+        TerrainPoint tp = getTerrainAt(cameraPos.x, cameraPos.z);
         float groundY = std::floor(tp.height) + 1.0f;
         cameraPos.y = groundY;
     }
@@ -1604,7 +4182,7 @@ void processInput(GLFWwindow* window) {
         cameraPos += velocity * deltaTime;
 
         // 8) Optional: if you want to auto–exit paraglider mode on ground
-        TerrainPoint tp = getTerrainHeight(cameraPos.x, cameraPos.z);
+        TerrainPoint tp = getTerrainAt(cameraPos.x, cameraPos.z);
         float groundY = floor(tp.height) + 1.0f;
         bool landed = (cameraPos.y <= groundY + 0.1f);
         if (landed) {
@@ -1619,7 +4197,7 @@ void processInput(GLFWwindow* window) {
 
     }
 
-    handleCollision();
+    handleCollision(positionBeforeMove);
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 }
@@ -1721,22 +4299,25 @@ layout (location = 1) in vec3 aNormal;      // Vertex normal
 layout (location = 2) in vec2 aTexCoord;    // Texture coordinate
 layout (location = 3) in vec3 aOffset;      // Instance offset (constant per instance)
 layout (location = 4) in float aRotation;   // Instance rotation
+layout (location = 5) in float aBlockType;  // Instance block type (generic attribute when not instanced)
 
 out vec2 TexCoord;
 out vec3 ourColor;
 out float instanceDistance;
 out vec3 Normal;
 out vec3 WorldPos;  // World-space position
+flat out int vBlockType;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform int blockType;
 uniform vec3 blockColors[25];
 uniform vec3 cameraPos;
 uniform float time;
 
 void main(){
+    int blockType = int(aBlockType + 0.5);
+    vBlockType = blockType;
     vec3 pos;
     vec3 normal = aNormal;
     
@@ -1827,6 +4408,48 @@ void main(){
 }
 )";
 // --- Main Scene Fragment Shader ---
+// Greedy-meshed terrain: one packed uint per vertex (see packTerrainVertex).
+// Shares the block fragment shader; meshed types are all plain cubes, so the
+// per-vertex type always takes the grid-overlay path.
+const char* terrainVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in uint aPacked;
+
+out vec2 TexCoord;
+out vec3 ourColor;
+out float instanceDistance;
+out vec3 Normal;
+out vec3 WorldPos;
+flat out int vBlockType;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 chunkOrigin;   // world position of the chunk's lowest mesh corner
+uniform vec3 blockColors[25];
+uniform vec3 cameraPos;
+
+const vec3 faceNormals[6] = vec3[6](
+    vec3(1, 0, 0), vec3(-1, 0, 0),
+    vec3(0, 1, 0), vec3(0, -1, 0),
+    vec3(0, 0, 1), vec3(0, 0, -1)
+);
+
+void main(){
+    vec3 local = vec3(float(aPacked & 31u), float((aPacked >> 10) & 1023u), float((aPacked >> 5) & 31u));
+    uint face = (aPacked >> 20) & 7u;
+    int type = int((aPacked >> 23) & 31u);
+
+    WorldPos = chunkOrigin + local;
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+    ourColor = blockColors[type];
+    vBlockType = type;
+    Normal = faceNormals[face];
+    // One texture unit per block, so the grid overlay repeats across merged quads.
+    TexCoord = (face < 2u) ? local.zy : ((face < 4u) ? local.xz : local.xy);
+    instanceDistance = length(WorldPos - cameraPos);
+}
+)";
+
 const char* fragmentShaderSource = R"(
 #version 330 core
 in vec2 TexCoord;
@@ -1834,10 +4457,10 @@ in vec3 ourColor;
 in float instanceDistance;
 in vec3 Normal;
 in vec3 WorldPos;  // World-space position from the vertex shader
+flat in int vBlockType;
 
 out vec4 FragColor;
 
-uniform int blockType;
 uniform vec3 blockColors[25];
 uniform vec3 lightDir;
 uniform vec3 ambientLight;
@@ -1850,6 +4473,7 @@ float generateNoise(vec2 cell) {
 }
 
 void main(){
+    int blockType = vBlockType;
     // Special handling for translucent aurora blocks (blockType 19)
     if(blockType == 19){
         FragColor = vec4(ourColor, 0.1);
@@ -1958,6 +4582,85 @@ void main(){
 }
 )";
 
+// --- Map Texture Shaders ---
+// The map quad is given in world x/z; the ring texture repeats every
+// ringWorldSize units, so world position is the texture coordinate.
+const char* mapVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+out vec2 TexCoord;
+uniform mat4 ortho;
+uniform float ringWorldSize;
+void main(){
+    TexCoord = aPos / ringWorldSize;
+    gl_Position = ortho * vec4(aPos, 0.0, 1.0);
+}
+)";
+
+const char* mapFragmentShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform sampler2D mapTexture;
+void main(){
+    FragColor = vec4(texture(mapTexture, TexCoord).rgb, 1.0);
+}
+)";
+
+// --- Distant Terrain LOD Shaders ---
+// Heightmap tiles (see drawLodTerrain). Vertices slide from this level's
+// height to the next level's across morphRange (horizontal distance), and
+// fragments over chunks drawn in full detail are dropped via chunkMask.
+const char* lodVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec4 aPos;   // w: height of the next coarser level
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in float aType;
+
+out vec3 ourColor;
+out vec3 Normal;
+out vec3 WorldPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform vec2 morphRange;
+uniform vec3 blockColors[25];
+
+void main(){
+    float morph = clamp((length(aPos.xz - cameraPos.xz) - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+    WorldPos = vec3(aPos.x, mix(aPos.y, aPos.w, morph), aPos.z);
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+    ourColor = blockColors[int(aType + 0.5)];
+    Normal = aNormal;
+}
+)";
+
+const char* lodFragmentShaderSource = R"(
+#version 330 core
+in vec3 ourColor;
+in vec3 Normal;
+in vec3 WorldPos;
+out vec4 FragColor;
+
+uniform vec3 lightDir;
+uniform vec3 ambientLight;
+uniform vec3 diffuseLight;
+uniform sampler2D chunkMask;
+uniform ivec2 maskOrigin;   // chunk at texel (0, 0)
+
+void main(){
+    // Blocks are centred on integer coordinates.
+    ivec2 chunk = ivec2(floor((WorldPos.xz + 0.5) / 16.0)) - maskOrigin;
+    ivec2 maskSize = textureSize(chunkMask, 0);
+    if (all(greaterThanEqual(chunk, ivec2(0))) && all(lessThan(chunk, maskSize)) &&
+        texelFetch(chunkMask, chunk, 0).r > 0.5)
+        discard;
+    float diff = max(dot(normalize(Normal), normalize(lightDir)), 0.0);
+    FragColor = vec4(ourColor * (ambientLight + diffuseLight * diff), 1.0);
+}
+)";
+
 // ---------------------- Sun/Moon Shaders (compiled above) ----------------------
 
 // ---------------------- Cube Vertex Data ----------------------
@@ -2007,169 +4710,247 @@ float cubeVertices[] = {
 -0.5f, -0.5f, -0.5f,    0,-1,0,   0.0f, 0.0f
 };
 
+// ---------------------- Map Textures ----------------------
+// A square RGBA texture addressed as a ring over chunk coordinates: chunk
+// (cx, cz) owns slot (cx mod ringChunks, cz mod ringChunks), a block of
+// texelsPerChunk texels on a side. The map quad samples it with GL_REPEAT, so
+// slots stay put as the view moves and only chunks entering the window (or
+// whose colour changed) are written.
+struct MapRing {
+    int ringChunks = 0;
+    int texelsPerChunk = 0;
+    GLuint texture = 0;
+    std::vector<ChunkPos> slotOwner;
+    bool hasWindow = false;
+    int windowMinX = 0, windowMinZ = 0, windowMaxX = 0, windowMaxZ = 0; // inclusive chunk range
+    size_t chunksWritten = 0;
+
+    void create(int chunksPerSide, int texels) {
+        ringChunks = chunksPerSide;
+        texelsPerChunk = texels;
+        int size = ringChunks * texelsPerChunk;
+        // No chunk can sit at this position inside a window, so every slot starts out stale.
+        slotOwner.assign(ringChunks * ringChunks, ChunkPos(std::numeric_limits<int>::min(), 0));
+        std::vector<uint32_t> black(static_cast<size_t>(size) * size, 0xFF000000u);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, black.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+
+    void destroy() {
+        if (texture != 0)
+            glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+
+    float worldSize() const { return static_cast<float>(ringChunks * CHUNK_SIZE); }
+
+    int slot(int cx, int cz) const {
+        int sx = cx % ringChunks, sz = cz % ringChunks;
+        if (sx < 0) sx += ringChunks;
+        if (sz < 0) sz += ringChunks;
+        return sz * ringChunks + sx;
+    }
+
+    bool inWindow(int cx, int cz) const {
+        return hasWindow && cx >= windowMinX && cx <= windowMaxX && cz >= windowMinZ && cz <= windowMaxZ;
+    }
+
+    // Writes chunks firstX..lastX of row cz. fill(cx, cz, texels) produces
+    // texelsPerChunk^2 RGBA texels, row-major in z; the run goes up in one
+    // upload per piece between wraps of the ring.
+    template <typename Fill>
+    void writeRun(int firstX, int lastX, int cz, Fill& fill) {
+        static std::vector<uint32_t> block, row;
+        block.resize(static_cast<size_t>(texelsPerChunk) * texelsPerChunk);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        while (firstX <= lastX) {
+            int s = slot(firstX, cz);
+            int sx = s % ringChunks, sz = s / ringChunks;
+            int count = std::min(lastX - firstX + 1, ringChunks - sx);
+            int width = count * texelsPerChunk;
+            row.resize(static_cast<size_t>(width) * texelsPerChunk);
+            for (int i = 0; i < count; i++) {
+                fill(firstX + i, cz, block.data());
+                for (int t = 0; t < texelsPerChunk; t++)
+                    std::copy(block.begin() + t * texelsPerChunk, block.begin() + (t + 1) * texelsPerChunk,
+                        row.begin() + t * width + i * texelsPerChunk);
+                slotOwner[s + i] = ChunkPos(firstX + i, cz);
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, 0, sx * texelsPerChunk, sz * texelsPerChunk,
+                width, texelsPerChunk, GL_RGBA, GL_UNSIGNED_BYTE, row.data());
+            chunksWritten += count;
+            firstX += count;
+        }
+    }
+
+    // Moves the window to the inclusive chunk range and writes the chunks that
+    // entered it: only the strips outside the previous window are visited.
+    template <typename Fill>
+    void setWindow(int minX, int minZ, int maxX, int maxZ, Fill fill) {
+        for (int cz = minZ; cz <= maxZ; cz++) {
+            bool rowCovered = hasWindow && cz >= windowMinZ && cz <= windowMaxZ;
+            int runStart = 0;
+            bool inRun = false;
+            for (int cx = minX; cx <= maxX + 1; cx++) {
+                bool stale = cx <= maxX && !(rowCovered && cx >= windowMinX && cx <= windowMaxX)
+                    && !(slotOwner[slot(cx, cz)] == ChunkPos(cx, cz));
+                if (stale && !inRun) {
+                    runStart = cx;
+                    inRun = true;
+                }
+                else if (!stale && inRun) {
+                    writeRun(runStart, cx - 1, cz, fill);
+                    inRun = false;
+                }
+                if (rowCovered && cx >= windowMinX && cx < windowMaxX && !inRun)
+                    cx = windowMaxX;
+            }
+        }
+        hasWindow = true;
+        windowMinX = minX; windowMinZ = minZ;
+        windowMaxX = maxX; windowMaxZ = maxZ;
+    }
+
+    template <typename Fill>
+    void refreshChunk(int cx, int cz, Fill fill) {
+        if (inWindow(cx, cz))
+            writeRun(cx, cx, cz, fill);
+    }
+};
+
+// The minimap shows single columns over a 12-chunk window; the world map one
+// texel per chunk over 400 chunks. Both rings leave room for a partly covered
+// chunk on each edge.
+const float MINIMAP_REGION = 96.0f;
+const int WORLD_MAP_CHUNKS = 400;
+MapRing minimapRing;
+MapRing worldMapRing;
+
+inline uint32_t packMapColor(const glm::vec3& c) {
+    auto channel = [](float v) { return static_cast<uint32_t>(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return channel(c.r) | (channel(c.g) << 8) | (channel(c.b) << 16) | 0xFF000000u;
+}
+
+glm::vec3 mapBlockColor(int blockType) {
+    switch (blockType) {
+    case 0:  return glm::vec3(0.19f, 0.66f, 0.32f);
+    case 1:  return glm::vec3(0.0f, 0.5f, 0.5f);
+    case 22: return glm::vec3(0.93f, 0.79f, 0.69f);
+    case 23: return glm::vec3(0.95f, 0.95f, 1.0f);
+    default: return glm::vec3(1.0f);
+    }
+}
+
+// Minimap texels: one per column, from the chunk's heightmap.
+void fillMinimapChunk(int cx, int cz, uint32_t* texels) {
+    ChunkHeightmap heightmap = getChunkHeightmap(cx, cz);
+    int landType = (cx >= 120) ? 22 : ((cz <= -40) ? 23 : 0);
+    uint32_t land = packMapColor(mapBlockColor(landType));
+    uint32_t water = packMapColor(mapBlockColor(1));
+    for (int z = 0; z < CHUNK_SIZE; z++)
+        for (int x = 0; x < CHUNK_SIZE; x++)
+            texels[z * CHUNK_SIZE + x] = heightmap.get(x, z).isLand ? land : water;
+}
+
+// World map texel: the chunk's map block, dimmed until the chunk was visited.
+// Visited chunks count their water columns from the chunk heightmap.
+void fillWorldMapChunk(int cx, int cz, uint32_t* texel) {
+    ChunkPos cp(cx, cz);
+    bool visited = visitedChunks.find(cp) != visitedChunks.end();
+    int blockType;
+    if (visited) {
+        ChunkHeightmap heightmap = getChunkHeightmap(cx, cz);
+        int waterCount = 0;
+        for (int x = 0; x < CHUNK_SIZE; x++)
+            for (int z = 0; z < CHUNK_SIZE; z++)
+                if (!heightmap.get(x, z).isLand)
+                    waterCount++;
+        if (waterCount > 5)
+            blockType = 1;
+        else
+            blockType = (cx >= 200) ? 22 : ((cz <= -256) ? 23 : 0);
+    }
+    else {
+        blockType = getCachedChunkTopBlock(cx, cz);
+    }
+    glm::vec3 col = mapBlockColor(blockType);
+    if (!visited && blockType != 1)
+        col *= 0.5f;
+    texel[0] = packMapColor(col);
+}
+
 // ---------------------- Minimap Rendering ----------------------
-void renderMinimap(GLuint minimapShaderProgram, GLuint minimapVAO, GLuint minimapVBO) {
+void drawMapQuad(GLuint mapShaderProgram, GLuint minimapVAO, GLuint minimapVBO, const MapRing& ring,
+                 const glm::mat4& ortho, float minX, float minZ, float maxX, float maxZ) {
+    glm::vec2 quad[6] = {
+        glm::vec2(minX, minZ), glm::vec2(maxX, minZ), glm::vec2(maxX, maxZ),
+        glm::vec2(minX, minZ), glm::vec2(maxX, maxZ), glm::vec2(minX, maxZ)
+    };
+    static GLint orthoLoc = glGetUniformLocation(mapShaderProgram, "ortho");
+    static GLint ringWorldSizeLoc = glGetUniformLocation(mapShaderProgram, "ringWorldSize");
+    static GLint mapTextureLoc = glGetUniformLocation(mapShaderProgram, "mapTexture");
+    glUseProgram(mapShaderProgram);
+    glUniformMatrix4fv(orthoLoc, 1, GL_FALSE, glm::value_ptr(ortho));
+    glUniform1f(ringWorldSizeLoc, ring.worldSize());
+    glUniform1i(mapTextureLoc, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, ring.texture);
+    glBindVertexArray(minimapVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, minimapVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void renderMinimap(GLuint minimapShaderProgram, GLuint mapShaderProgram, GLuint minimapVAO, GLuint minimapVBO) {
+    // Colour changes land in the world map even while it is hidden.
+    for (const ChunkPos& cp : mapDirtyChunks)
+        worldMapRing.refreshChunk(cp.x, cp.z, fillWorldMapChunk);
+    mapDirtyChunks.clear();
     if (!minimapEnabled)
         return;
 
     if (!fullscreenMap) {
-        static double lastMapUpdateTime = 0.0;
-        static std::vector<float> cachedInterleaved;
-        double currentTime = glfwGetTime();
-        const float region = 96.0f;
-        if (currentTime - lastMapUpdateTime > 1.0 || cachedInterleaved.empty()) {
-            lastMapUpdateTime = currentTime;
-            std::vector<glm::vec2> vertices;
-            std::vector<glm::vec3> colors;
-            int startX = static_cast<int>(cameraPos.x - region);
-            int endX = static_cast<int>(cameraPos.x + region);
-            int startZ = static_cast<int>(cameraPos.z - region);
-            int endZ = static_cast<int>(cameraPos.z + region);
-            for (int z = startZ; z < endZ; z++) {
-                for (int x = startX; x < endX; x++) {
-                    TerrainPoint tp = getTerrainHeight(x + 0.5, z + 0.5);
-                    int blockType;
-                    if (!tp.isLand)
-                        blockType = 1;
-                    else {
-                        int cx = x / CHUNK_SIZE;
-                        int cz = z / CHUNK_SIZE;
-                        if (cx >= 120)
-                            blockType = 22;
-                        else if (cz <= -40)
-                            blockType = 23;
-                        else
-                            blockType = 0;
-                    }
-                    vertices.push_back(glm::vec2(x, z));
-                    vertices.push_back(glm::vec2(x + CHUNK_SIZE, z));
-                    vertices.push_back(glm::vec2(x + CHUNK_SIZE, z + CHUNK_SIZE));
-                    vertices.push_back(glm::vec2(x, z));
-                    vertices.push_back(glm::vec2(x + CHUNK_SIZE, z + CHUNK_SIZE));
-                    vertices.push_back(glm::vec2(x, z + CHUNK_SIZE));
-                    glm::vec3 col;
-                    switch (blockType) {
-                    case 0:  col = glm::vec3(0.19f, 0.66f, 0.32f); break;
-                    case 1:  col = glm::vec3(0.0f, 0.5f, 0.5f); break;
-                    case 22: col = glm::vec3(0.93f, 0.79f, 0.69f); break;
-                    case 23: col = glm::vec3(0.95f, 0.95f, 1.0f); break;
-                    default: col = glm::vec3(1.0f); break;
-                    }
-                    for (int i = 0; i < 6; i++)
-                        colors.push_back(col);
-                }
-            }
-            cachedInterleaved.clear();
-            for (size_t i = 0; i < vertices.size(); i++) {
-                cachedInterleaved.push_back(vertices[i].x);
-                cachedInterleaved.push_back(vertices[i].y);
-                cachedInterleaved.push_back(colors[i].r);
-                cachedInterleaved.push_back(colors[i].g);
-                cachedInterleaved.push_back(colors[i].b);
-            }
-        }
+        const float region = MINIMAP_REGION;
+        float minX = cameraPos.x - region, maxX = cameraPos.x + region;
+        float minZ = cameraPos.z - region, maxZ = cameraPos.z + region;
+        minimapRing.setWindow(
+            static_cast<int>(std::floor(minX / CHUNK_SIZE)), static_cast<int>(std::floor(minZ / CHUNK_SIZE)),
+            static_cast<int>(std::floor(maxX / CHUNK_SIZE)), static_cast<int>(std::floor(maxZ / CHUNK_SIZE)),
+            fillMinimapChunk);
         glViewport(WINDOW_WIDTH - 200, WINDOW_HEIGHT - 200, 200, 200);
-        glm::mat4 ortho = glm::ortho((float)(cameraPos.x - region), (float)(cameraPos.x + region),
-            (float)(cameraPos.z - region), (float)(cameraPos.z + region),
-            -1.0f, 1.0f);
-        glUseProgram(minimapShaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(minimapShaderProgram, "ortho"), 1, GL_FALSE, glm::value_ptr(ortho));
-        glBindBuffer(GL_ARRAY_BUFFER, minimapVBO);
-        glBufferData(GL_ARRAY_BUFFER, cachedInterleaved.size() * sizeof(float), cachedInterleaved.data(), GL_DYNAMIC_DRAW);
-        glBindVertexArray(minimapVAO);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glDrawArrays(GL_TRIANGLES, 0, cachedInterleaved.size() / 5);
+        glm::mat4 ortho = glm::ortho(minX, maxX, minZ, maxZ, -1.0f, 1.0f);
+        drawMapQuad(mapShaderProgram, minimapVAO, minimapVBO, minimapRing, ortho, minX, minZ, maxX, maxZ);
         glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
     }
     else {
-        if (bigMapDirty) {
-            bigMapInterleaved.clear();
-            std::vector<glm::vec2> vertices;
-            std::vector<glm::vec3> colors;
-            int regionChunks = 400;
-            int halfRegion = regionChunks / 2;
-            int centerChunkX = static_cast<int>(round(bigMapPanX / CHUNK_SIZE));
-            int centerChunkZ = static_cast<int>(round(bigMapPanZ / CHUNK_SIZE));
-            int startChunkX = centerChunkX - halfRegion;
-            int endChunkX = centerChunkX + halfRegion;
-            int startChunkZ = centerChunkZ - halfRegion;
-            int endChunkZ = centerChunkZ + halfRegion;
-            for (int cz = startChunkZ; cz < endChunkZ; cz++) {
-                for (int cx = startChunkX; cx < endChunkX; cx++) {
-                    ChunkPos cp(cx, cz);
-                    int blockType;
-                    if (chunks.find(cp) != chunks.end()) {
-                        Chunk& ch = chunks[cp];
-                        int waterCount = 0;
-                        for (const auto& pos : ch.waterPositions) {
-                            if (std::abs(pos.y - 0.0f) < 0.1f)
-                                waterCount++;
-                        }
-                        if (waterCount > 5)
-                            blockType = 1;
-                        else if (!ch.sandPositions.empty())
-                            blockType = 22;
-                        else if (!ch.snowPositions.empty())
-                            blockType = 23;
-                        else
-                            blockType = 0;
-                    }
-                    else {
-                        blockType = getChunkTopBlock(cx, cz);
-                    }
-                    bool visited = (visitedChunks.find(cp) != visitedChunks.end());
-                    glm::vec3 col;
-                    switch (blockType) {
-                    case 0:  col = glm::vec3(0.19f, 0.66f, 0.32f); break;
-                    case 1:  col = glm::vec3(0.0f, 0.5f, 0.5f); break;
-                    case 22: col = glm::vec3(0.93f, 0.79f, 0.69f); break;
-                    case 23: col = glm::vec3(0.95f, 0.95f, 1.0f); break;
-                    default: col = glm::vec3(1.0f); break;
-                    }
-                    if (!visited && blockType != 1)
-                        col *= 0.5f;
-                    int startX = cx * CHUNK_SIZE;
-                    int startZ = cz * CHUNK_SIZE;
-                    vertices.push_back(glm::vec2(startX, startZ));
-                    vertices.push_back(glm::vec2(startX + CHUNK_SIZE, startZ));
-                    vertices.push_back(glm::vec2(startX + CHUNK_SIZE, startZ + CHUNK_SIZE));
-                    vertices.push_back(glm::vec2(startX, startZ));
-                    vertices.push_back(glm::vec2(startX + CHUNK_SIZE, startZ + CHUNK_SIZE));
-                    vertices.push_back(glm::vec2(startX, startZ + CHUNK_SIZE));
-                    for (int i = 0; i < 6; i++)
-                        colors.push_back(col);
-                }
-            }
-            bigMapInterleaved.clear();
-            for (size_t i = 0; i < vertices.size(); i++) {
-                bigMapInterleaved.push_back(vertices[i].x);
-                bigMapInterleaved.push_back(vertices[i].y);
-                bigMapInterleaved.push_back(colors[i].r);
-                bigMapInterleaved.push_back(colors[i].g);
-                bigMapInterleaved.push_back(colors[i].b);
-            }
-            bigMapDirty = false;
-        }
         glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
-        int regionChunks = 400;
+        int regionChunks = WORLD_MAP_CHUNKS;
         int mapWidth = regionChunks * CHUNK_SIZE;
         int mapHeight = regionChunks * CHUNK_SIZE;
         float halfW = mapWidth / 2.0f;
         float halfH = mapHeight / 2.0f;
-        glm::mat4 ortho = glm::ortho(bigMapPanX - halfW, bigMapPanX + halfW, bigMapPanZ - halfH, bigMapPanZ + halfH, -1.0f, 1.0f);
+        float minX = bigMapPanX - halfW, maxX = bigMapPanX + halfW;
+        float minZ = bigMapPanZ - halfH, maxZ = bigMapPanZ + halfH;
+        worldMapRing.setWindow(
+            static_cast<int>(std::floor(minX / CHUNK_SIZE)), static_cast<int>(std::floor(minZ / CHUNK_SIZE)),
+            static_cast<int>(std::floor(maxX / CHUNK_SIZE)), static_cast<int>(std::floor(maxZ / CHUNK_SIZE)),
+            fillWorldMapChunk);
+        glm::mat4 ortho = glm::ortho(minX, maxX, minZ, maxZ, -1.0f, 1.0f);
+        drawMapQuad(mapShaderProgram, minimapVAO, minimapVBO, worldMapRing, ortho, minX, minZ, maxX, maxZ);
+
+        // Overlays use the flat-colour minimap program; the colour is the
+        // generic value of attribute 1, which these line draws leave disabled.
         glUseProgram(minimapShaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(minimapShaderProgram, "ortho"), 1, GL_FALSE, glm::value_ptr(ortho));
-        glBindBuffer(GL_ARRAY_BUFFER, minimapVBO);
-        glBufferData(GL_ARRAY_BUFFER, bigMapInterleaved.size() * sizeof(float), bigMapInterleaved.data(), GL_DYNAMIC_DRAW);
-        glBindVertexArray(minimapVAO);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        glDrawArrays(GL_TRIANGLES, 0, bigMapInterleaved.size() / 5);
+        static GLint overlayOrthoLoc = glGetUniformLocation(minimapShaderProgram, "ortho");
+        glUniformMatrix4fv(overlayOrthoLoc, 1, GL_FALSE, glm::value_ptr(ortho));
+        glDisableVertexAttribArray(1);
         std::vector<glm::vec2> gridVerts;
         for (int x = static_cast<int>(bigMapPanX - halfW); x <= static_cast<int>(bigMapPanX + halfW); x += CHUNK_SIZE) {
             gridVerts.push_back(glm::vec2(x, bigMapPanZ - halfH));
@@ -2179,7 +4960,7 @@ void renderMinimap(GLuint minimapShaderProgram, GLuint minimapVAO, GLuint minima
             gridVerts.push_back(glm::vec2(bigMapPanX - halfW, z));
             gridVerts.push_back(glm::vec2(bigMapPanX + halfW, z));
         }
-        glUniform3f(glGetUniformLocation(minimapShaderProgram, "ourColor"), 0.3f, 0.3f, 0.3f);
+        glVertexAttrib3f(1, 0.3f, 0.3f, 0.3f);
         glBufferData(GL_ARRAY_BUFFER, gridVerts.size() * sizeof(glm::vec2), gridVerts.data(), GL_DYNAMIC_DRAW);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
         glEnableVertexAttribArray(0);
@@ -2204,7 +4985,7 @@ void renderMinimap(GLuint minimapShaderProgram, GLuint minimapVAO, GLuint minima
         glBufferData(GL_ARRAY_BUFFER, arrowVerts.size() * sizeof(glm::vec2), arrowVerts.data(), GL_DYNAMIC_DRAW);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
         glEnableVertexAttribArray(0);
-        glUniform3f(glGetUniformLocation(minimapShaderProgram, "ourColor"), 1.0f, 0.0f, 0.0f);
+        glVertexAttrib3f(1, 1.0f, 0.0f, 0.0f);
         glDrawArrays(GL_LINE_STRIP, 0, arrowVerts.size());
         std::vector<glm::vec2> spawnVerts = {
             glm::vec2(-5.0f, 0.0f), glm::vec2(5.0f, 0.0f),
@@ -2213,13 +4994,26 @@ void renderMinimap(GLuint minimapShaderProgram, GLuint minimapVAO, GLuint minima
         glBufferData(GL_ARRAY_BUFFER, spawnVerts.size() * sizeof(glm::vec2), spawnVerts.data(), GL_DYNAMIC_DRAW);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
         glEnableVertexAttribArray(0);
-        glUniform3f(glGetUniformLocation(minimapShaderProgram, "ourColor"), 1.0f, 1.0f, 1.0f);
+        glVertexAttrib3f(1, 1.0f, 1.0f, 1.0f);
         glDrawArrays(GL_LINES, 0, spawnVerts.size());
     }
 }
 
 // ---------------------- Main Function ----------------------
-int main() {
+int main(int argc, char** argv) {
+    bool nullRender = false;
+    const char* benchOut = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--bench") == 0)
+            benchmarkMode = true;
+        else if (std::strcmp(argv[i], "--null-render") == 0)
+            benchmarkMode = nullRender = true;
+        else if (std::strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc)
+            benchOut = argv[++i];
+    }
+    if (nullRender)
+        return runNullRenderBenchmark(benchOut);
+
     // Generate star positions
     std::vector<glm::vec3> starPositions = generateStarPositions(numStars);
 
@@ -2230,9 +5024,16 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
-    GLFWwindow* window = glfwCreateWindow(mode->width, mode->height, "Minecraft Clone", primaryMonitor, nullptr);
+    GLFWwindow* window;
+    if (benchmarkMode) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Minecraft Clone (benchmark)", nullptr, nullptr);
+    }
+    else {
+        GLFWmonitor* primaryMonitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
+        window = glfwCreateWindow(mode->width, mode->height, "Minecraft Clone", primaryMonitor, nullptr);
+    }
 
     if (!window) {
         std::cout << "Failed to create GLFW window\n";
@@ -2240,6 +5041,8 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    if (benchmarkMode)
+        glfwSwapInterval(0);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
@@ -2250,52 +5053,42 @@ int main() {
     }
     // Compile shader programs
     GLuint shaderProgram = compileShaderProgram(vertexShaderSource, fragmentShaderSource);
+    GLuint terrainShaderProgram = compileShaderProgram(terrainVertexShaderSource, fragmentShaderSource);
     GLuint minimapShaderProgram = compileShaderProgram(minimapVertexShaderSource, minimapFragmentShaderSource);
+    GLuint mapShaderProgram = compileShaderProgram(mapVertexShaderSource, mapFragmentShaderSource);
+    GLuint lodShaderProgram = compileShaderProgram(lodVertexShaderSource, lodFragmentShaderSource);
     GLuint skyboxShaderProgram = compileShaderProgram(skyboxVertexShaderSource, skyboxFragmentShaderSource);
     sunMoonShaderProgram = compileShaderProgram(sunMoonVertexShaderSource, sunMoonFragmentShaderSource);
     setupSkyboxQuad();
     setupSunMoonQuad();
 
-    // Setup VAOs/VBOs for scene geometry (a lot of them)...
-    GLuint VAO, redVAO, waterVAO, grassVAO, treeTrunkVAO, treeLeafVAO, waterLilyVAO, fallenTreeVAO, firLeafVAO;
-    GLuint oakTrunkVAO, oakLeafVAO, leafPileVAO, bushSmallVAO, bushMediumVAO, bushLargeVAO;
-    GLuint ancientTrunkVAO, ancientLeafVAO;
-    GLuint branchVAO, ancientBranchVAO;
-    GLuint dirtVAO, deepStoneVAO, lavaVAO, sandVAO, snowVAO, iceVAO;
+    SceneUniforms blockUniforms = locateSceneUniforms(shaderProgram);
+    SceneUniforms terrainUniforms = locateSceneUniforms(terrainShaderProgram);
+    SceneUniforms lodUniforms = locateSceneUniforms(lodShaderProgram);
+    GLuint starShaderProgram = compileShaderProgram(starVertexShaderSource, starFragmentShaderSource);
+    GLint starTimeLoc = glGetUniformLocation(starShaderProgram, "time");
+    GLint starViewLoc = glGetUniformLocation(starShaderProgram, "view");
+    GLint starProjectionLoc = glGetUniformLocation(starShaderProgram, "projection");
+
+    // Setup VAOs/VBOs for scene geometry: one VAO for every instanced block
+    // type (the type travels with each instance), one for the rotated ground
+    // branches and a plain cube for single draws.
+    GLuint VAO, redVAO, blockVAO, branchVAO;
     GLuint minimapVAO, minimapVBO;
     glGenVertexArrays(1, &VAO);
     glGenVertexArrays(1, &redVAO);
-    glGenVertexArrays(1, &waterVAO);
-    glGenVertexArrays(1, &grassVAO);
-    glGenVertexArrays(1, &treeTrunkVAO);
-    glGenVertexArrays(1, &treeLeafVAO);
-    glGenVertexArrays(1, &waterLilyVAO);
-    glGenVertexArrays(1, &fallenTreeVAO);
-    glGenVertexArrays(1, &firLeafVAO);
-    glGenVertexArrays(1, &oakTrunkVAO);
-    glGenVertexArrays(1, &oakLeafVAO);
-    glGenVertexArrays(1, &leafPileVAO);
-    glGenVertexArrays(1, &bushSmallVAO);
-    glGenVertexArrays(1, &bushMediumVAO);
-    glGenVertexArrays(1, &bushLargeVAO);
-    glGenVertexArrays(1, &ancientTrunkVAO);
-    glGenVertexArrays(1, &ancientLeafVAO);
+    glGenVertexArrays(1, &blockVAO);
     glGenVertexArrays(1, &branchVAO);
-    glGenVertexArrays(1, &ancientBranchVAO);
-    glGenVertexArrays(1, &dirtVAO);
-    glGenVertexArrays(1, &deepStoneVAO);
-    glGenVertexArrays(1, &lavaVAO);
-    glGenVertexArrays(1, &sandVAO);
-    glGenVertexArrays(1, &snowVAO);
-    glGenVertexArrays(1, &iceVAO);
     glGenVertexArrays(1, &minimapVAO);
     glGenBuffers(1, &minimapVBO);
+    minimapRing.create(16, CHUNK_SIZE);
+    worldMapRing.create(512, 1);
+    initLodTerrain();
     GLuint VBO, instanceVBO;
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &instanceVBO);
-    GLuint branchInstanceVBO, ancientBranchInstanceVBO;
+    GLuint branchInstanceVBO;
     glGenBuffers(1, &branchInstanceVBO);
-    glGenBuffers(1, &ancientBranchInstanceVBO);
     // --- Star VAO and VBO Setup ---
     GLuint starVAO, starVBO;
     glGenVertexArrays(1, &starVAO);
@@ -2320,34 +5113,17 @@ int main() {
         glEnableVertexAttribArray(2);
         if (instanced) {
             glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
             glEnableVertexAttribArray(3);
             glVertexAttribDivisor(3, 1);
+            glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(sizeof(glm::vec3)));
+            glEnableVertexAttribArray(5);
+            glVertexAttribDivisor(5, 1);
         }
         };
     setupVAOFunc(VAO, false);
     setupVAOFunc(redVAO, false);
-    setupVAOFunc(waterVAO, true);
-    setupVAOFunc(grassVAO, true);
-    setupVAOFunc(treeTrunkVAO, true);
-    setupVAOFunc(treeLeafVAO, true);
-    setupVAOFunc(waterLilyVAO, true);
-    setupVAOFunc(fallenTreeVAO, true);
-    setupVAOFunc(firLeafVAO, true);
-    setupVAOFunc(oakTrunkVAO, true);
-    setupVAOFunc(oakLeafVAO, true);
-    setupVAOFunc(leafPileVAO, true);
-    setupVAOFunc(bushSmallVAO, true);
-    setupVAOFunc(bushMediumVAO, true);
-    setupVAOFunc(bushLargeVAO, true);
-    setupVAOFunc(ancientTrunkVAO, true);
-    setupVAOFunc(ancientLeafVAO, true);
-    setupVAOFunc(dirtVAO, true);
-    setupVAOFunc(deepStoneVAO, true);
-    setupVAOFunc(lavaVAO, true);
-    setupVAOFunc(sandVAO, true);
-    setupVAOFunc(snowVAO, true);
-    setupVAOFunc(iceVAO, true);
+    setupVAOFunc(blockVAO, true);
 
     glBindVertexArray(branchVAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -2366,33 +5142,70 @@ int main() {
     glEnableVertexAttribArray(4);
     glVertexAttribDivisor(4, 1);
 
-    glBindVertexArray(ancientBranchVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glGenVertexArrays(1, &terrainVAO);
+    glGenBuffers(1, &quadIndexBuffer);
+    glBindVertexArray(terrainVAO);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ARRAY_BUFFER, ancientBranchInstanceVBO);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(3);
-    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
+
+    glm::vec3 blockColors[25];
+    blockColors[0] = glm::vec3(0.19f, 0.66f, 0.32f);
+    blockColors[1] = glm::vec3(0.0f, 0.5f, 1.0f);
+    blockColors[2] = glm::vec3(0.29f, 0.21f, 0.13f);
+    blockColors[3] = glm::vec3(0.07f, 0.46f, 0.34f);
+    blockColors[4] = glm::vec3(1.0f, 0.0f, 0.0f);
+    blockColors[5] = glm::vec3(0.2f, 0.7f, 0.2f);
+    blockColors[6] = glm::vec3(0.45f, 0.22f, 0.07f);
+    blockColors[7] = glm::vec3(0.13f, 0.54f, 0.13f);
+    blockColors[8] = glm::vec3(0.55f, 0.27f, 0.07f);
+    blockColors[9] = glm::vec3(0.36f, 0.6f, 0.33f);
+    blockColors[10] = glm::vec3(0.44f, 0.39f, 0.32f);
+    blockColors[11] = glm::vec3(0.35f, 0.43f, 0.30f);
+    blockColors[12] = glm::vec3(0.52f, 0.54f, 0.35f);
+    blockColors[13] = glm::vec3(0.6f, 0.61f, 0.35f);
+    blockColors[14] = glm::vec3(0.4f, 0.3f, 0.2f);
+    blockColors[15] = glm::vec3(0.43f, 0.39f, 0.34f);
+    blockColors[16] = glm::vec3(0.4f, 0.25f, 0.1f);
+    blockColors[17] = glm::vec3(0.2f, 0.5f, 0.2f);
+    blockColors[18] = glm::vec3(0.3f, 0.2f, 0.1f);
+    blockColors[19] = glm::vec3(1.0f, 1.0f, 1.0f);
+    blockColors[20] = glm::vec3(0.5f, 0.5f, 0.5f);
+    blockColors[21] = glm::vec3(1.0f, 0.5f, 0.0f);
+    blockColors[22] = glm::vec3(0.93f, 0.79f, 0.69f);
+    blockColors[23] = glm::vec3(0.95f, 0.95f, 1.0f);
+    blockColors[24] = glm::vec3(0.8f, 0.9f, 1.0f);
+    // The palette is constant, so it is uploaded once per program.
+    glUseProgram(shaderProgram);
+    glUniform3fv(blockUniforms.blockColors, 25, glm::value_ptr(blockColors[0]));
+    glUseProgram(terrainShaderProgram);
+    glUniform3fv(terrainUniforms.blockColors, 25, glm::value_ptr(blockColors[0]));
+    glUseProgram(lodShaderProgram);
+    glUniform3fv(lodUniforms.blockColors, 25, glm::value_ptr(blockColors[0]));
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // ---------------------- Main Render Loop ----------------------
+    int benchFrame = 0;
     while (!glfwWindowShouldClose(window)) {
+        auto frameStart = std::chrono::steady_clock::now();
+        if (benchmarkMode && !benchCameraForFrame(benchFrame))
+            break;
 
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-        processInput(window);
-        toggleMapMode(window);
+        averageFrameMs += (deltaTime * 1000.0f - averageFrameMs) * 0.05f;
+        uint64_t noiseNow = noiseEvaluations.load(std::memory_order_relaxed);
+        averageNoisePerFrame += (static_cast<float>(noiseNow - lastFrameNoiseEvaluations) - averageNoisePerFrame) * 0.05f;
+        lastFrameNoiseEvaluations = noiseNow;
+        if (!benchmarkMode) {
+            processInput(window);
+            toggleMapMode(window);
+        }
         updateChunks();
+        auto renderStart = std::chrono::steady_clock::now();
         glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -2421,6 +5234,11 @@ int main() {
         time_t currentTimeT = time(0);
         tm localTimeInfo;
         localtime_s(&localTimeInfo, &currentTimeT);
+        if (benchmarkMode) {
+            localTimeInfo.tm_hour = 12;
+            localTimeInfo.tm_min = 0;
+            localTimeInfo.tm_sec = 0;
+        }
         int secondsSinceMidnight = localTimeInfo.tm_hour * 3600 + localTimeInfo.tm_min * 60 + localTimeInfo.tm_sec;
         float dayFraction = secondsSinceMidnight / 86400.0f;
         float angle = dayFraction * 2.0f * 3.14159f;
@@ -2469,15 +5287,13 @@ int main() {
         glBindVertexArray(0);
         glDepthMask(GL_TRUE);
         // --- Render Stars ---
-        GLuint starShaderProgram = compileShaderProgram(starVertexShaderSource, starFragmentShaderSource);
-
         glDepthMask(GL_FALSE); // So stars always render in the background
         glUseProgram(starShaderProgram);
-        glUniform1f(glGetUniformLocation(starShaderProgram, "time"), currentFrame);
+        glUniform1f(starTimeLoc, currentFrame);
 
-        glUniformMatrix4fv(glGetUniformLocation(starShaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewNoTranslation));
+        glUniformMatrix4fv(starViewLoc, 1, GL_FALSE, glm::value_ptr(viewNoTranslation));
 
-        glUniformMatrix4fv(glGetUniformLocation(starShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(starProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
         glBindVertexArray(starVAO);
         glDrawArrays(GL_POINTS, 0, starPositions.size());
         glBindVertexArray(0);
@@ -2545,165 +5361,113 @@ int main() {
 
         // --- Set up main scene shader ---
         glUseProgram(shaderProgram);
-        glUniform1f(glGetUniformLocation(shaderProgram, "time"), currentFrame);
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightDir"), 1, glm::value_ptr(sunDir));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "ambientLight"), 1, glm::value_ptr(ambientLightMain));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "diffuseLight"), 1, glm::value_ptr(diffuseLightMain));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "cameraPos"), 1, glm::value_ptr(cameraPos));
-
-        glm::vec3 blockColors[25];
-        blockColors[0] = glm::vec3(0.19f, 0.66f, 0.32f);
-        blockColors[1] = glm::vec3(0.0f, 0.5f, 1.0f);
-        blockColors[2] = glm::vec3(0.29f, 0.21f, 0.13f);
-        blockColors[3] = glm::vec3(0.07f, 0.46f, 0.34f);
-        blockColors[4] = glm::vec3(1.0f, 0.0f, 0.0f);
-        blockColors[5] = glm::vec3(0.2f, 0.7f, 0.2f);
-        blockColors[6] = glm::vec3(0.45f, 0.22f, 0.07f);
-        blockColors[7] = glm::vec3(0.13f, 0.54f, 0.13f);
-        blockColors[8] = glm::vec3(0.55f, 0.27f, 0.07f);
-        blockColors[9] = glm::vec3(0.36f, 0.6f, 0.33f);
-        blockColors[10] = glm::vec3(0.44f, 0.39f, 0.32f);
-        blockColors[11] = glm::vec3(0.35f, 0.43f, 0.30f);
-        blockColors[12] = glm::vec3(0.52f, 0.54f, 0.35f);
-        blockColors[13] = glm::vec3(0.6f, 0.61f, 0.35f);
-        blockColors[14] = glm::vec3(0.4f, 0.3f, 0.2f);
-        blockColors[15] = glm::vec3(0.43f, 0.39f, 0.34f);
-        blockColors[16] = glm::vec3(0.4f, 0.25f, 0.1f);
-        blockColors[17] = glm::vec3(0.2f, 0.5f, 0.2f);
-        blockColors[18] = glm::vec3(0.3f, 0.2f, 0.1f);
-        blockColors[19] = glm::vec3(1.0f, 1.0f, 1.0f);
-        blockColors[20] = glm::vec3(0.5f, 0.5f, 0.5f);
-        blockColors[21] = glm::vec3(1.0f, 0.5f, 0.0f);
-        blockColors[22] = glm::vec3(0.93f, 0.79f, 0.69f);
-        blockColors[23] = glm::vec3(0.95f, 0.95f, 1.0f);
-        blockColors[24] = glm::vec3(0.8f, 0.9f, 1.0f);
-        glUniform3fv(glGetUniformLocation(shaderProgram, "blockColors"), 25, glm::value_ptr(blockColors[0]));
+        glUniform1f(blockUniforms.time, currentFrame);
+        glUniform3fv(blockUniforms.lightDir, 1, glm::value_ptr(sunDir));
+        glUniform3fv(blockUniforms.ambientLight, 1, glm::value_ptr(ambientLightMain));
+        glUniform3fv(blockUniforms.diffuseLight, 1, glm::value_ptr(diffuseLightMain));
+        glUniformMatrix4fv(blockUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(blockUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform3fv(blockUniforms.cameraPos, 1, glm::value_ptr(cameraPos));
+        glUniformMatrix4fv(blockUniforms.model, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
 
         int playerChunkX = static_cast<int>(std::floor(cameraPos.x / CHUNK_SIZE));
         int playerChunkZ = static_cast<int>(std::floor(cameraPos.z / CHUNK_SIZE));
-        int qtMinX = playerChunkX - static_cast<int>(RENDER_DISTANCE);
-        int qtMaxX = playerChunkX + static_cast<int>(RENDER_DISTANCE);
-        int qtMinZ = playerChunkZ - static_cast<int>(RENDER_DISTANCE);
-        int qtMaxZ = playerChunkZ + static_cast<int>(RENDER_DISTANCE);
-        Quadtree qt(qtMinX, qtMinZ, qtMaxX, qtMaxZ);
-        for (auto& entry : chunks) {
-            const ChunkPos& pos = entry.first;
-            if (pos.x >= qtMinX && pos.x <= qtMaxX && pos.z >= qtMinZ && pos.z <= qtMaxZ)
-                qt.insert(pos, &entry.second);
-        }
-        std::vector<Chunk*> visibleChunks = qt.query(extractFrustumPlanes(projection * view));
-
-        std::vector<glm::vec3> globalGrassInstances;
-        std::vector<glm::vec3> globalSandInstances;
-        std::vector<glm::vec3> globalSnowInstances;
-        std::vector<glm::vec3> globalDirtInstances;
-        std::vector<glm::vec3> globalDeepStoneInstances;
-        std::vector<glm::vec3> globalWaterInstances;
-        std::vector<glm::vec3> globalIceInstances;
-        std::vector<glm::vec3> globalLavaInstances;
-        std::vector<glm::vec3> globalTreeTrunkInstances;
-        std::vector<glm::vec3> globalPineLeafInstances;
-        std::vector<glm::vec3> globalFirLeafInstances;
-        std::vector<glm::vec3> globalWaterLilyInstances;
-        std::vector<glm::vec3> globalFallenTreeTrunkInstances;
-        std::vector<glm::vec3> globalOakTrunkInstances;
-        std::vector<glm::vec3> globalOakLeafInstances;
-        std::vector<glm::vec3> globalLeafPileInstances;
-        std::vector<glm::vec3> globalBushSmallInstances;
-        std::vector<glm::vec3> globalBushMediumInstances;
-        std::vector<glm::vec3> globalBushLargeInstances;
-        std::vector<glm::vec3> globalAncientTrunkInstances;
-        std::vector<glm::vec3> globalAncientLeafInstances;
-        std::vector<glm::vec3> globalAncientBranchInstances;
-        std::vector<glm::vec4> globalBranchInstances;
-        std::vector<glm::vec3> globalAuroraInstances;
-        for (Chunk* chunk : visibleChunks) {
-            globalGrassInstances.insert(globalGrassInstances.end(), chunk->grassPositions.begin(), chunk->grassPositions.end());
-            globalSandInstances.insert(globalSandInstances.end(), chunk->sandPositions.begin(), chunk->sandPositions.end());
-            globalSnowInstances.insert(globalSnowInstances.end(), chunk->snowPositions.begin(), chunk->snowPositions.end());
-            globalDirtInstances.insert(globalDirtInstances.end(), chunk->dirtPositions.begin(), chunk->dirtPositions.end());
-            globalDeepStoneInstances.insert(globalDeepStoneInstances.end(), chunk->deepStonePositions.begin(), chunk->deepStonePositions.end());
-            globalWaterInstances.insert(globalWaterInstances.end(), chunk->waterPositions.begin(), chunk->waterPositions.end());
-            globalIceInstances.insert(globalIceInstances.end(), chunk->icePositions.begin(), chunk->icePositions.end());
-            globalLavaInstances.insert(globalLavaInstances.end(), chunk->lavaPositions.begin(), chunk->lavaPositions.end());
-            globalTreeTrunkInstances.insert(globalTreeTrunkInstances.end(), chunk->treeTrunkPositions.begin(), chunk->treeTrunkPositions.end());
-            globalPineLeafInstances.insert(globalPineLeafInstances.end(), chunk->treeLeafPositions.begin(), chunk->treeLeafPositions.end());
-            globalFirLeafInstances.insert(globalFirLeafInstances.end(), chunk->firLeafPositions.begin(), chunk->firLeafPositions.end());
-            globalWaterLilyInstances.insert(globalWaterLilyInstances.end(), chunk->waterLilyPositions.begin(), chunk->waterLilyPositions.end());
-            globalFallenTreeTrunkInstances.insert(globalFallenTreeTrunkInstances.end(), chunk->fallenTreeTrunkPositions.begin(), chunk->fallenTreeTrunkPositions.end());
-            globalOakTrunkInstances.insert(globalOakTrunkInstances.end(), chunk->oakTrunkPositions.begin(), chunk->oakTrunkPositions.end());
-            globalOakLeafInstances.insert(globalOakLeafInstances.end(), chunk->oakLeafPositions.begin(), chunk->oakLeafPositions.end());
-            globalLeafPileInstances.insert(globalLeafPileInstances.end(), chunk->leafPilePositions.begin(), chunk->leafPilePositions.end());
-            globalBushSmallInstances.insert(globalBushSmallInstances.end(), chunk->bushSmallPositions.begin(), chunk->bushSmallPositions.end());
-            globalBushMediumInstances.insert(globalBushMediumInstances.end(), chunk->bushMediumPositions.begin(), chunk->bushMediumPositions.end());
-            globalBushLargeInstances.insert(globalBushLargeInstances.end(), chunk->bushLargePositions.begin(), chunk->bushLargePositions.end());
-            globalAncientTrunkInstances.insert(globalAncientTrunkInstances.end(), chunk->ancientTrunkPositions.begin(), chunk->ancientTrunkPositions.end());
-            globalAncientLeafInstances.insert(globalAncientLeafInstances.end(), chunk->ancientLeafPositions.begin(), chunk->ancientLeafPositions.end());
-            globalAncientBranchInstances.insert(globalAncientBranchInstances.end(), chunk->ancientBranchPositions.begin(), chunk->ancientBranchPositions.end());
-            globalBranchInstances.insert(globalBranchInstances.end(), chunk->branchPositions.begin(), chunk->branchPositions.end());
-            globalAuroraInstances.insert(globalAuroraInstances.end(), chunk->auroraPositions.begin(), chunk->auroraPositions.end());
-        }
-        auto drawInstances = [&](GLuint vao, int blockType, const std::vector<glm::vec3>& instances) {
-            if (instances.empty()) return;
-            glUniform1i(glGetUniformLocation(shaderProgram, "blockType"), blockType);
-            glm::mat4 model = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(vao);
-            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_DYNAMIC_DRAW);
-            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(instances.size()));
-            };
-        auto drawBranchInstances = [&](GLuint vao, GLuint branchVBO, int blockType, const std::vector<glm::vec4>& instances) {
-            if (instances.empty()) return;
-            glUniform1i(glGetUniformLocation(shaderProgram, "blockType"), blockType);
-            glm::mat4 model = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(vao);
-            glBindBuffer(GL_ARRAY_BUFFER, branchVBO);
-            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec4), instances.data(), GL_DYNAMIC_DRAW);
-            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(instances.size()));
+        std::vector<Chunk*> visibleChunks = prepareVisibleChunks(projection * view, eyePos, true);
+        // Instanced blocks come from the chunk's runs (opaque, pine canopy,
+        // translucent), each section-major, so everything from the lowest
+        // visible section up is one draw per run. The translucent run waits
+        // until all opaque geometry is down.
+        int worldDrawCalls = 0;
+        int instancesDrawn = 0, quadsDrawn = 0;
+        auto drawChunkInstances = [&](int run) {
+            glBindVertexArray(blockVAO);
+            for (Chunk* chunk : visibleChunks) {
+                GLint first;
+                GLsizei count = visibleRunRange(*chunk, run, first);
+                if (count == 0)
+                    continue;
+                glBindBuffer(GL_ARRAY_BUFFER, chunk->instanceBuffer);
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(first * sizeof(glm::vec4)));
+                glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(first * sizeof(glm::vec4) + sizeof(glm::vec3)));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count);
+                worldDrawCalls++;
+                instancesDrawn += count;
+            }
             };
-        auto drawAncientBranchInstances = [&](GLuint vao, int blockType, const std::vector<glm::vec3>& instances) {
-            if (instances.empty()) return;
-            glUniform1i(glGetUniformLocation(shaderProgram, "blockType"), blockType);
-            glm::mat4 model = glm::mat4(1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(vao);
-            glBindBuffer(GL_ARRAY_BUFFER, ancientBranchInstanceVBO);
-            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_DYNAMIC_DRAW);
-            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(instances.size()));
+        auto drawBranchInstances = [&]() {
+            // The branch buffer carries a rotation instead of a type, so the
+            // type comes from the generic attribute value.
+            glVertexAttrib1f(5, static_cast<float>(14));
+            glBindVertexArray(branchVAO);
+            for (Chunk* chunk : visibleChunks) {
+                if (chunk->branchPositions.empty() || chunk->visibleSections == 0)
+                    continue;
+                glBindBuffer(GL_ARRAY_BUFFER, chunk->branchBuffer);
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+                glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(sizeof(glm::vec3)));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(chunk->branchPositions.size()));
+                worldDrawCalls++;
+                instancesDrawn += static_cast<int>(chunk->branchPositions.size());
+            }
             };
-        drawInstances(grassVAO, 0, globalGrassInstances);
-        drawInstances(sandVAO, 22, globalSandInstances);
-        drawInstances(snowVAO, 23, globalSnowInstances);
-        drawInstances(dirtVAO, 15, globalDirtInstances);
-        drawInstances(deepStoneVAO, 20, globalDeepStoneInstances);
-        drawInstances(waterVAO, 1, globalWaterInstances);
-        drawInstances(iceVAO, 24, globalIceInstances);
-        drawInstances(lavaVAO, 21, globalLavaInstances);
-        drawInstances(treeTrunkVAO, 2, globalTreeTrunkInstances);
-        if (playerChunkZ < 40)
-            drawInstances(treeLeafVAO, 3, globalPineLeafInstances);
-        drawInstances(firLeafVAO, 7, globalFirLeafInstances);
-        drawInstances(waterLilyVAO, 5, globalWaterLilyInstances);
-        drawInstances(fallenTreeVAO, 6, globalFallenTreeTrunkInstances);
-        drawInstances(oakTrunkVAO, 8, globalOakTrunkInstances);
-        drawInstances(oakLeafVAO, 9, globalOakLeafInstances);
-        drawInstances(leafPileVAO, 10, globalLeafPileInstances);
-        drawInstances(bushSmallVAO, 11, globalBushSmallInstances);
-        drawInstances(bushMediumVAO, 12, globalBushMediumInstances);
-        drawInstances(bushLargeVAO, 13, globalBushLargeInstances);
-        drawInstances(ancientTrunkVAO, 16, globalAncientTrunkInstances);
-        drawInstances(ancientLeafVAO, 17, globalAncientLeafInstances);
-        drawAncientBranchInstances(ancientBranchVAO, 18, globalAncientBranchInstances);
-        drawBranchInstances(branchVAO, branchInstanceVBO, 14, globalBranchInstances);
-        drawInstances(waterVAO, 19, globalAuroraInstances);
-        glUniform1i(glGetUniformLocation(shaderProgram, "blockType"), 4);
+        // Opaque terrain from the chunks' greedy meshes.
+        glUseProgram(terrainShaderProgram);
+        glUniform1f(terrainUniforms.time, currentFrame);
+        glUniform3fv(terrainUniforms.lightDir, 1, glm::value_ptr(sunDir));
+        glUniform3fv(terrainUniforms.ambientLight, 1, glm::value_ptr(ambientLightMain));
+        glUniform3fv(terrainUniforms.diffuseLight, 1, glm::value_ptr(diffuseLightMain));
+        glUniformMatrix4fv(terrainUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(terrainUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform3fv(terrainUniforms.cameraPos, 1, glm::value_ptr(cameraPos));
+        glBindVertexArray(terrainVAO);
+        for (Chunk* chunk : visibleChunks) {
+            if (chunk->meshQuadCount == 0 || chunk->visibleSections == 0)
+                continue;
+            glUniform3f(terrainUniforms.chunkOrigin, chunk->chunkX * CHUNK_SIZE - 0.5f, CHUNK_MIN_Y - 0.5f, chunk->chunkZ * CHUNK_SIZE - 0.5f);
+            glBindBuffer(GL_ARRAY_BUFFER, chunk->meshBuffer);
+            glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+            // One draw per run of visible sections; sections without quads
+            // do not break a run.
+            GLint runFirst = 0, runEnd = 0;
+            for (int s = 0; s <= SECTION_COUNT; s++) {
+                GLint first = chunk->sectionQuadStart[std::min(s, SECTION_COUNT)];
+                GLint end = (s < SECTION_COUNT) ? chunk->sectionQuadStart[s + 1] : first;
+                bool visible = s < SECTION_COUNT && ((chunk->visibleSections >> s) & 1);
+                if (end == first && s < SECTION_COUNT)
+                    continue;
+                if (visible && runEnd == first && runEnd > runFirst) {
+                    runEnd = end;
+                    continue;
+                }
+                if (runEnd > runFirst) {
+                    glDrawElements(GL_TRIANGLES, (runEnd - runFirst) * 6, GL_UNSIGNED_INT, (void*)(runFirst * 6 * sizeof(uint32_t)));
+                    worldDrawCalls++;
+                    quadsDrawn += runEnd - runFirst;
+                }
+                runFirst = first;
+                runEnd = visible ? end : first;
+            }
+        }
+        // Distant terrain beyond (and between) the loaded chunks.
+        glUseProgram(lodShaderProgram);
+        glUniform3fv(lodUniforms.lightDir, 1, glm::value_ptr(sunDir));
+        glUniform3fv(lodUniforms.ambientLight, 1, glm::value_ptr(ambientLightMain));
+        glUniform3fv(lodUniforms.diffuseLight, 1, glm::value_ptr(diffuseLightMain));
+        glUniformMatrix4fv(lodUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(lodUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform3fv(lodUniforms.cameraPos, 1, glm::value_ptr(cameraPos));
+        drawLodTerrain(lodShaderProgram, cameraPos, chunkPriorityFrustum, playerChunkX, playerChunkZ);
+        glUseProgram(shaderProgram);
+
+        drawChunkInstances(RUN_OPAQUE);
+        if (instanceRunDrawn(RUN_PINE, playerChunkZ))
+            drawChunkInstances(RUN_PINE);
+        drawBranchInstances();
+        drawChunkInstances(RUN_TRANSLUCENT);
+        glVertexAttrib1f(5, static_cast<float>(4));
         {
             glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(blockUniforms.model, 1, GL_FALSE, glm::value_ptr(model));
             glBindVertexArray(VAO);
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
@@ -2711,12 +5475,11 @@ int main() {
         if (selectedBlock.x != -10000) {
             glm::mat4 outlineModel = glm::translate(glm::mat4(1.0f), glm::vec3(selectedBlock));
             outlineModel = glm::scale(outlineModel, glm::vec3(1.05f));
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(outlineModel));
+            glUniformMatrix4fv(blockUniforms.model, 1, GL_FALSE, glm::value_ptr(outlineModel));
+            // Drawn as grass with the grass colour swapped for white.
             glm::vec3 outlineColor = glm::vec3(1.0f, 1.0f, 1.0f);
-            glm::vec3 oldBlockColor0 = blockColors[0];
-            blockColors[0] = outlineColor;
-            glUniform3fv(glGetUniformLocation(shaderProgram, "blockColors"), 25, glm::value_ptr(blockColors[0]));
-            glUniform1i(glGetUniformLocation(shaderProgram, "blockType"), 0);
+            glUniform3fv(blockUniforms.blockColors, 1, glm::value_ptr(outlineColor));
+            glVertexAttrib1f(5, static_cast<float>(BLOCK_GRASS));
             glDisable(GL_DEPTH_TEST);
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
             glLineWidth(2.0f);
@@ -2724,54 +5487,57 @@ int main() {
             glDrawArrays(GL_TRIANGLES, 0, 36);
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
             glEnable(GL_DEPTH_TEST);
-            blockColors[0] = oldBlockColor0;
-            glUniform3fv(glGetUniformLocation(shaderProgram, "blockColors"), 25, glm::value_ptr(blockColors[0]));
+            glUniform3fv(blockUniforms.blockColors, 1, glm::value_ptr(blockColors[0]));
         }
-        renderMinimap(minimapShaderProgram, minimapVAO, minimapVBO);
+        lastFrameDrawCalls = worldDrawCalls;
+        lastFrameInstancesDrawn = instancesDrawn;
+        lastFrameQuadsDrawn = quadsDrawn;
+        averageDrawCalls += (static_cast<float>(worldDrawCalls) - averageDrawCalls) * 0.05f;
+        averageRenderCpuMs += (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - renderStart).count() - averageRenderCpuMs) * 0.05f;
+        renderMinimap(minimapShaderProgram, mapShaderProgram, minimapVAO, minimapVBO);
         glfwSwapBuffers(window);
         glfwPollEvents();
+        if (benchmarkMode)
+            recordBenchFrame(benchFrame++, frameStart, lastFrameInstancesDrawn, lastFrameQuadsDrawn, lastFrameDrawCalls);
     }
+    int exitCode = 0;
+    if (benchmarkMode && !writeBenchReport("gl", benchOut))
+        exitCode = 1;
     glDeleteVertexArrays(1, &VAO);
     glDeleteVertexArrays(1, &redVAO);
-    glDeleteVertexArrays(1, &waterVAO);
-    glDeleteVertexArrays(1, &grassVAO);
-    glDeleteVertexArrays(1, &treeTrunkVAO);
-    glDeleteVertexArrays(1, &treeLeafVAO);
-    glDeleteVertexArrays(1, &waterLilyVAO);
-    glDeleteVertexArrays(1, &fallenTreeVAO);
-    glDeleteVertexArrays(1, &firLeafVAO);
-    glDeleteVertexArrays(1, &oakTrunkVAO);
-    glDeleteVertexArrays(1, &oakLeafVAO);
-    glDeleteVertexArrays(1, &leafPileVAO);
-    glDeleteVertexArrays(1, &bushSmallVAO);
-    glDeleteVertexArrays(1, &bushMediumVAO);
-    glDeleteVertexArrays(1, &bushLargeVAO);
-    glDeleteVertexArrays(1, &ancientTrunkVAO);
-    glDeleteVertexArrays(1, &ancientLeafVAO);
+    glDeleteVertexArrays(1, &blockVAO);
     glDeleteVertexArrays(1, &branchVAO);
-    glDeleteVertexArrays(1, &ancientBranchVAO);
-    glDeleteVertexArrays(1, &dirtVAO);
-    glDeleteVertexArrays(1, &deepStoneVAO);
-    glDeleteVertexArrays(1, &lavaVAO);
-    glDeleteVertexArrays(1, &sandVAO);
-    glDeleteVertexArrays(1, &snowVAO);
-    glDeleteVertexArrays(1, &iceVAO);
     glDeleteVertexArrays(1, &minimapVAO);
     glDeleteVertexArrays(1, &skyboxVAO);
     glDeleteBuffers(1, &VBO);
+    chunkWorkers.stop();
+    for (auto& entry : chunks) {
+        if (entry.second.needsSave && !benchmarkMode)
+            saveChunk(regionStore, entry.second);
+        releaseChunkBuffers(entry.second);
+    }
+    regionStore.closeAll();
     glDeleteBuffers(1, &instanceVBO);
     glDeleteBuffers(1, &branchInstanceVBO);
-    glDeleteBuffers(1, &ancientBranchInstanceVBO);
     glDeleteBuffers(1, &minimapVBO);
     glDeleteBuffers(1, &skyboxVBO);
     glDeleteBuffers(1, &sunMoonVBO);
     glDeleteVertexArrays(1, &sunMoonVAO);
     glDeleteProgram(shaderProgram);
+    glDeleteProgram(terrainShaderProgram);
+    glDeleteProgram(starShaderProgram);
+    glDeleteVertexArrays(1, &terrainVAO);
+    glDeleteBuffers(1, &quadIndexBuffer);
     glDeleteProgram(minimapShaderProgram);
+    glDeleteProgram(mapShaderProgram);
+    minimapRing.destroy();
+    worldMapRing.destroy();
+    destroyLodTerrain();
+    glDeleteProgram(lodShaderProgram);
     glDeleteProgram(skyboxShaderProgram);
     glDeleteProgram(sunMoonShaderProgram);
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
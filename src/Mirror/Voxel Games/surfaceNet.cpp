@@ -12,10 +12,19 @@
 #include <algorithm>
 #include <random>
 #include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 // --- FPS Meter Variables ---
 double fps_last_time = 0.0;
 int fps_frames = 0;
+int edit_count = 0;
+double edit_ms_total = 0.0, edit_ms_max = 0.0;
 
 // --- END FPS Meter Variables ---
 
@@ -127,27 +136,56 @@ struct Vertex {
     float thickness;
 };
 
+// Chunks are meshed in SUB_SIZE^3 sub-blocks so an edit only remeshes the few
+// it touches. Each sub-block owns a slot in the chunk's vertex and index
+// buffers, sized with room to grow, and is patched in place.
+constexpr int SUB_SIZE = 8;
+constexpr int SUBS_PER_AXIS = CHUNK_SIZE / SUB_SIZE;
+constexpr int SUB_COUNT = SUBS_PER_AXIS * SUBS_PER_AXIS * SUBS_PER_AXIS;
+constexpr uint64_t ALL_SUBS = SUB_COUNT == 64 ? ~uint64_t(0) : (uint64_t(1) << SUB_COUNT) - 1;
+static_assert(CHUNK_SIZE % SUB_SIZE == 0 && SUB_COUNT <= 64, "sub-blocks must tile the chunk and fit the dirty mask");
+inline int sub_index(int sx, int sy, int sz) { return sx + SUBS_PER_AXIS * (sy + SUBS_PER_AXIS * sz); }
+
+struct SubMeshSlot {
+    uint32_t vert_offset = 0, vert_capacity = 0;
+    uint32_t index_offset = 0, index_capacity = 0, index_count = 0;
+};
+
 struct Chunk {
     ChunkKey key;
     VoxelGrid voxels;
-    std::vector<Vertex> verts;
+    std::array<SubMeshSlot, SUB_COUNT> subs;
     GLuint vbo = 0;
-    size_t vert_count = 0;
+    GLuint ebo = 0;
+    size_t index_count = 0;
+    // One glMultiDrawElements range per non-empty slot.
+    std::array<GLsizei, SUB_COUNT> draw_counts;
+    std::array<const void*, SUB_COUNT> draw_offsets;
+    GLsizei draw_ranges = 0;
+    uint64_t dirty_subs = 0; // sub-blocks to patch; `dirty` lays out the whole chunk again
+    uint32_t ticket = 0;     // tells this load of the chunk from earlier ones still in the pipeline
+    bool generated = false;  // voxels filled in; until then the grid is empty
+    bool meshing = false;    // a mesh job for it is in flight
     bool meshed = false;
     bool dirty = true;
 
-    Chunk() : key{ 0,0,0 }, voxels(), verts(), vbo(0), vert_count(0), meshed(false), dirty(true) {}
+    Chunk() : key{ 0,0,0 }, voxels(), subs(), vbo(0), ebo(0), index_count(0), draw_ranges(0), dirty_subs(0),
+        ticket(0), generated(false), meshing(false), meshed(false), dirty(true) {}
     Chunk(const ChunkKey& k)
         : key(k),
         voxels(k.x* CHUNK_SIZE, k.x* CHUNK_SIZE + CHUNK_SIZE - 1,
             k.y* CHUNK_SIZE, k.y* CHUNK_SIZE + CHUNK_SIZE - 1,
             k.z* CHUNK_SIZE, k.z* CHUNK_SIZE + CHUNK_SIZE - 1),
-        vbo(0), vert_count(0), meshed(false), dirty(true) {
+        subs(), vbo(0), ebo(0), index_count(0), draw_ranges(0), dirty_subs(0),
+        ticket(0), generated(false), meshing(false), meshed(false), dirty(true) {
     }
 };
 
 // --- SURFACE NETS MESHING IMPLEMENTATION ---
-void surface_nets_mesh(const VoxelGrid& grid, std::vector<Vertex>& verts) {
+// The original per-cell mesher, kept as the baseline for --bench-mesh: it looks
+// every corner up through VoxelGrid::get, emits the cell's own faces as six
+// unindexed vertices per quad and stops one cell short of the chunk border.
+void surface_nets_mesh_reference(const VoxelGrid& grid, std::vector<Vertex>& verts) {
     static const std::array<std::array<int, 3>, 8> corners = { {
         {0,0,0},{1,0,0},{1,1,0},{0,1,0},
         {0,0,1},{1,0,1},{1,1,1},{0,1,1}
@@ -258,6 +296,108 @@ void main() {
     f = vec4(0,0,0,alpha);
 })";
 
+// Samples a chunk is meshed from: its 16^3 voxels plus a one-voxel apron on
+// every side, so the cells straddling a chunk border are meshed too.
+constexpr int APRON_SIZE = CHUNK_SIZE + 2;
+constexpr int APRON_VOLUME = APRON_SIZE * APRON_SIZE * APRON_SIZE;
+inline int apron_index(int x, int y, int z) { return (x + 1) + APRON_SIZE * ((y + 1) + APRON_SIZE * (z + 1)); }
+
+// Vertex placement per corner mask (bit i = corner i of the cell solid, corners
+// as in surface_nets_mesh_reference): the mean of the midpoints of the cell
+// edges the surface crosses, and the normal pointing from the solid corners
+// to the empty ones.
+struct SurfaceNetCase {
+    glm::vec3 offset;
+    glm::vec3 normal;
+};
+
+const std::array<SurfaceNetCase, 256>& surface_net_cases() {
+    static const std::array<SurfaceNetCase, 256> cases = [] {
+        static const int corner[8][3] = { {0,0,0},{1,0,0},{1,1,0},{0,1,0},{0,0,1},{1,0,1},{1,1,1},{0,1,1} };
+        std::array<SurfaceNetCase, 256> table{};
+        for (int mask = 1; mask < 255; ++mask) {
+            glm::vec3 sum(0), normal(0);
+            int crossings = 0;
+            for (int i = 0; i < 8; ++i) {
+                glm::vec3 ci(corner[i][0], corner[i][1], corner[i][2]);
+                normal += (ci - glm::vec3(0.5f)) * ((mask >> i) & 1 ? -1.0f : 1.0f);
+                for (int j = i + 1; j < 8; ++j) {
+                    int differ = (corner[i][0] != corner[j][0]) + (corner[i][1] != corner[j][1]) + (corner[i][2] != corner[j][2]);
+                    if (differ == 1 && ((mask >> i) & 1) != ((mask >> j) & 1)) {
+                        sum += (ci + glm::vec3(corner[j][0], corner[j][1], corner[j][2])) * 0.5f;
+                        crossings++;
+                    }
+                }
+            }
+            table[mask].offset = sum / float(crossings);
+            table[mask].normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0, 1, 0);
+        }
+        return table;
+    }();
+    return cases;
+}
+
+// Surface nets over apron samples (1 = solid) for the cells in [lo, hi) of a
+// chunk; [0, CHUNK_SIZE) meshes all of it. Corner masks come from two sliding
+// z slices of per-(x, y) corner bits, each active cell gets one shared vertex,
+// and every sign-changing sample edge at a cell's minimum corner becomes a quad
+// over the four cells around it. Cells at lo - 1 on any axis only supply
+// vertices to those quads; their own edges belong to the neighbouring
+// sub-block or chunk, so each quad is emitted exactly once.
+void surface_nets_mesh(const uint8_t* samples, const glm::ivec3& origin, const glm::ivec3& lo, const glm::ivec3& hi,
+                       std::vector<Vertex>& verts, std::vector<uint32_t>& indices) {
+    constexpr int MAX_CELLS = CHUNK_SIZE + 1;
+    const int CELLS = hi.x - lo.x + 1; // cells lo - 1 .. hi - 1 per row
+    const std::array<SurfaceNetCase, 256>& cases = surface_net_cases();
+    const float thickness = 0.06f;
+    uint8_t bits[2][MAX_CELLS * MAX_CELLS]; // corner bits 0-3 of the cells above a sample slice
+    uint32_t cell_vertex[2][MAX_CELLS * MAX_CELLS];
+    auto slice_bits = [&](int z, uint8_t* out) {
+        for (int y = lo.y - 1; y < hi.y; ++y) {
+            const uint8_t* row = samples + apron_index(lo.x - 1, y, z);
+            const uint8_t* next = row + APRON_SIZE;
+            uint8_t* o = out + (y - lo.y + 1) * CELLS;
+            for (int x = 0; x < CELLS; ++x)
+                o[x] = row[x] | (row[x + 1] << 1) | (next[x + 1] << 2) | (next[x] << 3);
+        }
+    };
+    auto quad = [&](bool solid_below, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        if (solid_below) { uint32_t q[6] = { a, b, c, c, d, a }; indices.insert(indices.end(), q, q + 6); }
+        else { uint32_t q[6] = { a, d, c, c, b, a }; indices.insert(indices.end(), q, q + 6); }
+    };
+
+    slice_bits(lo.z - 1, bits[0]);
+    for (int z = lo.z - 1; z < hi.z; ++z) {
+        int slice = z - lo.z + 1;
+        const uint8_t* lower = bits[slice & 1];
+        uint8_t* upper = bits[(slice + 1) & 1];
+        slice_bits(z + 1, upper);
+        uint32_t* cur = cell_vertex[slice & 1];
+        const uint32_t* prev = cell_vertex[(slice + 1) & 1];
+        for (int y = lo.y - 1; y < hi.y; ++y) {
+            for (int x = lo.x - 1; x < hi.x; ++x) {
+                int i = (y - lo.y + 1) * CELLS + (x - lo.x + 1);
+                int mask = lower[i] | (upper[i] << 4);
+                if (mask == 0 || mask == 255)
+                    continue;
+                cur[i] = static_cast<uint32_t>(verts.size());
+                const SurfaceNetCase& c = cases[mask];
+                verts.push_back({ glm::vec3(origin + glm::ivec3(x, y, z)) + c.offset, c.normal, thickness });
+                if (x < lo.x || y < lo.y || z < lo.z)
+                    continue;
+                // Edges leaving the cell's minimum corner along +x, +y and +z.
+                bool solid = mask & 1;
+                if (solid != bool(mask & 2))
+                    quad(solid, cur[i], cur[i - CELLS], prev[i - CELLS], prev[i]);
+                if (solid != bool(mask & 8))
+                    quad(solid, cur[i], prev[i], prev[i - 1], cur[i - 1]);
+                if (solid != bool(mask & 16))
+                    quad(solid, cur[i], cur[i - 1], cur[i - CELLS - 1], cur[i - CELLS]);
+            }
+        }
+    }
+}
+
 int SW = 800, SH = 600;
 float dt = 0, lastT = 0, yaw = -90, pitch = 0, lastX = 400, lastY = 300;
 bool onGround = true, firstMouse = true;
@@ -313,49 +453,664 @@ void crosshair() {
 }
 
 std::unordered_map<ChunkKey, Chunk> chunks;
+std::vector<std::pair<GLuint, GLuint>> spare_buffers; // VBO/EBO of unloaded chunks, reused by the next upload
+
+// Copies the chunk's voxels and the apron from whichever of its 26 neighbours
+// are generated; missing neighbours read as air, like VoxelGrid::get outside a grid.
+void gather_mesh_samples(const ChunkKey& key, uint8_t* samples) {
+    std::memset(samples, 0, APRON_VOLUME);
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                auto it = chunks.find(ChunkKey{ key.x + dx, key.y + dy, key.z + dz });
+                if (it == chunks.end() || !it->second.generated) continue;
+                const VoxelGrid& g = it->second.voxels;
+                // Local range this neighbour covers: just the apron layer, or the chunk itself.
+                int x0 = dx < 0 ? -1 : dx == 0 ? 0 : CHUNK_SIZE, x1 = dx < 0 ? 0 : dx == 0 ? CHUNK_SIZE : CHUNK_SIZE + 1;
+                int y0 = dy < 0 ? -1 : dy == 0 ? 0 : CHUNK_SIZE, y1 = dy < 0 ? 0 : dy == 0 ? CHUNK_SIZE : CHUNK_SIZE + 1;
+                int z0 = dz < 0 ? -1 : dz == 0 ? 0 : CHUNK_SIZE, z1 = dz < 0 ? 0 : dz == 0 ? CHUNK_SIZE : CHUNK_SIZE + 1;
+                int ox = key.x * CHUNK_SIZE, oy = key.y * CHUNK_SIZE, oz = key.z * CHUNK_SIZE;
+                for (int z = z0; z < z1; ++z)
+                    for (int y = y0; y < y1; ++y)
+                        for (int x = x0; x < x1; ++x)
+                            samples[apron_index(x, y, z)] = g.data[g.idx(ox + x, oy + y, oz + z)] == SOLID;
+            }
+}
+
+struct SubMesh {
+    std::vector<Vertex> verts;
+    std::vector<uint32_t> indices; // relative to the sub-block's first vertex
+};
+
+// Meshes the sub-blocks set in `mask` from the chunk's apron samples.
+void mesh_sub_blocks(const uint8_t* samples, const ChunkKey& key, uint64_t mask, std::array<SubMesh, SUB_COUNT>& out) {
+    glm::ivec3 origin = glm::ivec3(key.x, key.y, key.z) * CHUNK_SIZE;
+    for (int s = 0; s < SUB_COUNT; ++s) {
+        if (!((mask >> s) & 1)) continue;
+        glm::ivec3 lo = glm::ivec3(s % SUBS_PER_AXIS, (s / SUBS_PER_AXIS) % SUBS_PER_AXIS, s / (SUBS_PER_AXIS * SUBS_PER_AXIS)) * SUB_SIZE;
+        out[s].verts.clear();
+        out[s].indices.clear();
+        surface_nets_mesh(samples, origin, lo, lo + glm::ivec3(SUB_SIZE), out[s].verts, out[s].indices);
+    }
+}
+
+// Same, from freshly gathered samples (main thread).
+void mesh_sub_blocks(const ChunkKey& key, uint64_t mask, std::array<SubMesh, SUB_COUNT>& out) {
+    static uint8_t samples[APRON_VOLUME];
+    gather_mesh_samples(key, samples);
+    mesh_sub_blocks(samples, key, mask, out);
+}
+
+void update_draw_ranges(Chunk& chunk) {
+    chunk.draw_ranges = 0;
+    chunk.index_count = 0;
+    for (const SubMeshSlot& slot : chunk.subs) {
+        if (slot.index_count == 0) continue;
+        chunk.draw_counts[chunk.draw_ranges] = (GLsizei)slot.index_count;
+        chunk.draw_offsets[chunk.draw_ranges] = (const void*)(uintptr_t(slot.index_offset) * sizeof(uint32_t));
+        chunk.draw_ranges++;
+        chunk.index_count += slot.index_count;
+    }
+}
+
+// Copies one sub-block into its slot of the bound buffers, rebasing its
+// indices onto the slot's first vertex.
+void write_slot(SubMeshSlot& slot, SubMesh& mesh) {
+    for (uint32_t& i : mesh.indices) i += slot.vert_offset;
+    glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * slot.vert_offset, sizeof(Vertex) * mesh.verts.size(), mesh.verts.data());
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * slot.index_offset, sizeof(uint32_t) * mesh.indices.size(), mesh.indices.data());
+    slot.index_count = (uint32_t)mesh.indices.size();
+}
+
+// Lays every sub-block out in a fresh slot with half again its size spare and
+// uploads the whole chunk.
+void upload_chunk_mesh(Chunk& chunk, std::array<SubMesh, SUB_COUNT>& meshes) {
+    const uint32_t MIN_SLACK = 64;
+    uint32_t verts = 0, indices = 0;
+    for (int s = 0; s < SUB_COUNT; ++s) {
+        SubMeshSlot& slot = chunk.subs[s];
+        uint32_t n = (uint32_t)meshes[s].verts.size(), m = (uint32_t)meshes[s].indices.size();
+        slot.vert_offset = verts;
+        slot.vert_capacity = n + n / 2 + MIN_SLACK;
+        slot.index_offset = indices;
+        slot.index_capacity = m + m / 2 + MIN_SLACK * 3;
+        verts += slot.vert_capacity;
+        indices += slot.index_capacity;
+    }
+    if (chunk.vbo == 0 && !spare_buffers.empty()) {
+        chunk.vbo = spare_buffers.back().first;
+        chunk.ebo = spare_buffers.back().second;
+        spare_buffers.pop_back();
+    }
+    if (chunk.vbo == 0) glGenBuffers(1, &chunk.vbo);
+    if (chunk.ebo == 0) glGenBuffers(1, &chunk.ebo);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * verts, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indices, nullptr, GL_DYNAMIC_DRAW);
+    for (int s = 0; s < SUB_COUNT; ++s)
+        write_slot(chunk.subs[s], meshes[s]);
+    update_draw_ranges(chunk);
+}
 
+// Rewrites just the sub-blocks in `mask` inside their slots. Returns false,
+// leaving the buffers alone, if one of them has outgrown its slot.
+bool patch_chunk_mesh(Chunk& chunk, uint64_t mask, std::array<SubMesh, SUB_COUNT>& meshes) {
+    for (int s = 0; s < SUB_COUNT; ++s)
+        if (((mask >> s) & 1) && (meshes[s].verts.size() > chunk.subs[s].vert_capacity ||
+                                  meshes[s].indices.size() > chunk.subs[s].index_capacity))
+            return false;
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ebo);
+    for (int s = 0; s < SUB_COUNT; ++s)
+        if ((mask >> s) & 1) write_slot(chunk.subs[s], meshes[s]);
+    update_draw_ranges(chunk);
+    return true;
+}
+
+// Patches edited sub-blocks in right away; whole-chunk meshes come from the
+// pipeline. Edits to a chunk with a mesh job out wait for that mesh, which was
+// gathered before them, and are patched on top of it.
 void update_chunk_mesh_if_dirty(Chunk& chunk) {
-    if (chunk.dirty) {
-        chunk.verts.clear();
-        surface_nets_mesh(chunk.voxels, chunk.verts); // <-- Use Surface Nets instead of greedy_mesh
-        if (chunk.vbo == 0) glGenBuffers(1, &chunk.vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * chunk.verts.size(), chunk.verts.data(), GL_STATIC_DRAW);
-        chunk.vert_count = chunk.verts.size();
-        chunk.meshed = true;
-        chunk.dirty = false;
+    static std::array<SubMesh, SUB_COUNT> meshes;
+    if (!chunk.meshed || chunk.meshing || chunk.dirty_subs == 0) return;
+    mesh_sub_blocks(chunk.key, chunk.dirty_subs, meshes);
+    if (!patch_chunk_mesh(chunk, chunk.dirty_subs, meshes)) {
+        mesh_sub_blocks(chunk.key, ALL_SUBS, meshes);
+        upload_chunk_mesh(chunk, meshes);
     }
+    chunk.dirty_subs = 0;
 }
 
+// Changing voxel s changes the corner masks of cells s - 1 .. s, and with them
+// the quads emitted by cells s - 1 .. s + 1 on each axis. Flags the sub-blocks
+// owning those cells, in this chunk and in any loaded neighbour they reach.
+void mark_voxel_dirty(const ChunkKey& key, int x, int y, int z) {
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                auto it = chunks.find(ChunkKey{ key.x + dx, key.y + dy, key.z + dz });
+                if (it == chunks.end()) continue;
+                Chunk& chunk = it->second;
+                int local[3] = { x - chunk.key.x * CHUNK_SIZE, y - chunk.key.y * CHUNK_SIZE, z - chunk.key.z * CHUNK_SIZE };
+                int lo[3], hi[3];
+                bool touched = true;
+                for (int a = 0; a < 3; ++a) {
+                    if (local[a] + 1 < 0 || local[a] - 1 >= CHUNK_SIZE) touched = false;
+                    lo[a] = std::max(local[a] - 1, 0) / SUB_SIZE;
+                    hi[a] = std::min(local[a] + 1, CHUNK_SIZE - 1) / SUB_SIZE;
+                }
+                if (!touched) continue;
+                for (int sz = lo[2]; sz <= hi[2]; ++sz)
+                    for (int sy = lo[1]; sy <= hi[1]; ++sy)
+                        for (int sx = lo[0]; sx <= hi[0]; ++sx)
+                            chunk.dirty_subs |= uint64_t(1) << sub_index(sx, sy, sz);
+            }
+}
+
+// Edits to a chunk still waiting for its voxels are dropped: the placeholder
+// reads as air, and the generated grid would replace the edit anyway.
 void set_block_in_chunk(const ChunkKey& key, int x, int y, int z, BlockType t) {
     auto it = chunks.find(key);
-    if (it == chunks.end()) return;
+    if (it == chunks.end() || !it->second.generated) return;
     it->second.voxels.set(x, y, z, t);
-    it->second.dirty = true;
+    mark_voxel_dirty(key, x, y, z);
+}
+
+inline int chunk_coord(int v) { return (v >= 0 ? v : v - CHUNK_SIZE + 1) / CHUNK_SIZE; }
+
+BlockType get_block(int x, int y, int z) {
+    auto it = chunks.find(ChunkKey{ chunk_coord(x), chunk_coord(y), chunk_coord(z) });
+    return it == chunks.end() ? AIR : it->second.voxels.get(x, y, z);
+}
+
+void set_block(int x, int y, int z, BlockType t) {
+    set_block_in_chunk(ChunkKey{ chunk_coord(x), chunk_coord(y), chunk_coord(z) }, x, y, z, t);
+}
+
+// Steps voxel by voxel along the ray (voxel v spans v - 0.5 .. v + 0.5) and
+// returns the first solid one within reach, with the voxel entered just before it.
+bool raycast_block(const glm::vec3& from, const glm::vec3& dir, float reach, glm::ivec3& hit, glm::ivec3& before) {
+    glm::vec3 o = from + glm::vec3(0.5f);
+    glm::ivec3 v(int(floor(o.x)), int(floor(o.y)), int(floor(o.z)));
+    int step[3];
+    float t_max[3], t_delta[3];
+    for (int a = 0; a < 3; ++a) {
+        step[a] = dir[a] > 0 ? 1 : -1;
+        t_delta[a] = dir[a] != 0 ? std::abs(1.0f / dir[a]) : 1e30f;
+        float edge = dir[a] > 0 ? float(v[a] + 1) - o[a] : o[a] - float(v[a]);
+        t_max[a] = dir[a] != 0 ? edge * t_delta[a] : 1e30f;
+    }
+    before = v;
+    for (float t = 0; t <= reach;) {
+        if (get_block(v.x, v.y, v.z) == SOLID) { hit = v; return true; }
+        before = v;
+        int a = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2) : (t_max[1] < t_max[2] ? 1 : 2);
+        v[a] += step[a];
+        t = t_max[a];
+        t_max[a] += t_delta[a];
+    }
+    return false;
+}
+
+// Left mouse digs, right mouse fills, one voxel per frame while held.
+bool sculpt(GLFWwindow* w, const glm::vec3& dir) {
+    bool dig = glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    bool fill = glfwGetMouseButton(w, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+    glm::ivec3 hit, before;
+    if ((!dig && !fill) || !raycast_block(cam, dir, 8.0f, hit, before)) return false;
+    if (dig) set_block(hit.x, hit.y, hit.z, AIR);
+    else set_block(before.x, before.y, before.z, SOLID);
+    return true;
+}
+
+// Neighbours meshed so far saw air where this chunk is.
+void mark_neighbours_dirty(const ChunkKey& key) {
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                auto it = chunks.find(ChunkKey{ key.x + dx, key.y + dy, key.z + dz });
+                if (it != chunks.end()) it->second.dirty = true;
+            }
 }
 
+// Generates a chunk on the calling thread (--bench-mesh).
 void load_chunk(const ChunkKey& key) {
     if (chunks.count(key)) return;
     Chunk chunk(key);
     generate_terrain_grid(chunk.voxels);
+    chunk.generated = true;
     chunk.dirty = true;
     chunks[key] = std::move(chunk);
+    mark_neighbours_dirty(key);
 }
 
+// Buffers are parked in spare_buffers rather than deleted; jobs still in the
+// pipeline for these chunks are dropped when they come back.
 void unload_far_chunks(const glm::ivec3& player_chunk) {
-    std::vector<ChunkKey> to_remove;
-    for (const auto& [key, chunk] : chunks) {
+    for (auto it = chunks.begin(); it != chunks.end();) {
+        const ChunkKey& key = it->first;
         if (std::abs(key.x - player_chunk.x) > RENDER_DIST ||
             std::abs(key.y - player_chunk.y) > 1 ||
             std::abs(key.z - player_chunk.z) > RENDER_DIST) {
-            glDeleteBuffers(1, &chunk.vbo);
-            to_remove.push_back(key);
+            if (it->second.vbo != 0) spare_buffers.emplace_back(it->second.vbo, it->second.ebo);
+            it = chunks.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+// --- CHUNK PIPELINE ---
+// Chunks pass through three stages: workers generate the voxels, workers mesh
+// a chunk from an apron snapshot once its loaded neighbours are generated, and
+// the main thread uploads finished meshes within a per-frame time budget. Jobs
+// are heap objects handed between stages through lock-free queues, and
+// whoever popped a job owns it; `chunks` itself is only touched by the main
+// thread.
+constexpr size_t PIPELINE_QUEUE_SIZE = 1024; // also caps the jobs in flight per stage
+constexpr double UPLOAD_BUDGET_MS = 2.0;
+bool gpu_upload = true; // off in --bench-pipeline, where an upload only marks the chunk meshed
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Each cell carries a
+// sequence number saying whether it is ready to be written or read at the
+// current lap, so push and pop each cost one CAS on the shared index.
+template <typename T, size_t N>
+class MpmcQueue {
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+    Cell cells[N];
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+public:
+    MpmcQueue() : head(0), tail(0) {
+        for (size_t i = 0; i < N; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    bool push(const T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (N - 1)];
+            intptr_t diff = intptr_t(cell.seq.load(std::memory_order_acquire)) - intptr_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+    bool pop(T& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (N - 1)];
+            intptr_t diff = intptr_t(cell.seq.load(std::memory_order_acquire)) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // empty
+            else
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+struct GenJob {
+    ChunkKey key;
+    uint32_t ticket;
+    VoxelGrid voxels;
+};
+
+struct MeshJob {
+    ChunkKey key;
+    uint32_t ticket;
+    uint8_t samples[APRON_VOLUME];
+    std::array<SubMesh, SUB_COUNT> meshes;
+};
+
+struct ChunkPipeline {
+    MpmcQueue<GenJob*, PIPELINE_QUEUE_SIZE> gen_jobs, gen_done;
+    MpmcQueue<MeshJob*, PIPELINE_QUEUE_SIZE> mesh_jobs, mesh_done;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping{ false };
+    // Idle workers park on work_ready. pending counts queued jobs not yet
+    // popped and parked the workers asleep, so submit() only takes the mutex
+    // when someone actually needs waking.
+    std::mutex park_mutex;
+    std::condition_variable work_ready;
+    std::atomic<int> pending{ 0 }, parked{ 0 };
+    // Main thread only.
+    std::vector<MeshJob*> spare_mesh_jobs; // kept so their mesh vectors keep their capacity
+    size_t gens_in_flight = 0, meshes_in_flight = 0;
+    uint32_t next_ticket = 1;
+
+    void start(int count) {
+        stopping.store(false);
+        for (int i = 0; i < count; ++i)
+            workers.emplace_back(&ChunkPipeline::worker_loop, this);
+    }
+
+    void stop() {
+        stopping.store(true);
+        {
+            std::lock_guard<std::mutex> lock(park_mutex);
+            work_ready.notify_all();
+        }
+        for (std::thread& t : workers) t.join();
+        workers.clear();
+        GenJob* gen;
+        while (gen_jobs.pop(gen) || gen_done.pop(gen)) delete gen;
+        MeshJob* mesh;
+        while (mesh_jobs.pop(mesh) || mesh_done.pop(mesh)) spare_mesh_jobs.push_back(mesh);
+        gens_in_flight = meshes_in_flight = 0;
+        pending.store(0);
+    }
+
+    // Main thread: queues a job for the workers and wakes one if any are
+    // parked. Returns false, leaving the job with the caller, if the queue is full.
+    template <typename Job>
+    bool submit(MpmcQueue<Job*, PIPELINE_QUEUE_SIZE>& queue, Job* job) {
+        if (!queue.push(job)) return false;
+        pending.fetch_add(1);
+        if (parked.load() > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex);
+            work_ready.notify_one();
+        }
+        return true;
+    }
+
+    // A worker that found nothing to do for a while sleeps until submit() or
+    // stop(). parked is raised before pending is checked, and submit() raises
+    // pending before checking parked, so one of the two always sees the other.
+    void park() {
+        std::unique_lock<std::mutex> lock(park_mutex);
+        parked.fetch_add(1);
+        work_ready.wait(lock, [this] { return stopping.load() || pending.load() > 0; });
+        parked.fetch_sub(1);
+    }
+
+    // Meshing first, so chunks already generated are finished before new ones
+    // are started. The done queues have room for every job in flight, so a
+    // finished job is only ever retried, never dropped.
+    void worker_loop() {
+        int idle = 0;
+        while (!stopping.load(std::memory_order_relaxed)) {
+            MeshJob* mesh;
+            GenJob* gen;
+            if (mesh_jobs.pop(mesh)) {
+                pending.fetch_sub(1);
+                mesh_sub_blocks(mesh->samples, mesh->key, ALL_SUBS, mesh->meshes);
+                while (!mesh_done.push(mesh)) std::this_thread::yield();
+                idle = 0;
+            }
+            else if (gen_jobs.pop(gen)) {
+                pending.fetch_sub(1);
+                generate_terrain_grid(gen->voxels);
+                while (!gen_done.push(gen)) std::this_thread::yield();
+                idle = 0;
+            }
+            else if (++idle < 64)
+                std::this_thread::yield();
+            else {
+                park();
+                idle = 0;
+            }
+        }
+    }
+};
+
+ChunkPipeline pipeline;
+
+// Adds a placeholder for the chunk and queues its generation. If the queue is
+// full the placeholder is dropped again so a later frame can retry.
+void request_chunk(const ChunkKey& key) {
+    if (chunks.count(key) || pipeline.gens_in_flight >= PIPELINE_QUEUE_SIZE) return;
+    Chunk& chunk = chunks[key];
+    chunk.key = key;
+    chunk.ticket = pipeline.next_ticket++;
+    GenJob* job = new GenJob{ key, chunk.ticket,
+        VoxelGrid(key.x * CHUNK_SIZE, key.x * CHUNK_SIZE + CHUNK_SIZE - 1,
+                  key.y * CHUNK_SIZE, key.y * CHUNK_SIZE + CHUNK_SIZE - 1,
+                  key.z * CHUNK_SIZE, key.z * CHUNK_SIZE + CHUNK_SIZE - 1) };
+    if (!pipeline.submit(pipeline.gen_jobs, job)) {
+        delete job;
+        chunks.erase(key);
+        return;
+    }
+    pipeline.gens_in_flight++;
+}
+
+bool neighbours_generated(const ChunkKey& key) {
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                auto it = chunks.find(ChunkKey{ key.x + dx, key.y + dy, key.z + dz });
+                if (it != chunks.end() && !it->second.generated) return false;
+            }
+    return true;
+}
+
+// The main thread's side of the pipeline, once per frame: takes in generated
+// voxels, sends dirty chunks whose neighbours are ready to be meshed, and
+// uploads finished meshes until the budget is spent. Returns the chunks uploaded.
+int pump_chunk_pipeline(double budget_ms) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    GenJob* gen;
+    while (pipeline.gen_done.pop(gen)) {
+        pipeline.gens_in_flight--;
+        auto it = chunks.find(gen->key);
+        if (it != chunks.end() && it->second.ticket == gen->ticket) {
+            it->second.voxels = std::move(gen->voxels);
+            it->second.generated = true;
+            mark_neighbours_dirty(gen->key);
+        }
+        delete gen;
+    }
+
+    for (auto& [key, chunk] : chunks) {
+        if (!chunk.dirty || !chunk.generated || chunk.meshing || pipeline.meshes_in_flight >= PIPELINE_QUEUE_SIZE)
+            continue;
+        if (!neighbours_generated(key)) continue;
+        MeshJob* job;
+        if (pipeline.spare_mesh_jobs.empty()) job = new MeshJob;
+        else { job = pipeline.spare_mesh_jobs.back(); pipeline.spare_mesh_jobs.pop_back(); }
+        job->key = key;
+        job->ticket = chunk.ticket;
+        gather_mesh_samples(key, job->samples);
+        if (!pipeline.submit(pipeline.mesh_jobs, job)) {
+            // Stays dirty and not meshing, so it is sent again next frame.
+            pipeline.spare_mesh_jobs.push_back(job);
+            break;
+        }
+        pipeline.meshes_in_flight++;
+        chunk.meshing = true;
+        chunk.dirty = false;
+    }
+
+    int uploaded = 0;
+    MeshJob* mesh;
+    while (std::chrono::duration<double, std::milli>(Clock::now() - start).count() < budget_ms &&
+           pipeline.mesh_done.pop(mesh)) {
+        pipeline.meshes_in_flight--;
+        auto it = chunks.find(mesh->key);
+        if (it != chunks.end() && it->second.ticket == mesh->ticket) {
+            Chunk& chunk = it->second;
+            chunk.meshing = false;
+            if (gpu_upload) upload_chunk_mesh(chunk, mesh->meshes);
+            chunk.meshed = true;
+            if (gpu_upload) update_chunk_mesh_if_dirty(chunk);
+            uploaded++;
+        }
+        pipeline.spare_mesh_jobs.push_back(mesh);
+    }
+    return uploaded;
+}
+
+// --bench-mesh: both meshers over the same 8x8 patch of terrain chunks
+// (loaded with a ring of neighbours so every apron is real), then the CPU side
+// of single-voxel edits, no window needed.
+void benchmark_meshers() {
+    const int PATCH = 8, REPEAT = 20;
+    init_perlin(1337);
+    for (int x = -1; x <= PATCH; ++x)
+        for (int z = -1; z <= PATCH; ++z)
+            load_chunk(ChunkKey{ x, 0, z });
+    typedef std::chrono::steady_clock Clock;
+    const double cells = double(PATCH) * PATCH * REPEAT * CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+    size_t ref_verts = 0, new_verts = 0, new_indices = 0;
+
+    std::vector<Vertex> verts;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < REPEAT; ++r)
+        for (int x = 0; x < PATCH; ++x)
+            for (int z = 0; z < PATCH; ++z) {
+                verts.clear();
+                surface_nets_mesh_reference(chunks[ChunkKey{ x, 0, z }].voxels, verts);
+                if (r == 0) ref_verts += verts.size();
+            }
+    double ref_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    static std::array<SubMesh, SUB_COUNT> meshes;
+    start = Clock::now();
+    for (int r = 0; r < REPEAT; ++r)
+        for (int x = 0; x < PATCH; ++x)
+            for (int z = 0; z < PATCH; ++z) {
+                mesh_sub_blocks(ChunkKey{ x, 0, z }, ALL_SUBS, meshes);
+                if (r == 0)
+                    for (const SubMesh& m : meshes) { new_verts += m.verts.size(); new_indices += m.indices.size(); }
+            }
+    double new_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "Meshing " << PATCH * PATCH << " chunks x " << REPEAT << ":\n"
+              << "  reference: " << cells / ref_seconds / 1e6 << " M cells/s, " << ref_verts << " vertices ("
+              << ref_verts / 3 << " triangles, " << ref_verts * sizeof(Vertex) / 1024 << " KiB)\n"
+              << "  indexed:   " << cells / new_seconds / 1e6 << " M cells/s (apron gather included), " << new_verts << " vertices + "
+              << new_indices << " indices (" << new_indices / 3 << " triangles, "
+              << (new_verts * sizeof(Vertex) + new_indices * sizeof(uint32_t)) / 1024 << " KiB)\n";
+
+    // Edits: dig out and refill the top voxel of random columns, remeshing
+    // after each edit either the dirty sub-blocks or every chunk they are in.
+    const int EDITS = 2000;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> column(0, PATCH * CHUNK_SIZE - 1);
+    std::vector<glm::ivec3> targets;
+    while ((int)targets.size() < EDITS) {
+        int x = column(rng), z = column(rng);
+        for (int y = CHUNK_SIZE - 1; y >= 0; --y)
+            if (get_block(x, y, z) == SOLID) { targets.push_back(glm::ivec3(x, y, z)); break; }
+    }
+    for (int full = 0; full < 2; ++full) {
+        std::vector<double> latency;
+        size_t remeshed = 0, bytes = 0;
+        for (int e = 0; e < EDITS; ++e) {
+            const glm::ivec3& v = targets[e / 2];
+            Clock::time_point t0 = Clock::now();
+            set_block(v.x, v.y, v.z, e % 2 ? SOLID : AIR);
+            ChunkKey key{ chunk_coord(v.x), 0, chunk_coord(v.z) };
+            for (int dz = -1; dz <= 1; ++dz)
+                for (int dx = -1; dx <= 1; ++dx) {
+                    Chunk& chunk = chunks[ChunkKey{ key.x + dx, 0, key.z + dz }];
+                    if (chunk.dirty_subs == 0) continue;
+                    uint64_t mask = full ? ALL_SUBS : chunk.dirty_subs;
+                    mesh_sub_blocks(chunk.key, mask, meshes);
+                    for (int s = 0; s < SUB_COUNT; ++s)
+                        if ((mask >> s) & 1) {
+                            remeshed++;
+                            bytes += meshes[s].verts.size() * sizeof(Vertex) + meshes[s].indices.size() * sizeof(uint32_t);
+                        }
+                    chunk.dirty_subs = 0;
+                }
+            latency.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
         }
+        std::sort(latency.begin(), latency.end());
+        double mean = 0;
+        for (double l : latency) mean += l;
+        mean /= latency.size();
+        std::cout << (full ? "  edit, whole chunks: " : "  edit, sub-blocks:   ") << mean << " us mean, "
+                  << latency[latency.size() * 99 / 100] << " us p99, " << latency.back() << " us max, "
+                  << double(remeshed) / EDITS << " " << SUB_SIZE << "^3 sub-blocks and "
+                  << bytes / EDITS / 1024.0 << " KiB to upload per edit\n";
     }
-    for (const auto& key : to_remove) chunks.erase(key);
 }
 
-int main() {
+// Requests the chunks within RENDER_DIST (or `radius`) of the player, nearest ring first.
+void request_chunks_around(const glm::ivec3& player_chunk, int radius = RENDER_DIST) {
+    for (int r = 0; r <= radius; ++r)
+        for (int dx = -r; dx <= r; ++dx)
+            for (int dz = -r; dz <= r; ++dz)
+                if (std::max(std::abs(dx), std::abs(dz)) == r)
+                    request_chunk(ChunkKey{ player_chunk.x + dx, player_chunk.y, player_chunk.z + dz });
+}
+
+// --bench-pipeline: loads a 17x17 chunk area from nothing, first generating and
+// meshing on the main thread as before, then through the pipeline with 1, 2, 4
+// and 8 workers. The main thread pumps once per millisecond; with no window,
+// uploads only hand the meshes over.
+void benchmark_pipeline() {
+    const int RADIUS = 8, SIDE = 2 * RADIUS + 1, COUNT = SIDE * SIDE;
+    typedef std::chrono::steady_clock Clock;
+    init_perlin(1337);
+    gpu_upload = false;
+
+    static std::array<SubMesh, SUB_COUNT> meshes;
+    Clock::time_point start = Clock::now();
+    for (int x = -RADIUS; x <= RADIUS; ++x)
+        for (int z = -RADIUS; z <= RADIUS; ++z)
+            load_chunk(ChunkKey{ x, 0, z });
+    for (auto& [key, chunk] : chunks)
+        mesh_sub_blocks(key, ALL_SUBS, meshes);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Loading " << COUNT << " chunks (" << std::thread::hardware_concurrency() << " hardware threads):\n"
+              << "  main thread: " << COUNT / seconds << " chunks/s\n";
+    chunks.clear();
+
+    for (int workers : { 1, 2, 4, 8 }) {
+        pipeline.start(workers);
+        double main_ms = 0;
+        int meshed = 0, uploads = 0;
+        start = Clock::now();
+        while (meshed < COUNT) {
+            Clock::time_point frame = Clock::now();
+            request_chunks_around(glm::ivec3(0), RADIUS);
+            uploads += pump_chunk_pipeline(UPLOAD_BUDGET_MS);
+            main_ms += std::chrono::duration<double, std::milli>(Clock::now() - frame).count();
+            meshed = 0;
+            for (const auto& [key, chunk] : chunks)
+                meshed += chunk.meshed && !chunk.meshing && !chunk.dirty;
+            if (meshed < COUNT) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        pipeline.stop();
+        std::cout << "  " << workers << " worker" << (workers > 1 ? "s: " : ":  ") << COUNT / seconds << " chunks/s, "
+                  << double(uploads) / COUNT << " meshes per chunk, main thread " << main_ms * 1000.0 / COUNT << " us per chunk\n";
+        chunks.clear();
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench-mesh") == 0) {
+        benchmark_meshers();
+        return 0;
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-pipeline") == 0) {
+        benchmark_pipeline();
+        return 0;
+    }
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -381,6 +1136,7 @@ int main() {
     glGenVertexArrays(1, &vao);
 
     init_perlin(1337);
+    pipeline.start(std::max(1, int(std::thread::hardware_concurrency()) - 1));
 
     int chunk_y = 0;
 
@@ -413,26 +1169,34 @@ int main() {
             int(floor(cam.z / float(CHUNK_SIZE)))
         );
 
-        for (int dx = -RENDER_DIST; dx <= RENDER_DIST; ++dx)
-            for (int dz = -RENDER_DIST; dz <= RENDER_DIST; ++dz) {
-                ChunkKey key{ player_chunk.x + dx, chunk_y, player_chunk.z + dz };
-                load_chunk(key);
-            }
+        request_chunks_around(player_chunk);
         unload_far_chunks(player_chunk);
+        pump_chunk_pipeline(UPLOAD_BUDGET_MS);
 
         glBindVertexArray(vao);
         glUseProgram(prog);
         glUniformMatrix4fv(glGetUniformLocation(prog, "view"), 1, 0, glm::value_ptr(V));
         glUniformMatrix4fv(glGetUniformLocation(prog, "proj"), 1, 0, glm::value_ptr(P));
 
-        for (auto& [key, chunk] : chunks) {
+        bool edited = sculpt(win, dir);
+        double mesh_start = glfwGetTime();
+        for (auto& [key, chunk] : chunks)
             update_chunk_mesh_if_dirty(chunk);
-            if (!chunk.meshed || chunk.vert_count == 0) continue;
+        if (edited) {
+            double latency = (glfwGetTime() - mesh_start) * 1000.0;
+            edit_count++;
+            edit_ms_total += latency;
+            edit_ms_max = std::max(edit_ms_max, latency);
+        }
+
+        for (auto& [key, chunk] : chunks) {
+            if (!chunk.meshed || chunk.index_count == 0) continue;
             glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk.ebo);
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0); glEnableVertexAttribArray(0);
             glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 3)); glEnableVertexAttribArray(1);
             glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(float) * 6)); glEnableVertexAttribArray(2);
-            glDrawArrays(GL_TRIANGLES, 0, chunk.vert_count);
+            glMultiDrawElements(GL_TRIANGLES, chunk.draw_counts.data(), GL_UNSIGNED_INT, chunk.draw_offsets.data(), chunk.draw_ranges);
         }
 
         crosshair();
@@ -443,12 +1207,19 @@ int main() {
         fps_frames++;
         double current_time = glfwGetTime();
         if (current_time - fps_last_time >= 1.0) {
-            std::cout << "FPS: " << fps_frames << std::endl;
+            std::cout << "FPS: " << fps_frames;
+            if (edit_count > 0)
+                std::cout << " | edits: " << edit_count << ", remesh + upload " << edit_ms_total / edit_count
+                          << " ms avg, " << edit_ms_max << " ms max";
+            std::cout << std::endl;
             fps_frames = 0;
+            edit_count = 0;
+            edit_ms_total = edit_ms_max = 0.0;
             fps_last_time = current_time;
         }
         // --- END FPS Meter Update ---
     }
+    pipeline.stop();
     glfwTerminate();
     return 0;
 }